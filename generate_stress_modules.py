@@ -0,0 +1,512 @@
+#!/usr/bin/env python3
+"""
+Generate synthetic stress-test modules for TrackMeister.
+
+This writes a set of valid, but deliberately extreme, MOD, XM and IT files
+into a directory, without requiring any network access: high channel counts,
+256-row patterns where every cell is filled with notes and effects,
+hundreds of samples and instruments with long names, and long song messages.
+The output is fully deterministic for a given random seed, so it can be used
+as a benchmark corpus (e.g. for tm_bench) on machines without internet access.
+
+Channel counts are limited by what the individual formats can store:
+MOD files can have up to 32 channels, XM files up to 32, and IT files up to
+64; larger requested channel counts are clamped accordingly (with a warning,
+as this means that e.g. the default 128 and 256 channel counts are *not*
+actually covered by any file). MOD channel counts are rounded up to an even
+number of at least 4. Likewise, XM and
+IT patterns can't be larger than 64 KiB, so very wide patterns get fewer rows.
+
+An additional IT file uses the "continue" new note action and looped samples
+for all instruments, so old notes keep playing in background voices until
+the mixer runs out of voices; this is the worst case for mixing performance.
+
+If the 'oggenc' tool is available, additional XM files with Ogg Vorbis
+compressed samples (in the OggMod format) are written, too.
+"""
+import argparse
+import math
+import os
+import random
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+
+FORMAT_MAX_CHANNELS = { 'mod': 32, 'xm': 32, 'it': 64 }
+DEFAULT_CHANNELS = [4, 8, 16, 32, 64, 128, 256]
+
+# Amiga periods for octaves 1 to 3 (C-1 to B-3), finetune 0
+MOD_PERIODS = [
+    856, 808, 762, 720, 678, 640, 604, 570, 538, 508, 480, 453,
+    428, 404, 381, 360, 340, 320, 302, 285, 269, 254, 240, 226,
+    214, 202, 190, 180, 170, 160, 151, 143, 135, 127, 120, 113,
+]
+
+WORDS = """
+    lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod
+    tempor incididunt ut labore et dolore magna aliqua greetings fly out to
+    all the sceners at the party place tracked music competition amiga
+    protracker fasttracker impulse tracker sample instrument pattern order
+""".split()
+
+
+###############################################################################
+
+class StressGenerator:
+    def __init__(self, seed, verbose=True):
+        self.seed = seed
+        self.verbose = verbose
+
+    def rng(self, *salt):
+        "get a deterministic PRNG for a specific purpose"
+        return random.Random(f"{self.seed}:" + ":".join(map(str, salt)))
+
+    @staticmethod
+    def fixstr(s, size):
+        "encode a string into a fixed-size, zero-padded byte field"
+        return s.encode('latin-1', 'replace')[:size].ljust(size, b'\0')
+
+    def name(self, rng, size):
+        "generate a random name that fills a fixed-size field completely"
+        s = ""
+        while len(s) < size:
+            s += rng.choice(WORDS) + " "
+        return s[:size]
+
+    def message(self, rng, length):
+        "generate a long song message with varying line lengths"
+        lines = []
+        total = 0
+        while total < length:
+            kind = rng.random()
+            if kind < 0.1:
+                line = ""  # empty line
+            elif kind < 0.2:
+                line = "x" * rng.randint(60, 200)  # unbreakable overlong word
+            elif kind < 0.3:
+                line = " ".join(rng.choice(WORDS) for _ in range(rng.randint(30, 60)))  # very long line
+            else:
+                line = " ".join(rng.choice(WORDS) for _ in range(rng.randint(1, 12)))
+            lines.append(line)
+            total += len(line) + 1
+        return lines
+
+    def waveform(self, rng, length, bits=8):
+        "generate a deterministic test waveform as a list of signed integers"
+        peak = (1 << (bits - 1)) - 1
+        kind = rng.randrange(5)
+        period = rng.randint(16, 256)
+        out = []
+        for i in range(length):
+            phase = (i % period) / period
+            if kind == 0:   v = math.sin(2.0 * math.pi * phase)
+            elif kind == 1: v = 2.0 * phase - 1.0
+            elif kind == 2: v = 1.0 if phase < 0.5 else -1.0
+            elif kind == 3: v = 1.0 - 4.0 * abs(phase - 0.5)
+            else:           v = rng.uniform(-1.0, 1.0)
+            # apply a simple decay so that the samples sound like instruments
+            v *= 0.9 * (1.0 - 0.5 * i / length)
+            out.append(max(-peak - 1, min(peak, int(round(v * peak)))))
+        return out
+
+    def log(self, filename, desc):
+        if self.verbose:
+            print(f"{filename} - {desc}")
+
+    ###########################################################################
+
+    def write_mod(self, filename, channels, num_patterns):
+        rng = self.rng("mod", channels)
+        channels = min(channels, FORMAT_MAX_CHANNELS['mod'])
+        tag = { 4: b"M.K.", 6: b"6CHN", 8: b"8CHN" }.get(channels, f"{channels:02d}CH".encode())
+        num_patterns = min(num_patterns, 64)
+        data = bytearray(self.fixstr(self.name(rng, 20), 20))
+
+        # sample headers: all 31 samples are used
+        samples = []
+        for i in range(31):
+            length = rng.randint(512, 4096) & ~1
+            samples.append(self.waveform(rng, length))
+            loop = rng.random() < 0.5
+            data += self.fixstr(self.name(rng, 22), 22)
+            data += struct.pack(">HBBHH", length >> 1, rng.randrange(16), 64,
+                                (length >> 2) if loop else 0,
+                                (length >> 2) if loop else 1)
+
+        # order list: play all patterns in sequence
+        data += struct.pack("BB", num_patterns, 127)
+        data += bytes(range(num_patterns)).ljust(128, b'\0')
+        data += tag
+
+        # pattern data: 64 rows, every cell filled
+        safe_effects = [0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x9, 0xA, 0xC]
+        for pat in range(num_patterns):
+            prng = self.rng("mod", channels, "pattern", pat)
+            for row in range(64):
+                for ch in range(channels):
+                    period = prng.choice(MOD_PERIODS) if (prng.random() < 0.8) else 0
+                    smp = prng.randint(1, 31) if period else 0
+                    effect = prng.choice(safe_effects)
+                    param = prng.randrange(256)
+                    if effect == 0xC: param = prng.randrange(65)
+                    if (row == 0) and (ch == 0): effect, param = 0xF, 6  # set speed
+                    data += struct.pack(">BBBB", (smp & 0xF0) | (period >> 8), period & 0xFF,
+                                        ((smp & 0x0F) << 4) | effect, param)
+
+        # sample data (signed 8-bit)
+        for smp in samples:
+            data += struct.pack(f"{len(smp)}b", *smp)
+
+        with open(filename, 'wb') as f:
+            f.write(data)
+        self.log(filename, f"MOD, {channels} channels, {num_patterns} patterns, 31 samples")
+
+    ###########################################################################
+
+    def xm_pattern(self, prng, channels, rows, num_instruments):
+        "generate packed XM pattern data"
+        out = bytearray()
+        for row in range(rows):
+            for ch in range(channels):
+                note = prng.randint(1, 96) if (prng.random() < 0.8) else 0
+                if prng.random() < 0.02: note = 97  # key off
+                inst = prng.randint(1, num_instruments) if (note and (note < 97)) else 0
+                vol = prng.choice([0, prng.randint(0x10, 0x50), prng.randint(0x60, 0xFF)])
+                effect = prng.choice([0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xA, 0xC, 0x11, 0x14, 0x19, 0x1B, 0x1D, 0x21])
+                param = prng.randrange(256)
+                if effect == 0xC: param = prng.randrange(65)
+                fields = [(1, note), (2, inst), (4, vol), (8, effect), (16, param)]
+                mask = 0x80
+                for bit, value in fields:
+                    if value: mask |= bit
+                out.append(mask)
+                for bit, value in fields:
+                    if value: out.append(value)
+        return out
+
+    def write_xm(self, filename, channels, num_patterns, rows=256, num_instruments=128, samples_per_instrument=4, vorbis=None):
+        rng = self.rng("xm", channels)
+        channels = min(channels, FORMAT_MAX_CHANNELS['xm'])
+        num_instruments = min(num_instruments, 128)
+        samples_per_instrument = min(samples_per_instrument, 16)
+
+        # XM pattern data size is limited to 64k, so reduce the number of
+        # rows for very wide patterns if needed
+        patterns = []
+        for pat in range(num_patterns):
+            prng = self.rng("xm", channels, "pattern", pat)
+            r = rows
+            while True:
+                state = prng.getstate()
+                pdata = self.xm_pattern(prng, channels, r, num_instruments)
+                if len(pdata) < 65536: break
+                prng.setstate(state)
+                r -= 16
+            patterns.append((r, pdata))
+
+        # module header
+        data = bytearray(b"Extended Module: ")
+        data += self.fixstr(self.name(rng, 20), 20)
+        data += b"\x1a" + self.fixstr("TrackMeister stress", 20)
+        data += struct.pack("<HIHHHHHHHH", 0x0104, 276, num_patterns, 0, channels,
+                            num_patterns, num_instruments, 1, 6, 125)
+        data += bytes(range(num_patterns)).ljust(256, b'\0')
+
+        # patterns
+        for r, pdata in patterns:
+            data += struct.pack("<IBHH", 9, 0, r, len(pdata))
+            data += pdata
+
+        # instruments
+        total_samples = 0
+        for inst in range(num_instruments):
+            irng = self.rng("xm", channels, "instrument", inst)
+            data += struct.pack("<I", 263)
+            data += self.fixstr(self.name(irng, 22), 22)
+            data += struct.pack("<BH", 0, samples_per_instrument)
+            data += struct.pack("<I", 40)
+            # keymap: spread the samples over the keyboard
+            data += bytes((key * samples_per_instrument) // 96 for key in range(96))
+            # volume envelope: attack, decay, sustain; panning envelope: sweep
+            venv = [(0, 0), (4, 64), (16, 40), (64, 32), (128, 0)]
+            penv = [(0, 0), (32, 64), (64, 32)]
+            data += b"".join(struct.pack("<HH", *p) for p in venv).ljust(48, b'\0')
+            data += b"".join(struct.pack("<HH", *p) for p in penv).ljust(48, b'\0')
+            data += struct.pack("<BBBBBBBBBBBBBBH", len(venv), len(penv), 3, 0, 0, 0, 0, 2,
+                                1 | 2, 1, irng.randrange(4), irng.randrange(256), irng.randrange(16), irng.randrange(64), 256)
+            data += bytes(22)
+
+            # sample headers, followed by all the sample data
+            sdata = []
+            for s in range(samples_per_instrument):
+                length = irng.randint(256, 2048)
+                wave = self.waveform(irng, length)
+                loop = irng.random() < 0.5
+                if vorbis:
+                    raw = vorbis(wave)
+                    payload = struct.pack("<I", length) + raw
+                else:
+                    delta, prev = bytearray(), 0
+                    for v in wave:
+                        delta.append((v - prev) & 0xFF)
+                        prev = v
+                    payload = bytes(delta)
+                data += struct.pack("<IIIBbBBbB", len(payload),
+                                    (length >> 2) if loop else 0, (length >> 1) if loop else 0,
+                                    64, irng.randint(-16, 15), 1 if loop else 0,
+                                    irng.randrange(256), irng.randint(-12, 12), 0)
+                data += self.fixstr(self.name(irng, 22), 22)
+                sdata.append(payload)
+            for payload in sdata:
+                data += payload
+            total_samples += samples_per_instrument
+
+        with open(filename, 'wb') as f:
+            f.write(data)
+        self.log(filename, f"XM, {channels} channels, {num_patterns} patterns, {num_instruments} instruments, {total_samples} samples" + (", Ogg Vorbis" if vorbis else ""))
+
+    ###########################################################################
+
+    def it_pattern(self, prng, channels, rows, num_instruments):
+        "generate packed IT pattern data"
+        out = bytearray()
+        for row in range(rows):
+            for ch in range(channels):
+                note = prng.randint(0, 119) if (prng.random() < 0.8) else None
+                if prng.random() < 0.02: note = prng.choice([254, 255])  # note cut / note off
+                inst = prng.randint(1, num_instruments) if ((note is not None) and (note < 120)) else None
+                vol = prng.choice([None, prng.randint(0, 64), prng.randint(128, 192), prng.randint(65, 124)])
+                # commands A..Z, avoiding B (jump), C (break) and S (too many special cases)
+                effect = prng.choice([1, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 20, 21, 22, 23, 24, 25, 26])
+                param = prng.randrange(256)
+                if effect == 1: param = prng.randint(2, 8)      # speed
+                if effect == 20: param = prng.randint(100, 255) # tempo
+                mask = 8
+                if note is not None: mask |= 1
+                if inst is not None: mask |= 2
+                if vol is not None: mask |= 4
+                out.append((ch + 1) | 0x80)
+                out.append(mask)
+                if note is not None: out.append(note)
+                if inst is not None: out.append(inst)
+                if vol is not None: out.append(vol)
+                out += bytes((effect, param))
+            out.append(0)  # end of row
+        return out
+
+    def write_it(self, filename, channels, num_patterns, rows=256, num_instruments=200, num_samples=250, message_length=8000, stack_voices=False):
+        rng = self.rng("it", channels)
+        channels = min(channels, FORMAT_MAX_CHANNELS['it'])
+        num_instruments = min(num_instruments, 255)
+        num_samples = min(num_samples, 255)
+        message = "\r".join(self.message(rng, message_length)).encode('latin-1')[:message_length] + b'\0'
+        num_orders = num_patterns + 1
+
+        # build all the variable-size parts first
+        instruments = []
+        for inst in range(num_instruments):
+            irng = self.rng("it", channels, "instrument", inst)
+            d = bytearray(b"IMPI")
+            d += self.fixstr(f"inst{inst:03d}.iti", 12)
+            nna, dct, dca, fadeout = irng.randrange(4), irng.randrange(4), irng.randrange(3), irng.randrange(1024)
+            if stack_voices:
+                nna, dct, fadeout = 1, 0, 0  # NNA = continue, no duplicate check, no fadeout
+            d += struct.pack("<BBBBHBBBBBBHBB", 0, nna, dct, dca, fadeout, 0, 60, 128, 32 | 128, 0, 0, 0x0214, 0, 0)
+            d += self.fixstr(self.name(irng, 26), 26)
+            d += struct.pack("<BBBBH", 0, 0, 0, 0xFF, 0xFFFF)
+            # keyboard table: every note maps to some sample
+            for note in range(120):
+                d += struct.pack("BB", note, irng.randint(1, num_samples))
+            # envelopes: volume (enabled + sustain), panning, pitch
+            for kind, nodes in ((0, [(64, 0), (48, 10), (32, 40), (0, 100)]),
+                                (1, [(-32, 0), (32, 50), (0, 100)]),
+                                (2, [(0, 0), (8, 30), (-8, 60), (0, 90)])):
+                flags = 1 | (4 if kind == 0 else 0)
+                d += struct.pack("<BBBBBB", flags, len(nodes), 0, 0, 1, 1)
+                for value, tick in nodes:
+                    d += struct.pack("<bH", value, tick)
+                d += bytes(3 * (25 - len(nodes)) + 1)
+            d += bytes(4)
+            assert len(d) == 554
+            instruments.append(d)
+
+        samples = []
+        for smp in range(num_samples):
+            srng = self.rng("it", channels, "sample", smp)
+            length = srng.randint(256, 4096)
+            bits16 = srng.random() < 0.5
+            wave = self.waveform(srng, length, 16 if bits16 else 8)
+            loop = (srng.random() < 0.5) or stack_voices
+            header = bytearray(b"IMPS")
+            header += self.fixstr(f"smp{smp:03d}.its", 12)
+            header += struct.pack("<BBBB", 0, 64, 1 | (2 if bits16 else 0) | (16 if loop else 0), 64)
+            header += self.fixstr(self.name(srng, 26), 26)
+            header += struct.pack("<BB", 1, 32 | 128)
+            header += struct.pack("<IIIIII", length, length >> 2 if loop else 0, length if loop else 0,
+                                  srng.choice([8363, 22050, 44100]), 0, 0)
+            # (sample pointer and vibrato settings follow once the layout is known)
+            body = struct.pack(f"<{length}{'h' if bits16 else 'b'}", *wave)
+            samples.append((header, srng.randrange(4), body))
+
+        patterns = []
+        for pat in range(num_patterns):
+            prng = self.rng("it", channels, "pattern", pat)
+            r = rows
+            while True:
+                state = prng.getstate()
+                pdata = self.it_pattern(prng, channels, r, num_instruments)
+                if len(pdata) < 65536: break
+                prng.setstate(state)
+                r -= 16
+            patterns.append(struct.pack("<HH4x", len(pdata), r) + pdata)
+
+        # compute the file layout
+        pos = 192 + num_orders + 4 * (num_instruments + num_samples + num_patterns)
+        message_offset = pos
+        pos += len(message)
+        inst_offsets = []
+        for d in instruments:
+            inst_offsets.append(pos)
+            pos += len(d)
+        smp_offsets = []
+        for header, vib, body in samples:
+            smp_offsets.append(pos)
+            pos += 80
+        pat_offsets = []
+        for d in patterns:
+            pat_offsets.append(pos)
+            pos += len(d)
+        data_offsets = []
+        for header, vib, body in samples:
+            data_offsets.append(pos)
+            pos += len(body)
+
+        # module header
+        data = bytearray(b"IMPM")
+        data += self.fixstr(self.name(rng, 26), 26)
+        data += struct.pack("<BBHHHHHHHHBBBBBBHII", 4, 16, num_orders, num_instruments, num_samples, num_patterns,
+                            0x0214, 0x0214, 1 | 4 | 8, 1, 128, 48, 6, 125, 128, 0,
+                            len(message), message_offset, 0)
+        data += bytes((32 if (ch < channels) else (32 | 128)) for ch in range(64))
+        data += bytes((64 if (ch < channels) else 0) for ch in range(64))
+        assert len(data) == 192
+        data += bytes(range(num_patterns)) + b"\xff"
+        for offset in inst_offsets + smp_offsets + pat_offsets:
+            data += struct.pack("<I", offset)
+        data += message
+        for d in instruments:
+            data += d
+        for (header, vib, body), offset in zip(samples, data_offsets):
+            data += header + struct.pack("<IBBBB", offset, vib * 8, vib * 4, vib * 16, vib)
+        for d in patterns:
+            data += d
+        for header, vib, body in samples:
+            data += body
+        assert len(data) == pos
+
+        with open(filename, 'wb') as f:
+            f.write(data)
+        self.log(filename, f"IT, {channels} channels, {num_patterns} patterns, {num_instruments} instruments, {num_samples} samples, {len(message) - 1}-byte message" + (", stacked voices" if stack_voices else ""))
+
+
+###############################################################################
+
+def make_vorbis_encoder(oggenc):
+    "create a function that compresses a list of signed 8-bit samples into an Ogg Vorbis stream"
+    def encode(wave):
+        with tempfile.TemporaryDirectory() as tmp:
+            raw = os.path.join(tmp, "in.raw")
+            ogg = os.path.join(tmp, "out.ogg")
+            with open(raw, 'wb') as f:
+                f.write(struct.pack(f"<{len(wave)}h", *(v << 8 for v in wave)))
+            subprocess.run([oggenc, "-Q", "-r", "-B", "16", "-C", "1", "-R", "8363",
+                            "--serial", "1", "-o", ogg, raw], check=True)
+            with open(ogg, 'rb') as f:
+                return f.read()
+    return encode
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("outdir", nargs='?',
+                        default=os.path.join(os.path.dirname(sys.argv[0]), "stress"),
+                        help="output directory (default: repository's stress/ subdirectory)")
+    parser.add_argument("-c", "--channels", metavar="LIST", default=",".join(map(str, DEFAULT_CHANNELS)),
+                        help="comma-separated list of channel counts (default: %(default)s)")
+    parser.add_argument("-f", "--formats", metavar="LIST", default="mod,xm,it",
+                        help="comma-separated list of formats to generate (default: %(default)s)")
+    parser.add_argument("-p", "--patterns", metavar="N", type=int, default=16,
+                        help="number of patterns per module (default: %(default)s)")
+    parser.add_argument("-m", "--message-length", metavar="N", type=int, default=8000,
+                        help="length of the song message in IT files (default: %(default)s)")
+    parser.add_argument("-s", "--seed", type=int, default=1,
+                        help="random seed (default: %(default)s)")
+    parser.add_argument("--no-vorbis", action='store_true',
+                        help="don't generate Ogg Vorbis compressed variants, even if oggenc is available")
+    parser.add_argument("-q", "--quiet", action='store_true',
+                        help="don't print status messages")
+    args = parser.parse_args()
+
+    try:
+        channel_list = sorted(set(int(c) for c in args.channels.split(',') if c.strip()))
+    except ValueError:
+        parser.error("invalid channel list")
+    formats = [f.strip().lower() for f in args.formats.split(',') if f.strip()]
+    for fmt in formats:
+        if not(fmt in FORMAT_MAX_CHANNELS):
+            parser.error(f"unsupported format '{fmt}'")
+
+    # prepare output directory
+    outdir = os.path.normpath(os.path.abspath(args.outdir))
+    try:
+        os.makedirs(outdir, exist_ok=True)
+    except EnvironmentError as e:
+        print(f"FATAL: failed to create destination directory - {e}", file=sys.stderr)
+        sys.exit(1)
+    gen = StressGenerator(args.seed, not(args.quiet))
+
+    # generate the modules; clamped channel counts that have already been
+    # generated are skipped
+    for fmt in formats:
+        done = set()
+        clamped = [c for c in channel_list if c > FORMAT_MAX_CHANNELS[fmt]]
+        if clamped:
+            print(f"WARNING: {fmt.upper()} files can't have more than {FORMAT_MAX_CHANNELS[fmt]} channels, "
+                  f"no {fmt.upper()} files with {', '.join(map(str, clamped))} channels will be generated", file=sys.stderr)
+        for channels in channel_list:
+            channels = max(1, min(channels, FORMAT_MAX_CHANNELS[fmt]))
+            if fmt == 'mod': channels = max(4, channels + (channels & 1))
+            if channels in done: continue
+            done.add(channels)
+            filename = os.path.join(outdir, f"stress_{fmt}_{channels:03d}ch.{fmt}")
+            try:
+                if fmt == 'mod': gen.write_mod(filename, channels, args.patterns)
+                if fmt == 'xm':  gen.write_xm(filename, channels, args.patterns)
+                if fmt == 'it':  gen.write_it(filename, channels, args.patterns, message_length=args.message_length)
+            except EnvironmentError as e:
+                print(f"ERROR: failed to write '{filename}' - {e}", file=sys.stderr)
+
+    # IT variant with maximum voice stacking through new note actions
+    if 'it' in formats:
+        channels = min(max(channel_list), FORMAT_MAX_CHANNELS['it'])
+        filename = os.path.join(outdir, f"stress_it_{channels:03d}ch_nna.it")
+        try:
+            gen.write_it(filename, channels, args.patterns, message_length=args.message_length, stack_voices=True)
+        except EnvironmentError as e:
+            print(f"ERROR: failed to write '{filename}' - {e}", file=sys.stderr)
+
+    # Ogg Vorbis compressed variants
+    oggenc = None if args.no_vorbis else shutil.which("oggenc")
+    if ('xm' in formats) and not(args.no_vorbis):
+        if oggenc:
+            channels = min(max(channel_list), FORMAT_MAX_CHANNELS['xm'])
+            filename = os.path.join(outdir, f"stress_xm_{channels:03d}ch_vorbis.xm")
+            try:
+                gen.write_xm(filename, channels, args.patterns, num_instruments=32, vorbis=make_vorbis_encoder(oggenc))
+            except (EnvironmentError, subprocess.CalledProcessError) as e:
+                print(f"ERROR: failed to write '{filename}' - {e}", file=sys.stderr)
+        elif not args.quiet:
+            print("oggenc not found, skipping Ogg Vorbis compressed variants")
@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <new>
+
+#include "alloc_counter.h"
+
+#if TM_COUNT_ALLOCATIONS
+
+static thread_local uint64_t t_allocCount = 0;
+
+uint64_t AllocCounter::count() {
+    return t_allocCount;
+}
+
+// The default implementations of the nothrow forms are specified in terms
+// of these, so replacing these is sufficient. (The array forms would be, too,
+// but sanitizer runtimes replace those separately.) The over-aligned forms
+// are not replaced.
+static inline void* countedAlloc(std::size_t size) {
+    ++t_allocCount;
+    void* ptr = std::malloc(size ? size : 1u);
+    if (!ptr) { throw std::bad_alloc(); }
+    return ptr;
+}
+
+void* operator new  (std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete  (void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete  (void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void* AllocCounter::imguiAlloc(std::size_t size, void*) {
+    ++t_allocCount;
+    return std::malloc(size);
+}
+
+#else
+
+uint64_t AllocCounter::count() {
+    return 0u;
+}
+
+void* AllocCounter::imguiAlloc(std::size_t size, void*) {
+    return std::malloc(size);
+}
+
+#endif
+
+void AllocCounter::imguiFree(void* ptr, void*) {
+    std::free(ptr);
+}
@@ -0,0 +1,35 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//! Heap allocation counter for finding allocations in code paths that
+//! shall be allocation-free (like drawing a frame during steady playback).
+//!
+//! If TM_COUNT_ALLOCATIONS is nonzero (it's set for Debug builds and the
+//! headless test program), the global operator new is replaced by a version
+//! that counts all allocations per thread. ImGui is pointed to counted
+//! malloc()/free() replacements as well (see imguiAlloc()); other
+//! allocations that bypass operator new (e.g. by lodepng) are not counted.
+//! Otherwise, count() always returns zero.
+namespace AllocCounter {
+
+#ifndef TM_COUNT_ALLOCATIONS
+    #define TM_COUNT_ALLOCATIONS 0
+#endif
+
+//! whether allocation counting is compiled in
+constexpr bool Enabled = !!TM_COUNT_ALLOCATIONS;
+
+//! number of allocations the calling thread has made since it was started
+uint64_t count();
+
+//! malloc()/free() replacements for ImGui::SetAllocatorFunctions()
+//! (they only count if counting is enabled)
+void* imguiAlloc(std::size_t size, void* userData);
+void  imguiFree(void* ptr, void* userData);
+
+}  // namespace AllocCounter
@@ -0,0 +1,323 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#include <cstdint>
+#include <cstddef>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+
+#include <libopenmpt/libopenmpt.hpp>
+
+#include "util.h"
+#include "trace.h"
+#include "config.h"
+#include "pathutil.h"
+#include "modutil.h"
+#include "analysis.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// ModuleAnalysis
+
+int ModuleAnalysis::findRow(float time) const {
+    if (rows.empty()) { return -1; }
+    auto it = std::upper_bound(rows.begin(), rows.end(), time,
+        [] (float t, const RowTime& r) -> bool { return t < r.time; });
+    return std::max(0, int(it - rows.begin()) - 1);
+}
+
+size_t ModuleAnalysis::memoryUsage() const {
+    return sizeof(ModuleAnalysis)
+         + rows.capacity() * sizeof(RowTime)
+         + orderStarts.capacity() * sizeof(float)
+         + wave.capacity() * sizeof(WaveColumn);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// AnalysisStore: main thread interface
+
+void AnalysisStore::request(const std::string& path) {
+    if (path.empty()) { return; }
+    int64_t mtime = PathUtil::getFileMTime(path);
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto it = m_entries.find(path);
+    if (it != m_entries.end()) {
+        if (it->second.mtime == mtime) {
+            it->second.lastUse = ++m_useCounter;
+            return;  // already cached and up to date
+        }
+        m_bytes -= it->second.data->memoryUsage();
+        m_entries.erase(it);  // outdated -> never hand it out again
+    }
+    m_pending.assign(path);
+    if (!m_thread) {
+        m_quit = false;
+        m_thread = new std::thread(&AnalysisStore::run, this);
+    }
+    m_wakeup.notify_one();
+}
+
+std::shared_ptr<const ModuleAnalysis> AnalysisStore::get(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto it = m_entries.find(path);
+    if (it == m_entries.end()) { return nullptr; }
+    it->second.lastUse = ++m_useCounter;
+    return it->second.data;
+}
+
+std::shared_ptr<const ModuleAnalysis> AnalysisStore::wait(const std::string& path) {
+    std::unique_lock<std::mutex> lock(m_lock);
+    for (;;) {
+        auto it = m_entries.find(path);
+        bool complete = (it != m_entries.end()) && it->second.data->complete;
+        if (complete || ((m_pending != path) && (m_active != path))) {
+            if (it == m_entries.end()) { return nullptr; }
+            it->second.lastUse = ++m_useCounter;
+            return it->second.data;
+        }
+        m_finished.wait(lock);
+    }
+}
+
+int AnalysisStore::evictAllExcept(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    int count = 0;
+    for (auto it = m_entries.begin();  it != m_entries.end();) {
+        if (it->first == path) { ++it; continue; }
+        m_bytes -= it->second.data->memoryUsage();
+        it = m_entries.erase(it);
+        ++count;
+    }
+    return count;
+}
+
+size_t AnalysisStore::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_bytes;
+}
+
+void AnalysisStore::shutdown() {
+    if (!m_thread) { return; }
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_quit = true;
+        m_pending.clear();
+    }
+    m_wakeup.notify_one();
+    m_thread->join();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// AnalysisStore: worker thread
+
+// the worker plays the module at the lowest supported sample rate in 1 ms
+// chunks; this is the resolution of the time index (order start times and
+// loop points come from OpenMPT's seek simulation, and are exact)
+constexpr int sampleRate = 8000;
+constexpr int chunkSize = sampleRate / 1000;
+
+void AnalysisStore::run() {
+    Trace::setThreadName("analysis");
+    // analysis results are nice to have, but must never steal CPU time
+    // from the audio or render threads
+    #ifdef _WIN32
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+    #elif defined(__linux__)
+        setpriority(PRIO_PROCESS, 0, 10);  // on Linux, this only affects the calling thread
+    #endif
+    std::unique_lock<std::mutex> lock(m_lock);
+    for (;;) {
+        m_wakeup.wait(lock, [this] { return m_quit || !m_pending.empty(); });
+        if (m_quit) { return; }
+        m_active.swap(m_pending);
+        std::string path(m_active);
+        lock.unlock();
+
+        int64_t mtime = PathUtil::getFileMTime(path);
+        analyze(path, mtime);
+        lock.lock();
+        m_active.clear();
+        m_finished.notify_all();
+    }
+}
+
+void AnalysisStore::publish(const std::string& path, int64_t mtime, const std::shared_ptr<const ModuleAnalysis>& result) {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_entries.find(path);
+        if (it != m_entries.end()) {
+            m_bytes -= it->second.data->memoryUsage();
+            m_entries.erase(it);
+        }
+        while (m_entries.size() >= MaxEntries) {
+            auto lru = m_entries.begin();
+            for (auto i = m_entries.begin();  i != m_entries.end();  ++i) {
+                if (i->second.lastUse < lru->second.lastUse) { lru = i; }
+            }
+            m_bytes -= lru->second.data->memoryUsage();
+            m_entries.erase(lru);
+        }
+        m_bytes += result->memoryUsage();
+        m_entries[path] = Entry { mtime, ++m_useCounter, result };
+    }
+    m_generation.fetch_add(1u, std::memory_order_release);
+    Dprintf("analysis of '%s' %s: %d orders, %d rows, %.1f seconds, loop %.3f -> %.3f\n", path.c_str(),
+            result->complete ? "finished" : "started", int(result->orderStarts.size()), int(result->rows.size()),
+            double(result->duration), double(result->loopEnd), double(result->loopStart));
+}
+
+bool AnalysisStore::analyze(const std::string& path, int64_t mtime) {
+    TRACE_SCOPE("analysis");
+    std::vector<std::byte> data;
+    if (ModUtil::loadFile(path.c_str(), data)) { return false; }
+    Config config;
+    config.filter = FilterMethod::None;  // cheapest resampler; doesn't affect the timing
+    std::string error;
+    std::unique_ptr<openmpt::module> mod(ModUtil::createModule(data, config, false, error));
+    if (!mod) { return false; }
+    std::vector<std::byte>().swap(data);  // OpenMPT has its own copy
+
+    // quick results first, so the player can use the loop points right away
+    auto result = std::make_shared<ModuleAnalysis>();
+    findOrderStarts(*mod, *result);
+    findLoop(*mod, *result);
+    if (m_quit) { return false; }
+    publish(path, mtime, result);
+
+    // then the results that require playing the whole module
+    auto full = std::make_shared<ModuleAnalysis>(*result);
+    mod->set_position_seconds(0.0);
+    if (!buildTimeIndex(*mod, *full)) { return false; }
+    full->complete = true;
+    publish(path, mtime, full);
+    return true;
+}
+
+void AnalysisStore::findOrderStarts(openmpt::module& mod, ModuleAnalysis& result) {
+    // OpenMPT's seek simulation follows the pattern flow control (jumps,
+    // breaks, loops) without rendering anything, so seeking to the start of
+    // each order yields the time at which it's played first; orders that
+    // are never played end up at the end of the song
+    TRACE_SCOPE("analysis: order starts");
+    double duration = std::max(0.0, mod.get_duration_seconds());
+    result.duration = float(duration);
+    int numOrders = mod.get_num_orders();
+    int numPatterns = mod.get_num_patterns();
+    result.orderStarts.reserve(size_t(std::max(0, numOrders)));
+    for (int order = 0;  order < numOrders;  ++order) {
+        if (m_quit) { return; }
+        if (mod.get_order_pattern(order) >= numPatterns) { continue; }  // "+++" or "---"
+        double time = mod.set_position_order_row(order, 0);
+        if (time < duration) { result.orderStarts.push_back(float(time)); }
+    }
+    std::sort(result.orderStarts.begin(), result.orderStarts.end());
+    result.orderStarts.shrink_to_fit();
+}
+
+bool AnalysisStore::buildTimeIndex(openmpt::module& mod, ModuleAnalysis& result) {
+    // libopenmpt's public API doesn't expose the row visit information from
+    // its internal seek simulation, so the module is played (see above)
+    // and the row transitions are timestamped; the waveform overview is
+    // collected in the same pass
+    TRACE_SCOPE("analysis: time index");
+    float buffer[chunkSize];
+    int prevOrder = -1, prevRow = -1;
+    uint64_t samples = 0u;
+
+    // the column width is derived from OpenMPT's duration estimate;
+    // if the song turns out to be longer, the last column gets the rest
+    uint64_t estSamples = uint64_t(std::max(0.0, mod.get_duration_seconds()) * double(sampleRate)) + 1u;
+    uint64_t colSamples = std::max(uint64_t(chunkSize), (estSamples + ModuleAnalysis::WaveColumns - 1u) / ModuleAnalysis::WaveColumns);
+    result.wave.reserve(size_t((estSamples + colSamples - 1u) / colSamples));
+    float colMin = 0.0f, colMax = 0.0f, colSum2 = 0.0f;
+    uint64_t colCount = 0u;
+    auto finishColumn = [&] () {
+        if (!colCount) { return; }
+        auto scale = [] (float v) -> int { return std::clamp(int(std::lround(v * 127.0f)), -127, 127); };
+        result.wave.push_back(ModuleAnalysis::WaveColumn { int8_t(scale(colMin)), int8_t(scale(colMax)),
+                              uint8_t(scale(std::sqrt(colSum2 / float(colCount)))) });
+        colMin = colMax = colSum2 = 0.0f;
+        colCount = 0u;
+    };
+
+    for (;;) {
+        if (m_quit) { return false; }
+        int order = mod.get_current_order();
+        int row = mod.get_current_row();
+        if ((row != prevRow) || (order != prevOrder)) {
+            float time = float(double(samples) / double(sampleRate));
+            result.rows.push_back(ModuleAnalysis::RowTime { time, uint16_t(std::clamp(order, 0, 0xFFFF)), uint16_t(std::clamp(row, 0, 0xFFFF)) });
+            prevOrder = order;
+            prevRow = row;
+        }
+        size_t count = mod.read(sampleRate, size_t(chunkSize), buffer);
+        if (!count) { break; }
+        samples += count;
+        for (size_t i = 0u;  i < count;  ++i) {
+            float v = buffer[i];
+            colMin = std::min(colMin, v);
+            colMax = std::max(colMax, v);
+            colSum2 += v * v;
+        }
+        colCount += count;
+        if ((colCount >= colSamples) && (result.wave.size() < size_t(ModuleAnalysis::WaveColumns - 1))) { finishColumn(); }
+    }
+    finishColumn();
+    result.duration = float(double(samples) / double(sampleRate));
+    result.waveColumnTime = float(double(colSamples) / double(sampleRate));
+    result.rows.shrink_to_fit();
+    result.wave.shrink_to_fit();
+    return true;
+}
+
+void AnalysisStore::findLoop(openmpt::module& mod, ModuleAnalysis& result) {
+    // the loop ends where OpenMPT's song end detection stops playback (at
+    // the first row that would be played a second time); the module is
+    // seeked to shortly before that point and played up to it, then it's
+    // switched to "continue" mode, which makes it jump to the loop target,
+    // just like the player does with loop=true; only the last second or so
+    // of the song is rendered, and the loop target's time comes from the
+    // seek simulation again
+    TRACE_SCOPE("analysis: loop");
+    constexpr int maxChunks = 10 * 1000;  // give up after 10 seconds if the duration estimate is off
+    float buffer[chunkSize];
+    mod.set_position_seconds(std::max(0.0, double(result.duration) - 1.0));
+    size_t count = 1u;
+    for (int i = 0;  count && (i < maxChunks);  ++i) {
+        if (m_quit) { return; }
+        count = mod.read(sampleRate, size_t(chunkSize), buffer);
+    }
+    if (count) { return; }
+    double end = mod.get_position_seconds();
+    mod.ctl_set("play.at_end", "continue");
+    for (int attempt = 0;  !count && (attempt < 3);  ++attempt) {
+        count = mod.read(sampleRate, size_t(chunkSize), buffer);
+    }
+    mod.ctl_set("play.at_end", "stop");
+    if (!count) { return; }
+    int order = mod.get_current_order();
+    int row = mod.get_current_row();
+    result.loopEnd = float(end);
+    result.loopStart = float(mod.set_position_order_row(order, row));
+    Dprintf("loop detected: order %d row %d, %.3f -> %.3f seconds\n", order, row, double(result.loopEnd), double(result.loopStart));
+}
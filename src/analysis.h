@@ -0,0 +1,123 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+namespace openmpt {
+    class module;
+}
+
+//! results of the background analysis of a module file
+struct ModuleAnalysis {
+    //! a played row, with its start time
+    struct RowTime {
+        float time;      //!< start time, in seconds
+        uint16_t order;
+        uint16_t row;
+    };
+    //! one column of the waveform overview, with sample values scaled to +/-127
+    struct WaveColumn {
+        int8_t min;
+        int8_t max;
+        uint8_t rms;
+    };
+    //! number of columns in the waveform overview (fewer for very short songs)
+    static constexpr int WaveColumns = 1024;
+
+    std::vector<RowTime> rows;       //!< all played rows in playback order (and thus sorted by time)
+    std::vector<float> orderStarts;  //!< start times of all played orders, in playback order
+    float duration = 0.0f;           //!< total playback duration, in seconds
+    float loopStart = -1.0f;         //!< time at which playback continues after the end of the song (-1 = unknown)
+    float loopEnd = -1.0f;           //!< time at which playback jumps back to loopStart (-1 = unknown)
+    //! Results are published in two steps: first orderStarts, duration and
+    //! the loop points, which only take milliseconds to compute; then the
+    //! complete results, once the module has been played through for the
+    //! time index (rows) and the waveform overview (wave).
+    bool complete = false;
+    std::vector<WaveColumn> wave;    //!< waveform overview (mono mixdown); each column covers waveColumnTime seconds
+    float waveColumnTime = 0.0f;
+
+    //! find the index (into rows) of the row that is playing at a specific time
+    //! \returns -1 if the index is empty
+    int findRow(float time) const;
+
+    //! estimated heap memory used by the analysis results, in bytes
+    size_t memoryUsage() const;
+};
+
+//! Cache of module analysis results, with a worker thread that computes
+//! them in the background, using its own module instance. Entries are
+//! keyed by the module file's path and invalidated if the file has been
+//! modified since.
+class AnalysisStore {
+public:
+    //! maximum number of cached entries; the least recently used ones are dropped first
+    static constexpr size_t MaxEntries = 64;
+
+    inline AnalysisStore() {}
+    inline ~AnalysisStore() { shutdown(); }
+
+    //! request the analysis of a module file, unless it's already cached;
+    //! requests for other files that haven't been started yet are dropped
+    void request(const std::string& path);
+
+    //! get the analysis results of a module file
+    //! \returns nullptr if not available (yet)
+    std::shared_ptr<const ModuleAnalysis> get(const std::string& path);
+
+    //! wait until the complete analysis results of a module file are
+    //! available (or the analysis failed)
+    //! \returns nullptr if not available
+    std::shared_ptr<const ModuleAnalysis> wait(const std::string& path);
+
+    //! counter that is incremented whenever new results become available,
+    //! so the main thread doesn't need to call get() on every frame
+    inline uint32_t generation() const { return m_generation.load(std::memory_order_acquire); }
+
+    //! drop all cached results, except those for a specific file
+    //! \returns the number of dropped entries
+    int evictAllExcept(const std::string& path);
+
+    //! estimated heap memory used by all cached results, in bytes
+    size_t memoryUsage() const;
+
+    //! cancel pending work and stop the worker thread
+    void shutdown();
+
+private:
+    struct Entry {
+        int64_t mtime;
+        uint64_t lastUse;
+        std::shared_ptr<const ModuleAnalysis> data;
+    };
+    mutable std::mutex m_lock;  //!< protects all the following members
+    std::condition_variable m_wakeup;
+    std::map<std::string, Entry> m_entries;
+    std::string m_pending;      //!< next file to analyze (empty = none)
+    std::string m_active;       //!< file that is being analyzed (empty = none)
+    std::condition_variable m_finished;  //!< signaled when an analysis is finished
+    uint64_t m_useCounter = 0;
+    size_t m_bytes = 0;
+    std::thread* m_thread = nullptr;
+    std::atomic<bool> m_quit { false };
+    std::atomic<uint32_t> m_generation { 0 };
+
+    void run();
+    bool analyze(const std::string& path, int64_t mtime);
+    void publish(const std::string& path, int64_t mtime, const std::shared_ptr<const ModuleAnalysis>& result);
+    void findOrderStarts(openmpt::module& mod, ModuleAnalysis& result);
+    void findLoop(openmpt::module& mod, ModuleAnalysis& result);
+    bool buildTimeIndex(openmpt::module& mod, ModuleAnalysis& result);
+};
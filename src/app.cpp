@@ -10,11 +10,9 @@
 #include <cmath>
 
 #include <vector>
-#include <map>
 #include <string>
-#include <iostream>
+#include <algorithm>
 
-#include <glad/glad.h>
 #include <libopenmpt/libopenmpt.hpp>
 #include <ebur128.h>
 #include "imgui.h"
@@ -24,6 +22,10 @@
 #include "textarea.h"
 #include "config.h"
 #include "pathutil.h"
+#include "modutil.h"
+#include "trace.h"
+#include "metrics.h"
+#include "alloc_counter.h"
 #include "util.h"
 #include "app.h"
 #include "version.h"
@@ -31,6 +33,8 @@
 constexpr const char* baseWindowTitle = "TrackMeister";
 constexpr float scrollAnimationSpeed = -10.f;
 constexpr size_t scanBufferSize = 4096;
+constexpr float declickRampTime = 0.01f;  // duration of gain, seek and pause ramps, in seconds
+constexpr int prefetchCellsPerFrame = 256;  // number of pattern cells of the next pattern to format per frame
 
 extern "C" const int LogoDataSize;
 extern "C" const unsigned char LogoData[];
@@ -44,6 +48,10 @@ int Application::init(int argc, char* argv[]) {
         return m_config.save("tm_default.ini") ? 0 : 1;
     }
 
+    // bail out before running into illegal instructions
+    const char* cpuError = ModUtil::checkCPU();
+    if (cpuError) { m_sys.fatalError("unsupported CPU", cpuError); }
+
     // load initial configuration (required for video and audio parameters)
     m_cmdlineConfig.load(Config::prepareCommandLine(argc, argv));
     m_mainIniFile.assign(argv[0]);
@@ -51,6 +59,9 @@ int Application::init(int argc, char* argv[]) {
     PathUtil::joinInplace(m_mainIniFile, "tm.ini");
     m_globalConfig.load(m_mainIniFile.c_str());
     updateConfig();
+    if (Trace::init(m_config.trace.c_str())) {
+        Trace::setThreadName("main");
+    }
 
     // initialize everything
     m_sys.initVideo(baseWindowTitle,
@@ -59,14 +70,29 @@ int Application::init(int argc, char* argv[]) {
         #else
             false,
         #endif
-        m_config.windowWidth, m_config.windowHeight);
+        m_config.windowWidth, m_config.windowHeight, m_config.softwareRendering);
     m_sampleRate = m_sys.initAudio(true, m_config.sampleRate, m_config.audioBufferSize);
-    if (!m_renderer.init()) {
+    SoftwareRasterizer* raster = m_sys.softwareRasterizer();
+    if (raster ? !m_renderer.initSoftware(raster)
+    : m_sys.headless() ? !m_renderer.initHeadless(m_config.windowWidth, m_config.windowHeight)
+    : !m_renderer.init()) {
         m_sys.fatalError("initialization failed", "could not initialize text box renderer");
     }
-    m_defaultLogoTex = m_renderer.loadTexture(LogoData, LogoDataSize, 1, true, &m_defaultLogoSize);
+    m_renderer.setFontCacheDir(PathUtil::join(PathUtil::dirname(m_mainIniFile), "fontcache"));
+    if (!m_renderer.headless()) {
+        m_defaultLogoTex = m_renderer.loadTexture(LogoData, LogoDataSize, 1, true, &m_defaultLogoSize);
+    }
     updateImages();
     m_renderer.setAlphaGamma(m_config.alphaGamma);
+    if ((m_config.controlPort > 0) && !m_control.start(m_config.controlPort)) {
+        toast("could not start remote control server");
+    }
+    if (!m_config.record.empty() && !m_eventLog.startRecording(m_config.record.c_str())) {
+        toast("could not create event recording file");
+    }
+    if (!m_config.replay.empty() && !m_eventLog.loadReplay(m_config.replay.c_str())) {
+        toast("could not load event replay file");
+    }
 
     // populate playable extension list
     m_playableExts.clear();
@@ -86,6 +112,11 @@ int Application::init(int argc, char* argv[]) {
 }
 
 void Application::shutdown() {
+    m_control.stop();
+    m_eventLog.stopRecording(m_eventTime);
+    m_analysisStore.shutdown();
+    m_spectrum.stop();
+    m_scopes.stop();
     unloadModule();
     m_renderer.freeTexture(m_defaultLogoTex);
     m_renderer.shutdown();
@@ -118,6 +149,7 @@ bool Application::hasTrackNumber(const char* basename) {
 }
 
 void Application::reloadConfig() {
+    TRACE_SCOPE("reloadConfig");
     m_globalConfig.reset();
     m_globalConfig.load(m_mainIniFile.c_str());
     m_globalConfig.load(m_dirIniFile.c_str());
@@ -131,6 +163,7 @@ void Application::reloadConfig() {
 }
 
 void Application::updateConfig() {
+    TRACE_SCOPE("updateConfig");
     m_config.reset();
     m_config.import(m_globalConfig);
     m_config.import(m_uiGlobalConfig);
@@ -146,17 +179,35 @@ void Application::updateConfig() {
 
 bool Application::renderAudio(int16_t* data, int sampleCount, bool stereo, int sampleRate) {
     if (!m_mod || m_scanning) { return false; }
+    TRACE_SCOPE("renderAudio");
+    openmpt::module* ready = m_seeker.takeReady();
+    if (ready) { switchInstance(ready, stereo, sampleRate); }
+    processAudioCommands(sampleRate);
+    if (m_outputPaused) {
+        ::memset(static_cast<void*>(data), 0, stereo ? (sampleCount << 2) : (sampleCount << 1));
+        return true;
+    }
 
     // retrieve samples from libopenmpt
+    openmpt::module* mod = m_playMod.load(std::memory_order_relaxed);
     int16_t* pos = data;
     int done, remain = sampleCount;
     bool hadNullRead = false;
+    int loopAt = -1;  // sample at which playback loops, if any
+    if (m_loopEnd >= 0.0f) {
+        // the loop point is known from the analysis -> the fade-out can be
+        // scheduled for the exact sample; the null read at the loop (see
+        // below) is only a fallback for when the analysis isn't ready yet
+        double offset = (double(m_loopEnd) - mod->get_position_seconds()) * double(sampleRate);
+        if ((offset >= 0.0) && (offset < double(sampleCount))) { loopAt = int(offset); }
+    }
     while (remain > 0) {
         // render a fragment
+        TRACE_SCOPE("openmpt read");
         if (stereo) {
-            done = int(m_mod->read_interleaved_stereo(sampleRate, remain, pos));
+            done = int(mod->read_interleaved_stereo(sampleRate, remain, pos));
         } else {
-            done = int(m_mod->read(sampleRate, remain, pos));
+            done = int(mod->read(sampleRate, remain, pos));
         }
         // advance pointers
         if (!done) {
@@ -167,6 +218,7 @@ bool Application::renderAudio(int16_t* data, int sampleCount, bool stereo, int s
                 break;
             }
             hadNullRead = true;
+            if (loopAt < 0) { loopAt = sampleCount - remain; }
         } else if ((done < 0) || (done > remain)) {
             Dprintf("openmpt::module::read() returned %d samples, requested were %d samples\n", done, remain);
             break;  // panic!
@@ -187,11 +239,20 @@ bool Application::renderAudio(int16_t* data, int sampleCount, bool stereo, int s
         if ((*pos <= -32767) || (*pos >= 32767)) { m_clipped = true; break; }
     }
 
+    // start fade-out after loop, if so desired; the fade starts exactly
+    // at the sample where the loop occurred, not with the next buffer
+    int fadeFrom = 0;
+    if ((loopAt >= 0) && m_config.loop && m_config.fadeOutAfterLoop && !m_autoFadeInitiated && !m_fadeActive) {
+        startFade(sampleRate);
+        m_autoFadeInitiated = true;
+        fadeFrom = loopAt;
+    }
+
     // apply fade-out
     if (m_fadeActive) {
         int gain16b = m_fadeGain >> 15;
-        pos = data;
-        for (remain = stereo ? (sampleCount << 1) : sampleCount;  remain;  --remain, ++pos) {
+        pos = stereo ? (data + (fadeFrom << 1)) : (data + fadeFrom);
+        for (remain = stereo ? ((sampleCount - fadeFrom) << 1) : (sampleCount - fadeFrom);  remain;  --remain, ++pos) {
             *pos = int16_t((int(*pos) * gain16b + 32767) >> 16);
             m_fadeGain = std::max(0, m_fadeGain - m_fadeRate);
         }
@@ -200,30 +261,180 @@ bool Application::renderAudio(int16_t* data, int sampleCount, bool stereo, int s
         }
     }
 
-    // start fade-out after loop, if so desired
-    if (hadNullRead && m_config.loop && m_config.fadeOutAfterLoop && !m_autoFadeInitiated) {
-        fadeOut();
-        m_autoFadeInitiated = true;
+    // apply de-click ramp; when pausing, everything after the ramp is silent,
+    // and after switching instances, the old instance's output is faded out
+    if (m_rampRemain > 0) {
+        int channels = stereo ? 2 : 1;
+        int count = std::min(sampleCount, m_rampRemain);
+        const int16_t* xfade = m_xfadeActive ? &m_xfadeBuffer[m_xfadePos] : nullptr;
+        pos = data;
+        for (int i = count;  i;  --i) {
+            for (int c = channels;  c;  --c, ++pos) {
+                float v = float(*pos) * m_rampGain;
+                if (xfade) { v += float(*xfade++) * (1.0f - m_rampGain); }
+                *pos = int16_t(std::clamp(int(std::lround(v)), -32768, 32767));
+            }
+            m_rampGain += m_rampStep;
+        }
+        m_xfadePos += size_t(count) * size_t(channels);
+        m_rampRemain -= count;
+        if (!m_rampRemain) {
+            m_rampGain = m_rampTarget;
+            if (m_rampTarget <= 0.0f) {
+                ::memset(static_cast<void*>(pos), 0, size_t(sampleCount - count) * size_t(channels) * sizeof(int16_t));
+                m_outputPaused = true;
+            }
+        }
     }
+
+    // hand the final output over to the spectrum analyzer
+    m_spectrum.push(data, sampleCount, stereo);
+    publishPlayState();
     return true;
 }
 
+void Application::switchInstance(openmpt::module* mod, bool stereo, int sampleRate) {
+    TRACE_SCOPE("switchInstance");
+    openmpt::module* old = m_playMod.load(std::memory_order_relaxed);
+    mod->set_render_param(openmpt::module::render_param::RENDER_MASTERGAIN_MILLIBEL, int(m_renderGain * 100.0f + 0.5f));
+    m_playMod.store(mod, std::memory_order_relaxed);
+    publishPlayState();
+    if (m_seeker.tookLatest()) { g_metrics.latency.audioDone(LatencyProbe::Action::Seek); }
+    if (!m_outputPaused) {
+        // render the beginning of what the old instance would have played,
+        // and crossfade from that into the new instance
+        startRamp(0.0f, m_rampTarget, sampleRate);
+        size_t frames = size_t(m_rampRemain);
+        if ((m_rampTarget > 0.0f) && ((frames * 2u) <= m_xfadeBuffer.size())) {
+            size_t done = stereo ? old->read_interleaved_stereo(sampleRate, frames, m_xfadeBuffer.data())
+                                 : old->read(sampleRate, frames, m_xfadeBuffer.data());
+            if (done < frames) {
+                std::fill(m_xfadeBuffer.begin() + ptrdiff_t(done * (stereo ? 2u : 1u)), m_xfadeBuffer.end(), int16_t(0));
+            }
+            m_xfadeActive = true;
+        }
+    }
+    m_seeker.giveBack(old);
+}
+
+void Application::processAudioCommands(int sampleRate) {
+    openmpt::module* mod = m_playMod.load(std::memory_order_relaxed);
+    AudioCommand cmd;
+    bool executed = false;
+    while (m_audioCommands.pop(cmd)) {
+        switch (cmd.type) {
+            case AudioCommand::Type::SetGain: {
+                // OpenMPT's master gain changes instantly; the ramp starts
+                // at the previous gain and converges to the new one
+                float ratio = std::pow(10.0f, (m_renderGain - cmd.value) / 20.0f);
+                mod->set_render_param(openmpt::module::render_param::RENDER_MASTERGAIN_MILLIBEL, int(cmd.value * 100.0f + 0.5f));
+                m_renderGain = cmd.value;
+                if (!m_outputPaused) { startRamp(m_rampGain * ratio, m_rampTarget, sampleRate); }
+                break; }
+            case AudioCommand::Type::Seek:
+                Dprintf("seeking to %.3f seconds\n", double(cmd.value));
+                mod->set_position_seconds(double(cmd.value));
+                if (!m_outputPaused) { startRamp(0.0f, m_rampTarget, sampleRate); }
+                g_metrics.latency.audioDone(LatencyProbe::Action::Seek);
+                break;
+            case AudioCommand::Type::SeekOrder:
+                Dprintf("seeking to order %d row %d\n", int(cmd.value), cmd.row);
+                mod->set_position_order_row(int(cmd.value), cmd.row);
+                if (!m_outputPaused) { startRamp(0.0f, m_rampTarget, sampleRate); }
+                g_metrics.latency.audioDone(LatencyProbe::Action::Seek);
+                break;
+            case AudioCommand::Type::Fade:
+                startFade(sampleRate);
+                break;
+            case AudioCommand::Type::Pause:
+                if (!m_outputPaused) { startRamp(m_rampGain, 0.0f, sampleRate); }
+                break;
+            case AudioCommand::Type::SetLoopEnd:
+                m_loopEnd = cmd.value;
+                break;
+            case AudioCommand::Type::Resume:
+                m_fadeActive = false;
+                if (m_outputPaused) {
+                    m_outputPaused = false;
+                    startRamp(0.0f, 1.0f, sampleRate);
+                } else if (m_rampTarget <= 0.0f) {
+                    startRamp(m_rampGain, 1.0f, sampleRate);
+                }
+                break;
+        }
+        executed = true;
+    }
+    if (executed) { publishPlayState(); }
+}
+
+void Application::startRamp(float from, float to, int sampleRate) {
+    m_rampGain = from;
+    m_rampTarget = to;
+    m_rampRemain = std::max(1, int(float(sampleRate) * declickRampTime + 0.5f));
+    m_rampStep = (to - from) / float(m_rampRemain);
+    m_xfadeActive = false;
+    m_xfadePos = 0u;
+}
+
+void Application::startFade(int sampleRate) {
+    m_fadeGain = 0x7FFFFFFF;
+    m_fadeRate = int(double(m_fadeGain) / (double(sampleRate) * 2.0 * double(m_config.fadeDuration)) + 0.5);
+    Dprintf("startFade(): fade rate = %d\n", m_fadeRate);
+    m_fadeActive = true;
+}
+
+void Application::publishPlayState() {
+    openmpt::module* mod = m_playMod.load(std::memory_order_relaxed);
+    m_playPos.store((uint64_t(uint16_t(mod->get_current_order())) << 32)
+                  | (uint64_t(uint16_t(mod->get_current_pattern())) << 16)
+                  |  uint64_t(uint16_t(mod->get_current_row())), std::memory_order_relaxed);
+    m_playTime.store(float(mod->get_position_seconds()), std::memory_order_relaxed);
+    m_playFade.store(m_fadeActive ? (float(m_fadeGain) / float(0x7FFFFFFF)) : -1.0f, std::memory_order_relaxed);
+    for (size_t ch = 0;  ch < m_playVU.size();  ++ch) {
+        m_playVU[ch].store(mod->get_current_channel_vu_mono(int(ch)), std::memory_order_relaxed);
+    }
+}
+
+void Application::sendAudioCommand(AudioCommand::Type type, float value, int row) {
+    if (!m_audioCommands.push(AudioCommand { type, value, row })) {
+        Dprintf("WARNING: audio command queue overflow, command dropped\n");
+        return;
+    }
+    if (!m_sys.isPlaying() && m_mod) {
+        // the audio callback doesn't run while the device is paused, so the
+        // command is executed right here (and the lock is uncontended)
+        AudioMutexGuard mtx_(m_sys);
+        processAudioCommands(m_sampleRate);
+    }
+}
+
 void Application::fadeOut() {
     if (!m_mod) { return; }
-    if (m_fadeActive) {
-        m_sys.pause();
-        m_fadeActive = false;
+    if (m_playFade.load(std::memory_order_relaxed) >= 0.0f) {
+        setPaused(true);
         return;
     }
-    AudioMutexGuard mtx_(m_sys);
-    m_fadeGain = 0x7FFFFFFF;
-    m_fadeRate = int(double(m_fadeGain) / (double(m_sampleRate) * 2.0 * double(m_config.fadeDuration)) + 0.5);
-    Dprintf("fadeOut(): fade rate = %d\n", m_fadeRate);
-    m_fadeActive = true;
+    sendAudioCommand(AudioCommand::Type::Fade);
+}
+
+void Application::setPaused(bool paused) {
+    if (!m_mod) { return; }
+    if (!m_sys.isPlaying()) {
+        // audio device not started yet (or stopped when unloading a module)
+        if (!paused) {
+            sendAudioCommand(AudioCommand::Type::Resume);
+            m_sys.play();
+        }
+        m_paused = false;
+        return;
+    }
+    if (paused == m_paused) { return; }
+    m_paused = paused;
+    sendAudioCommand(paused ? AudioCommand::Type::Pause : AudioCommand::Type::Resume);
 }
 
 void Application::handleKey(int key, bool ctrl, bool shift, bool alt) {
-    (void)alt;
+    m_eventLog.recordKey(m_eventTime, key, ctrl, shift, alt);
     if (key != 27) { m_escapePressedOnce = false; }
     switch (key) {
         case 'Q':  // [Q] quit immediately
@@ -238,8 +449,10 @@ void Application::handleKey(int key, bool ctrl, bool shift, bool alt) {
                 m_showHelp = false;
             } else if (m_showConfig) {  // dismiss config window
                 m_showConfig = false;
-            } else if (m_mod && m_sys.isPlaying()) {  // pause
-                m_sys.pause();
+            } else if (m_showMemory) {  // dismiss memory usage window
+                m_showMemory = false;
+            } else if (m_mod && playing()) {  // pause
+                setPaused(true);
             } else if (!m_escapePressedOnce) {  // first Esc while paused -> do nothing (yet)
                 m_escapePressedOnce = true;
             } else {
@@ -247,13 +460,26 @@ void Application::handleKey(int key, bool ctrl, bool shift, bool alt) {
             }
             break;
         case ' ':  // [Space] pause/play
-            if (m_mod) { m_fadeActive = false; m_sys.togglePause(); }
+            if (m_mod) {
+                setPaused(playing());
+                if (playing()) { g_metrics.latency.arm(LatencyProbe::Action::Play); }
+            }
             break;
         case '\t':  // [Tab] show/hide info
             cycleBoxVisibility();
             break;
-        case '\r':  // [Enter] show/hide fake VU meters
-            m_vuVisible = !m_vuVisible;
+        case '\r':  // [Enter] show/hide fake VU meters, [Shift+Enter] show/hide spectrum analyzer
+            if (shift) {
+                m_spectrumVisible = !m_spectrumVisible;
+                updateSpectrumAnalyzer();
+            } else {
+                m_vuVisible = !m_vuVisible;
+            }
+            break;
+        case 'O':  // [O] show/hide channel oscilloscopes
+            m_scopesVisible = !m_scopesVisible;
+            updateChannelScopes();
+            updateMemoryUsage();
             break;
         case 'N':  // [N] show/hide channel names
             m_namesVisible = !m_namesVisible && namesValid();
@@ -306,6 +532,9 @@ void Application::handleKey(int key, bool ctrl, bool shift, bool alt) {
             else if (!m_uiConfigShowGlobal) { m_showConfig = false; }
             m_uiConfigShowGlobal = false;
             break;
+        case 0xF4:  // [F4] show/hide memory usage
+            m_showMemory = !m_showMemory;
+            break;
         case 0xF5: {  // [F5] reload module
             std::string savePath(m_fullpath);
             loadModule(savePath.c_str());
@@ -317,27 +546,26 @@ void Application::handleKey(int key, bool ctrl, bool shift, bool alt) {
             m_sys.toggleFullscreen();
             break;
         case makeFourCC("Left"):  // previous pattern
-            if (m_mod) {
-                AudioMutexGuard mtx_(m_sys);
-                int dest = m_mod->get_current_order();
-                do {  // decrement order in loop to skip over skipped orders
-                    --dest;
-                } while ((dest >= 0) && (m_mod->get_order_pattern(dest) >= 65534));
-                Dprintf("seeking to order %d\n", dest);
-                m_mod->set_position_order_row(dest, 0);
+            if (m_mod && ctrl) {
+                seekBy(-10.0f);
+            } else if (m_mod) {
+                seekOrder(-1);
             } break;
         case makeFourCC("Right"):  // next pattern
-            if (m_mod) {
-                AudioMutexGuard mtx_(m_sys);
-                int dest = m_mod->get_current_order() + 1;
-                Dprintf("seeking to order %d\n", dest);
-                m_mod->set_position_order_row(dest, 0);
+            if (m_mod && ctrl) {
+                seekBy(+10.0f);
+            } else if (m_mod) {
+                seekOrder(+1);
             } break;
         case makeFourCC("PgUp"): {  // previous module
+            g_metrics.latency.arm(LatencyProbe::Action::Load);
             loadNextModule(true);
+            if (!m_mod) { g_metrics.latency.disarm(); }
             break; }
         case makeFourCC("PgDn"): {  // next module
+            g_metrics.latency.arm(LatencyProbe::Action::Load);
             loadNextModule();
+            if (!m_mod) { g_metrics.latency.disarm(); }
             break; }
         case makeFourCC("Home"):  // first module in directory
             if (ctrl) {
@@ -361,20 +589,113 @@ void Application::handleKey(int key, bool ctrl, bool shift, bool alt) {
 }
 
 void Application::handleDropFile(const char* path) {
+    m_eventLog.recordDrop(m_eventTime, path);
     loadModule(path);
 }
 
 void Application::handleResize(int w, int h) {
-    glViewport(0, 0, w, h);
-    m_renderer.viewportChanged();
+    m_eventLog.recordResize(m_eventTime, w, h);
+    m_renderer.viewportChanged(w, h);
     updateLayout();
 }
 
 void Application::handleMouseWheel(int delta) {
+    m_eventLog.recordWheel(m_eventTime, delta);
     setMetadataScroll(m_metaTextTargetY + float(delta * 3 * m_metadata.defaultSize));
     m_metaTextAutoScroll = false;
 }
 
+void Application::handleMouseClick(int x, int y) {
+    m_eventLog.recordClick(m_eventTime, x, y);
+    if (m_mod && m_infoVisible && (m_progSize > 0)
+    && (x >= m_progX0) && (x < m_progX1) && (y >= m_progY0) && (y < m_progY1)) {
+        // click into progress bar -> seek there
+        seekTo(float(x - m_progPosX0) / float(std::max(1, m_progPosDX)) * m_duration);
+    }
+}
+
+void Application::updateSpectrumAnalyzer() {
+    if (m_spectrumVisible) {
+        m_spectrum.start(m_sampleRate, m_config.spectrumBands);
+    } else {
+        m_spectrum.stop();
+    }
+}
+
+void Application::updateChannelScopes() {
+    if (!m_scopesVisible || !m_mod || m_scanning) {
+        m_scopes.stop();
+    } else if (!m_scopes.active() && !m_scopes.start(m_fullpath, m_numChannels)) {
+        m_scopesVisible = false;
+    }
+}
+
+void Application::seekTo(float time) {
+    if (!m_mod) { return; }
+    time = std::min(std::max(time, 0.0f), m_duration);
+    // snap to the start of the row that plays at that time, if the time index
+    // is available; otherwise, OpenMPT seeks to the nearest tick
+    int index = m_analysis ? m_analysis->findRow(time) : -1;
+    if (index < 0) { requestSeek(time); return; }
+    const auto& rows = m_analysis->rows;
+    const auto& target = rows[size_t(index)];
+    // seeking to the row directly is cheaper than seeking to its time, and
+    // exact; that's only possible for the row's first occurrence, though
+    // (OpenMPT seeks to that one), not for repetitions in pattern loops
+    for (int i = index - 1;  i >= 0;  --i) {
+        if ((rows[size_t(i)].order == target.order) && (rows[size_t(i)].row == target.row)) {
+            requestSeek(target.time);
+            return;
+        }
+    }
+    requestSeek(target.time, int(target.order), int(target.row));
+}
+
+void Application::seekBy(float seconds) {
+    // relative to the previous seek's target if that one isn't finished yet
+    float base = (m_seeker.pending() && (m_seekTime >= 0.0f)) ? m_seekTime : m_position;
+    seekTo(base + seconds);
+}
+
+void Application::seekOrder(int delta) {
+    if (!m_mod) { return; }
+    int dest = (m_seeker.pending() && (m_seekOrder >= 0)) ? m_seekOrder : m_currentOrder;
+    if (delta < 0) {
+        do {  // decrement order in loop to skip over skipped orders
+            --dest;
+        } while ((dest >= 0) && (m_mod->get_order_pattern(dest) >= 65534));
+    } else {
+        ++dest;
+    }
+    requestSeek(-1.0f, dest);
+}
+
+void Application::requestSeek(float time, int order, int row) {
+    if (m_seeker.ready() && m_sys.isPlaying()) {
+        if (order >= 0) {
+            Dprintf("requesting background seek to order %d row %d\n", order, row);
+            m_seeker.seekOrder(order, row);
+        } else {
+            Dprintf("requesting background seek to %.3f seconds\n", double(time));
+            m_seeker.seekTime(double(time));
+        }
+        m_seekOrder = order;
+        m_seekTime = time;
+        // armed only after posting the request, so that the audio thread
+        // can't complete the measurement by switching to an older seek
+        g_metrics.latency.arm(LatencyProbe::Action::Seek);
+    } else {
+        // no standby instance or no running audio thread -> seek directly
+        m_seeker.cancel();
+        g_metrics.latency.arm(LatencyProbe::Action::Seek);
+        if (order >= 0) {
+            sendAudioCommand(AudioCommand::Type::SeekOrder, float(order), row);
+        } else {
+            sendAudioCommand(AudioCommand::Type::Seek, time);
+        }
+    }
+}
+
 bool Application::loadNextModule(bool reverse) {
     std::string newPath(findPlayableSibling(m_fullpath,
         m_config.shuffle ? PathUtil::FindMode::Random :
@@ -438,8 +759,7 @@ void Application::toastVersion() {
 void Application::toastPosition() {
     if (!m_mod) { return; }
     char line[80];
-    AudioMutexGuard mtx_(m_sys);
-    auto sec = m_mod->get_position_seconds();
+    double sec = double(m_playTime.load(std::memory_order_relaxed));
     snprintf(line, 80, "current track position: %d:%02d (%.2f seconds)", int(sec) / 60, int(sec) % 60, sec);
     toast(line);
 }
@@ -447,11 +767,14 @@ void Application::toastPosition() {
 void Application::updateImage(ExternalImage& img, const std::string& path, int channels, const char* what) {
     int64_t mtime = PathUtil::getFileMTime(path.c_str());
     if ((path != img.path) || (mtime > img.mtime)) {
+        TRACE_SCOPE("updateImage");
         Dprintf("%s changed/updated: %s\n", what, path.c_str());
         img.path = path;
         img.mtime = mtime;
         m_renderer.freeTexture(img.tex);
-        img.tex = m_renderer.loadTexture(path.c_str(), channels, true, &img.size);
+        if (!m_renderer.headless()) {
+            img.tex = m_renderer.loadTexture(path.c_str(), channels, true, &img.size);
+        }
         if (!img.tex) { Dprintf("WARNING: %s didn't load successfully\n", what); }
         (void)what;  // not used in Release builds
     }
@@ -460,6 +783,91 @@ void Application::updateImage(ExternalImage& img, const std::string& path, int c
 void Application::updateImages() {
     updateImage(m_background, m_config.backgroundImage, 4, "background image");
     updateImage(m_logo,       m_config.logo,            1, "custom logo");
+    updateMemoryUsage();
+}
+
+void Application::updateMemoryUsage() {
+    g_metrics.setMemory(MemoryCategory::ModuleData,     m_mod_data.capacity());
+    g_metrics.setMemory(MemoryCategory::ModuleInstance, m_mod ? (m_modInstanceMemory * size_t(1 + m_scopes.numScopes()) + m_seeker.memoryUsage()) : 0u);
+    #if USE_PATTERN_CACHE
+        g_metrics.setMemory(MemoryCategory::PatternCache, (m_patternCache.capacity() + m_prefetchCache.capacity()) * sizeof(CacheItem));
+    #endif
+    g_metrics.setMemory(MemoryCategory::TextArea,       m_metadata.memoryUsage());
+    g_metrics.setMemory(MemoryCategory::Textures,       TextBoxRenderer::textureMemory());
+    g_metrics.setMemory(MemoryCategory::Analysis,       m_analysisStore.memoryUsage());
+    g_metrics.memoryBudget = uint64_t(std::max(0, m_config.memoryBudget)) << 20;
+    enforceMemoryBudget();
+}
+
+void Application::enforceMemoryBudget() {
+    uint64_t budget = g_metrics.memoryBudget;
+    if (!budget) { m_memoryOverBudget = false; return; }
+    auto overBudget = [&] () -> bool { return g_metrics.memoryTotal() > budget; };
+    auto evicted = [&] (const char* what) {
+        g_metrics.memoryEvictions = g_metrics.memoryEvictions + 1u;
+        Dprintf("memory budget exceeded, evicted %s\n", what);
+        (void)what;  // not used in Release builds
+    };
+
+    // evict the least valuable data first:
+    // 1. the raw module data isn't needed any longer once the module is
+    //    loaded (and the buffer is only kept around for the next load)
+    if (overBudget() && m_mod_data.capacity()) {
+        std::vector<std::byte>().swap(m_mod_data);
+        g_metrics.setMemory(MemoryCategory::ModuleData, 0u);
+        evicted("raw module data");
+    }
+    // 2. analysis results of other modules only save recomputation if
+    //    these modules are going to be played again
+    if (overBudget()) {
+        int count = m_analysisStore.evictAllExcept(m_fullpath);
+        if (count) {
+            g_metrics.setMemory(MemoryCategory::Analysis, m_analysisStore.memoryUsage());
+            g_metrics.memoryEvictions = g_metrics.memoryEvictions + uint64_t(count - 1);
+            evicted("analysis results of other modules");
+        }
+    }
+
+    // everything else is currently in use; in particular, the pattern cache
+    // is a fixed cost, as its storage must not be reallocated during playback
+    bool over = overBudget();
+    if (over && !m_memoryOverBudget) {
+        Dprintf("WARNING: memory usage (%llu KiB) exceeds the budget (%llu KiB)\n",
+                (unsigned long long)(g_metrics.memoryTotal() >> 10), (unsigned long long)(budget >> 10));
+    }
+    m_memoryOverBudget = over;
+}
+
+void Application::handleRemoteCommands() {
+    ControlServer::Command cmd;
+    while (m_control.poll(cmd)) {
+        g_metrics.latency.setInputTime(cmd.timeUs);
+        switch (cmd.type) {
+            case ControlServer::Command::Type::Key:
+                handleKey(cmd.key, cmd.ctrl, cmd.shift, cmd.alt);
+                break;
+            case ControlServer::Command::Type::Load:
+                g_metrics.latency.arm(LatencyProbe::Action::Load);
+                handleDropFile(cmd.path.c_str());
+                if (!m_mod) { g_metrics.latency.disarm(); }
+                break;
+        }
+        g_metrics.latency.setInputTime(0u);
+    }
+}
+
+void Application::replayEvents() {
+    EventLog::Event ev;
+    while (m_eventLog.nextDue(m_eventTime, ev)) {
+        switch (ev.type) {
+            case EventLog::Type::Key:    handleKey(ev.key, ev.ctrl, ev.shift, ev.alt); break;
+            case EventLog::Type::Drop:   handleDropFile(ev.path.c_str());              break;
+            case EventLog::Type::Resize: handleResize(ev.x, ev.y);                     break;
+            case EventLog::Type::Wheel:  handleMouseWheel(ev.key);                     break;
+            case EventLog::Type::Click:  handleMouseClick(ev.x, ev.y);                 break;
+            default: break;
+        }
+    }
 }
 
 void Application::changeInstanceGain(float delta) {
@@ -475,15 +883,19 @@ void Application::changeInstanceGain(float delta) {
     toast(s);
 }
 
-void Application::updateGain() {
-    if (!m_mod || m_scanning) { return; }
+float Application::targetGain() const {
     float gain = m_config.gain + m_instanceGain;
     if (isValidLoudness(m_config.loudness)) {
         gain += m_config.targetLoudness - m_config.loudness;
     }
+    return gain;
+}
+
+void Application::updateGain() {
+    if (!m_mod || m_scanning) { return; }
+    float gain = targetGain();
     Dprintf("master gain: %.2f dB\n", gain);
-    AudioMutexGuard mtx_(m_sys);
-    m_mod->set_render_param(openmpt::module::render_param::RENDER_MASTERGAIN_MILLIBEL, int(gain * 100.0f + 0.5f));
+    sendAudioCommand(AudioCommand::Type::SetGain, gain);
 }
 
 void Application::uiSaveConfig() {
@@ -515,8 +927,23 @@ void Application::uiSaveConfig() {
 ///// drawing
 
 void Application::draw(float dt) {
+    TRACE_SCOPE("draw");
+    uint64_t allocsAtStart = AllocCounter::count();
+    const openmpt::module* modAtStart = m_mod;
+    uint64_t prefetchAllocs = 0u;
+    bool steady = true;
     float fadeAlpha = 1.0f;
     m_renderer.setAlphaGamma(m_config.alphaGamma);
+    m_renderer.setRenderScale(m_config.renderScale);
+    if (dt > 0.0f) { g_metrics.frameTime.add(uint32_t(dt * 1.0E6f)); }
+
+    // replay recorded events that were handled before this frame
+    // (m_eventTime is still the time of the previous frame here)
+    if (m_eventLog.replaying()) { replayEvents(); }
+    m_eventTime += double(dt);
+
+    // handle commands from the remote control server
+    handleRemoteCommands();
 
     // handle end of track
     if (m_endReached) {
@@ -532,20 +959,50 @@ void Application::draw(float dt) {
         }
     }
 
-    // latch current position
+    // a seek is visible once the audio thread switched to the seeked
+    // instance, which publishes the new position before that
+    g_metrics.latency.holdFrame(m_seeker.pending());
+
+    // latch current position, as published by the audio thread
     if (m_mod) {
-        AudioMutexGuard mtx_(m_sys);
-        m_currentOrder = m_mod->get_current_order();
-        int pat = m_mod->get_current_pattern();
+        uint64_t pos = m_playPos.load(std::memory_order_relaxed);
+        m_currentOrder = int((pos >> 32) & 0xFFFFu);
+        int pat = int((pos >> 16) & 0xFFFFu);
         if (pat != m_currentPattern) { m_patternLength = m_mod->get_pattern_num_rows(pat); }
         m_currentPattern = pat;
-        m_currentRow = m_mod->get_current_row();
-        m_position = float(m_mod->get_position_seconds());
-        if (m_fadeActive) {
-            fadeAlpha = float(float(m_fadeGain) / float(0x7FFFFFFF));
+        m_currentRow = int(pos & 0xFFFFu);
+        m_position = m_playTime.load(std::memory_order_relaxed);
+        float fade = m_playFade.load(std::memory_order_relaxed);
+        if (fade >= 0.0f) { fadeAlpha = fade; }
+    }
+
+    // pick up new background analysis results
+    uint32_t analysisGeneration = m_analysisStore.generation();
+    if (analysisGeneration != m_analysisGeneration) {
+        m_analysisGeneration = analysisGeneration;
+        if (m_mod) {
+            // (the quick results, including the loop points, are published
+            // first, and replaced by the complete results later)
+            auto analysis = m_analysisStore.get(m_fullpath);
+            if (analysis && (analysis != m_analysis)) {
+                m_analysis = analysis;
+                sendAudioCommand(AudioCommand::Type::SetLoopEnd, m_analysis->loopEnd);
+            }
         }
+        updateMemoryUsage();
     }
 
+    // publish position for metrics queries
+    g_metrics.moduleLoaded.store(!!m_mod, std::memory_order_relaxed);
+    g_metrics.playing.store(m_mod && playing(), std::memory_order_relaxed);
+    g_metrics.order.store(m_currentOrder, std::memory_order_relaxed);
+    g_metrics.pattern.store(m_currentPattern, std::memory_order_relaxed);
+    g_metrics.row.store(m_currentRow, std::memory_order_relaxed);
+    g_metrics.position.store(m_mod ? m_position : 0.0f, std::memory_order_relaxed);
+    g_metrics.duration.store(m_mod ? m_duration : 0.0f, std::memory_order_relaxed);
+    g_metrics.loopStart.store(m_analysis ? m_analysis->loopStart : -1.0f, std::memory_order_relaxed);
+    g_metrics.loopEnd.store(m_analysis ? m_analysis->loopEnd : -1.0f, std::memory_order_relaxed);
+
     // start auto-fading, if applicable
     if ((m_config.fadeOutAt > 0.0f) && !m_autoFadeInitiated && (m_position > m_config.fadeOutAt)) {
         fadeOut();
@@ -558,12 +1015,28 @@ void Application::draw(float dt) {
     }
     m_metaTextY += (1.0f - std::exp2f(scrollAnimationSpeed * dt)) * (m_metaTextTargetY - m_metaTextY);
 
+    // glyphs that were missing from a font file's atlas in the previous
+    // frame are available now, which may change text widths
+    if (m_renderer.updateFont()) { updateLayout(); }
+
+    // everything below the pattern display goes into a layer that may be
+    // rendered at reduced resolution (see the 'render scale' option)
+    m_renderer.beginFrame();
+    m_renderer.beginLayer(false);
+
     // set background color
     uint32_t clearColor = m_mod ? m_config.patternBackground : m_config.emptyBackground;
-    glClearColor(float( clearColor        & 0xFF) * float(1.f/255.f),
-                 float((clearColor >>  8) & 0xFF) * float(1.f/255.f),
-                 float((clearColor >> 16) & 0xFF) * float(1.f/255.f), 1.f);
-    glClear(GL_COLOR_BUFFER_BIT);
+    m_renderer.clear(clearColor);
+
+    // tell the renderer about opaque panels that will be drawn later,
+    // so it can skip the parts of the background image and logo below them
+    m_renderer.clearOccluders();
+    if (m_infoVisible && ((m_config.infoBackground >> 24) == 0xFFu)) {
+        m_renderer.addOccluder(0, 0, m_metaStartX, m_infoEndY);
+    }
+    if (m_metaVisible && ((m_config.metaBackground >> 24) == 0xFFu)) {
+        m_renderer.addOccluder(m_metaStartX, 0, m_screenSizeX, m_screenSizeY);
+    }
 
     // draw background image
     m_renderer.bitmap(m_background.x0, m_background.y0, m_background.x1, m_background.y1, m_background.tex);
@@ -573,12 +1046,62 @@ void Application::draw(float dt) {
                     m_mod ? m_config.patternLogoColor : m_config.emptyLogoColor,
                     m_usedLogoTex);
 
+    // draw spectrum analyzer
+    if (m_mod && m_spectrumVisible && playing() && !m_endReached && (m_spectrumHeight > 0.0f)) {
+        const float* levels = m_spectrum.getLevels();
+        if (levels) {
+            TRACE_SCOPE("draw: spectrum analyzer");
+            int bands = m_spectrum.bands();
+            int x0 = m_pdBarStartX, dx = m_pdBarEndX - m_pdBarStartX;
+            int gap = (dx >= (bands * 4)) ? 1 : 0;
+            for (int band = 0;  band < bands;  ++band) {
+                if (levels[band] <= 0.0f) { continue; }
+                m_renderer.box(x0 + band * dx / bands, m_pdTextY0 - int(levels[band] * m_spectrumHeight + 0.5f),
+                               x0 + (band + 1) * dx / bands - gap, m_pdTextY0,
+                               m_config.spectrumUpperColor,
+                               m_config.spectrumLowerColor);
+            }
+        }
+    }
+
+    // draw channel oscilloscopes
+    if (m_mod && m_scopesVisible && playing() && !m_endReached && (m_scopeHeight > 0.0f)) {
+        m_scopes.update(double(m_position));
+        const float* windows = m_scopes.windows();
+        if (windows) {
+            TRACE_SCOPE("draw: channel scopes");
+            // one box per pixel column, spanning the signal's range within
+            // that column (plus one pixel, so flat lines are visible);
+            // scopes of channel groups span all of the group's columns
+            constexpr int ws = ChannelScopes::WindowSize;
+            float yc = float(m_pdTextY0) - m_scopeHeight * 0.5f;
+            float ys = m_scopeHeight * 0.5f * m_config.scopeGain;
+            int gs = m_scopes.groupSize();
+            for (int s = 0;  s < m_scopes.numScopes();  ++s) {
+                int first = s * gs, last = std::min((s + 1) * gs, m_numChannels);
+                if (last <= first) { break; }
+                const float* w = &windows[s * ws];
+                int x0 = m_pdChannelX0 + first * m_pdChannelDX + 1;
+                int width = std::max(1, (last - first - 1) * m_pdChannelDX + m_pdChannelWidth - 2);
+                for (int x = 0;  x < width;  ++x) {
+                    int i0 = x * ws / width, i1 = std::max(i0 + 1, (x + 1) * ws / width);
+                    float vMin = w[i0], vMax = w[i0];
+                    for (int i = i0 + 1;  i < i1;  ++i) { vMin = std::min(vMin, w[i]);  vMax = std::max(vMax, w[i]); }
+                    vMin = std::max(vMin * ys, -m_scopeHeight * 0.5f);
+                    vMax = std::min(vMax * ys,  m_scopeHeight * 0.5f);
+                    m_renderer.box(x0 + x, int(yc - vMax), x0 + x + 1, int(yc - vMin) + 1, m_config.scopeColor);
+                }
+            }
+        }
+    }
+
     // draw VU meters
-    if (m_mod && m_vuVisible && m_sys.isPlaying() && !m_endReached
+    if (m_mod && m_vuVisible && playing() && !m_endReached
     && (m_vuHeight > 0.0f) && ((m_config.vuLowerColor | m_config.vuUpperColor) & 0xFF000000u)) {
+        TRACE_SCOPE("draw: VU meters");
         for (int ch = 0;  ch < m_numChannels;  ++ch) {
             int x = m_pdChannelX0 + ch * m_pdChannelDX;
-            float vu = std::min(1.0f, m_mod->get_current_channel_vu_mono(ch)) * fadeAlpha;
+            float vu = std::min(1.0f, m_playVU[size_t(ch)].load(std::memory_order_relaxed)) * fadeAlpha;
             if (vu > 0.0f) {
                 m_renderer.box(x, m_pdTextY0 - int(vu * m_vuHeight + 0.5f),
                                x + m_pdNoteWidth, m_pdTextY0,
@@ -588,12 +1111,20 @@ void Application::draw(float dt) {
         }
     }
 
+    // the pattern display is always drawn at full resolution
+    m_renderer.endLayer();
+
     // draw pattern display
     if (m_mod) {
+        TRACE_SCOPE("draw: pattern display");
         uint32_t barColor = m_renderer.extraAlpha(m_config.patternBarBackground, fadeAlpha);
         m_renderer.box(m_pdBarStartX, m_pdTextY0, m_pdBarEndX, m_pdTextY0 + m_pdTextSize,
                        barColor, barColor, false, m_pdBarRadius);
         CacheItem tempItem;
+        #if USE_PATTERN_CACHE
+            uint64_t cacheHits = 0u, cacheMisses = 0u;
+            if (m_cachedPattern != m_currentPattern) { switchPatternCache(); }
+        #endif
         for (int dRow = -m_pdRows;  dRow <= m_pdRows;  ++dRow) {
             int row = dRow + m_currentRow;
             if ((row < 0) || (row >= m_patternLength)) { continue; }
@@ -607,40 +1138,54 @@ void Application::draw(float dt) {
                 float x = float(m_pdChannelX0 + ch * m_pdChannelDX);
                 bool pipe = (m_pdPosChars > 0) || (ch > 0);
                 #if USE_PATTERN_CACHE
-                    CacheKey key = makeCacheKey(m_currentPattern, row, ch);
-                    CacheItem *item;
-                    auto entry = m_patternCache.find(key);
-                    if (entry == m_patternCache.end()) {
-                        formatPatternDataCell(tempItem, m_currentPattern, row, ch);
-                        m_patternCache[key] = tempItem;
-                        item = &tempItem;
+                    size_t index = size_t(row) * size_t(m_numChannels) + size_t(ch);
+                    if (index >= m_patternCache.size()) { continue; }
+                    CacheItem& item = m_patternCache[index];
+                    if (item.text[0]) {
+                        ++cacheHits;
                     } else {
-                        item = &entry->second;
+                        // not prefetched (only happens after jumps that
+                        // couldn't be predicted from the order list)
+                        formatPatternDataCell(item, m_currentPattern, row, ch);
+                        ++cacheMisses;
+                        steady = false;
                     }
-                    drawPatternDisplayCell(x, y, item->text, item->attr, alpha, pipe);
+                    drawPatternDisplayCell(x, y, item.text, item.attr, alpha, pipe);
                 #else
                     formatPatternDataCell(tempItem, m_currentPattern, row, ch);
                     drawPatternDisplayCell(x, y, tempItem.text, tempItem.attr, alpha, pipe);
                 #endif
             }
         }
+        #if USE_PATTERN_CACHE
+            constexpr auto rlx = std::memory_order_relaxed;
+            g_metrics.patternCacheHits.store(g_metrics.patternCacheHits.load(rlx) + cacheHits, rlx);
+            g_metrics.patternCacheMisses.store(g_metrics.patternCacheMisses.load(rlx) + cacheMisses, rlx);
+            g_metrics.patternCacheEntries.store(m_patternCache.size(), rlx);
+            prefetchAllocs = prefetchPatternCache();
+        #endif
     }
 
+    // everything on top of the pattern display goes into another layer
+    m_renderer.beginLayer(true);
+
     // draw channel names
     if (m_namesVisible && namesValid()) {
+        TRACE_SCOPE("draw: channel names");
         for (int ch = 0;  ch < m_numChannels;  ++ch) {
             if (m_channelNames[ch].empty()) { continue; }
             int x = m_pdChannelX0 + ch * m_pdChannelDX;
             m_renderer.box(x, m_channelNameBarStartY, x + m_pdChannelWidth, m_screenSizeY,
                            m_config.channelNameUpperColor, m_config.channelNameLowerColor);
             m_renderer.text(float(x) + m_channelNameOffsetX, float(m_channelNameTextY), float(m_pdTextSize),
-                            m_channelNames[ch].substr(0, m_pdChannelChars).c_str(), Align::Center,
+                            std::string_view(m_channelNames[ch]).substr(0, size_t(m_pdChannelChars)), Align::Center,
                             m_config.channelNameTextColor);
         }
     }
 
     // draw info box
     if (m_infoVisible) {
+        TRACE_SCOPE("draw: info box");
         m_renderer.box(0, 0, m_metaStartX, m_infoEndY, m_config.infoBackground);
         if (m_infoShadowEndY > m_infoEndY) {
             m_renderer.box(0, m_infoEndY, m_screenSizeX, m_infoShadowEndY, m_config.shadowColor, m_config.shadowColor & 0x00FFFFFFu, false);
@@ -660,7 +1205,8 @@ void Application::draw(float dt) {
                 char suffix[20];
                 int sec = int(m_position);
                 snprintf(suffix, 20, " (%d:%02d)", sec / 60, sec % 60);
-                m_renderer.text(float(m_infoKeyX), float(m_infoDetailsY), float(m_infoDetailsSize), (m_details + suffix).c_str(), 0, m_config.infoDetailsColor);
+                float x = m_renderer.text(float(m_infoKeyX), float(m_infoDetailsY), float(m_infoDetailsSize), m_details.c_str(), 0, m_config.infoDetailsColor);
+                m_renderer.text(x, float(m_infoDetailsY), float(m_infoDetailsSize), suffix, 0, m_config.infoDetailsColor);
             } else {
                 m_renderer.text(float(m_infoKeyX), float(m_infoDetailsY), float(m_infoDetailsSize), m_details.c_str(), 0, m_config.infoDetailsColor);
             }
@@ -674,11 +1220,39 @@ void Application::draw(float dt) {
                            m_config.progressOuterColor, m_config.progressOuterColor, false, m_progSize);
             m_renderer.box(m_progX0 + m_progInnerDXY, m_progY0 + m_progInnerDXY, m_progPosX0 + int(std::min(m_position / m_duration, 1.0f) * float(m_progPosDX) + 0.5f), m_progY1 - m_progInnerDXY,
                            m_config.progressInnerColor, m_config.progressInnerColor, false, m_progSize);
+            if (m_analysis && m_config.progressWaveform && !m_analysis->wave.empty()) {
+                // waveform overview
+                int y0 = m_progY0 + m_progInnerDXY, y1 = m_progY1 - m_progInnerDXY;
+                float yc = float(y0 + y1) * 0.5f, ys = float(y1 - y0) * (0.5f / 127.0f);
+                float xs = float(m_progPosDX) * m_analysis->waveColumnTime / m_duration;
+                int xEnd = m_progPosX0 + m_progPosDX;
+                const auto& wave = m_analysis->wave;
+                for (size_t i = 0u;  i < wave.size();  ++i) {
+                    int x0 = m_progPosX0 + int(float(i) * xs + 0.5f);
+                    if (x0 >= xEnd) { break; }
+                    int x1 = (i + 1u < wave.size()) ? std::min(xEnd, m_progPosX0 + int(float(i + 1u) * xs + 0.5f)) : xEnd;
+                    x1 = std::max(x1, x0 + 1);
+                    const auto& col = wave[i];
+                    m_renderer.box(x0, int(yc - float(col.max) * ys), x1, int(yc - float(col.min) * ys) + 1, m_config.progressWavePeakColor);
+                    m_renderer.box(x0, int(yc - float(col.rms) * ys), x1, int(yc + float(col.rms) * ys) + 1, m_config.progressWaveRMSColor);
+                }
+            }
+            if (m_analysis && (m_config.progressOrderColor & 0xFF000000u)) {
+                // order boundary marks
+                int y0 = m_progY0 + m_progInnerDXY, y1 = m_progY1 - m_progInnerDXY;
+                for (float t : m_analysis->orderStarts) {
+                    if (t <= 0.0f) { continue; }
+                    if (t >= m_duration) { break; }
+                    int x = m_progPosX0 + int(t / m_duration * float(m_progPosDX) + 0.5f) - (m_progMarkWidth >> 1);
+                    m_renderer.box(x, y0, x + m_progMarkWidth, y1, m_config.progressOrderColor);
+                }
+            }
         }
     }
 
     // draw metadata sidebar
     if (m_metaVisible) {
+        TRACE_SCOPE("draw: metadata");
         m_renderer.box(m_metaStartX, 0, m_screenSizeX, m_screenSizeY, m_config.metaBackground);
         if (m_metaShadowStartX < m_metaStartX) {
             m_renderer.box(m_metaShadowStartX, 0, m_metaStartX, m_screenSizeY, m_config.shadowColor & 0x00FFFFFFu, m_config.shadowColor, true);
@@ -738,72 +1312,90 @@ void Application::draw(float dt) {
         textScaleDemo(60, 20, m_screenSizeX - 10, Align::Right);
     #endif
 
+    m_renderer.endLayer();
+
     // handle ImGui stuff
+    TRACE_SCOPE("draw: UI and flush");
     if (m_showConfig)   { uiConfigWindow(); }
     if (m_showHelp)     { uiHelpWindow(); }
+    if (m_showMemory)   { uiMemoryWindow(); }
     #ifndef NDEBUG
         if (m_showDemo) { ImGui::ShowDemoWindow(&m_showDemo); }
     #endif
 
     // done
     m_renderer.flush();
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
-void Application::formatPatternDataCell(CacheItem& dest, int pat, int row, int ch) const {
-    if (!m_mod) {
-        dest.text[0] = dest.attr[0] = '\0';
-        return;
-    }
-
-    // use OpemMPT's built-in formatter for a start
-    ::strcpy(dest.text,    m_mod->format_pattern_row_channel(pat, row, ch, m_pdChannelChars).c_str());
-    ::strcpy(dest.attr, m_mod->highlight_pattern_row_channel(pat, row, ch, m_pdChannelChars).c_str());
-    if (int(strlen(dest.text)) != m_pdChannelChars) {
-        // if OpenMPT produced an unexpected number of characters, stop all further analysis
-        return;
+    m_renderer.endFrame(dt);
+
+    // check for heap allocations in steady-state frames
+    // (except those made by OpenMPT while formatting the next pattern,
+    // which can't be avoided, but are spread over many frames); ImGui
+    // windows are covered as well, but not in the frame they open in
+    uint8_t uiWindows = (m_showConfig ? 1u : 0u) | (m_showHelp ? 2u : 0u) | (m_showMemory ? 4u : 0u) | (m_showDemo ? 8u : 0u);
+    m_frameAllocations = AllocCounter::count() - allocsAtStart - prefetchAllocs;
+    m_frameSteady = steady && m_mod && (m_mod == modAtStart)
+                 && playing() && !m_endReached && !m_scanning
+                 && (uiWindows == m_frameUIWindows);
+    m_frameUIWindows = uiWindows;
+    if (AllocCounter::Enabled && m_frameSteady && m_frameAllocations) {
+        Dprintf("WARNING: %d heap allocation(s) in steady-state frame\n", int(m_frameAllocations));
     }
+}
 
-    // helper function: check if a string contains useful information (not just dots and spaces)
-    auto hasData = [] (const char* s) -> bool {
-        while (*s) {
-            if ((*s != ' ') && (*s != '.')) { return true; }
-            ++s;
+void Application::switchPatternCache() {
+    #if USE_PATTERN_CACHE
+        m_cachedPattern = m_currentPattern;
+        if (m_prefetchPattern == m_currentPattern) {
+            // the prediction was right; rows the prefetcher didn't get to
+            // yet are still marked as not formatted
+            m_patternCache.swap(m_prefetchCache);
+        } else {
+            // resize() won't reallocate, as the capacity has been reserved in loadModule()
+            m_patternCache.resize(size_t(std::max(0, m_patternLength)) * size_t(std::max(0, m_numChannels)));
+            for (auto& item : m_patternCache) { item.text[0] = item.attr[0] = '\0'; }
         }
-        return false;
-    };
-    // helper function: copy a single character from a C++ string iff it's not empty
-    auto copyChar = [] (char* sOut, const std::string& sIn) {
-        if (!sIn.empty()) { *sOut = sIn[0]; }
-    };
+        m_prefetchPattern = -1;
+    #endif
+}
 
-    // helper function: query specific information from OpenMPT to override
-    // an otherwise empty tail of a cell text
-    auto updateTail = [&] (openmpt::module::command_index effectTypeIndex, openmpt::module::command_index paramIndex) {
-        // if there's already valid data in the tail, don't change it
-        if (hasData(&dest.text[m_pdChannelChars - 3])) { return; }
-        // fill in the effect parameter first (will be dots if there's no effect)
-        ::strcpy(&dest.text[m_pdChannelChars - 2],    m_mod->format_pattern_row_channel_command(pat, row, ch, paramIndex).c_str());
-        ::strcpy(&dest.attr[m_pdChannelChars - 2], m_mod->highlight_pattern_row_channel_command(pat, row, ch, paramIndex).c_str());
-        // if there was a parameter, fill in the effect type too
-        if (hasData(&dest.text[m_pdChannelChars - 2])) {
-            copyChar(&dest.text[m_pdChannelChars - 3],    m_mod->format_pattern_row_channel_command(pat, row, ch, effectTypeIndex));
-            copyChar(&dest.attr[m_pdChannelChars - 3], m_mod->highlight_pattern_row_channel_command(pat, row, ch, effectTypeIndex));
+uint64_t Application::prefetchPatternCache() {
+    uint64_t allocsAtStart = AllocCounter::count();
+    #if USE_PATTERN_CACHE
+        // predict the next pattern from the order list, skipping
+        // "+++" separators (which have no rows)
+        int numOrders = m_mod->get_num_orders();
+        int pat = -1, rows = 0;
+        for (int order = m_currentOrder + 1;  (order < numOrders) && (order <= (m_currentOrder + 16));  ++order) {
+            pat = m_mod->get_order_pattern(order);
+            rows = m_mod->get_pattern_num_rows(pat);
+            if (rows > 0) { break; }
         }
-    };
+        if ((rows <= 0) || (pat == m_currentPattern) || (m_numChannels <= 0)) { return 0u; }
+        if (pat != m_prefetchPattern) {
+            // resize() won't reallocate, as the capacity has been reserved in loadModule()
+            m_prefetchPattern = pat;
+            m_prefetchRow = 0;
+            m_prefetchCache.resize(size_t(rows) * size_t(m_numChannels));
+            for (auto& item : m_prefetchCache) { item.text[0] = item.attr[0] = '\0'; }
+        }
+        if (m_prefetchRow >= rows) { return 0u; }
 
-    // in the more compact formats, replace the last row by the effect
-    // if there is nothing else to show there
-    if (m_pdChannelChars >= 3) {
-        updateTail(openmpt::module::command_index::command_effect, openmpt::module::command_index::command_parameter);
-    }
-    // in the most compact format, try the volume command to
-    if (m_pdChannelChars == 3) {
-        updateTail(openmpt::module::command_index::command_volumeffect, openmpt::module::command_index::command_volume);
-    }
+        // format a few rows
+        TRACE_SCOPE("prefetchPatternCache");
+        int rowEnd = std::min(rows, m_prefetchRow + std::max(1, prefetchCellsPerFrame / m_numChannels));
+        size_t index = size_t(m_prefetchRow) * size_t(m_numChannels);
+        for (int row = m_prefetchRow;  row < rowEnd;  ++row) {
+            for (int ch = 0;  ch < m_numChannels;  ++ch) {
+                formatPatternDataCell(m_prefetchCache[index++], pat, row, ch);
+            }
+        }
+        m_prefetchRow = rowEnd;
+    #endif
+    return AllocCounter::count() - allocsAtStart;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
 void Application::drawPatternDisplayCell(float x, float y, const char* text, const char* attr, float alpha, bool pipe) {
     const float sz = float(m_pdTextSize);
     if (pipe) {
@@ -839,6 +1431,7 @@ void Application::drawPatternDisplayCell(float x, float y, const char* text, con
 ///// module loading
 
 void Application::unloadModule() {
+    TRACE_SCOPE("unloadModule");
     m_sys.pause();
     m_cancelScanning = true;
     if (m_scanThread) {
@@ -847,13 +1440,20 @@ void Application::unloadModule() {
         m_scanThread = nullptr;
     }
     m_scanning = false;
+    m_scopes.stop();
+    m_seeker.stop();
     m_config.loudness = InvalidLoudness;
     {
         AudioMutexGuard mtx_(m_sys);
+        m_playMod = nullptr;
+        std::vector<std::atomic<float>>().swap(m_playVU);
         delete m_mod;
         m_mod = nullptr;
         m_mod_data.clear();
     }
+    m_modFileSize = m_modInstanceMemory = 0u;
+    m_analysis.reset();
+    g_metrics.setFilename("");
     m_fullpath.clear();
     m_track[0] = '\0';
     m_info.clear();
@@ -864,6 +1464,14 @@ void Application::unloadModule() {
     m_channelNames.clear();
     m_numChannels = 0;
     m_currentPattern = -1;
+    #if USE_PATTERN_CACHE
+        m_patternCache.clear();
+        m_patternCache.shrink_to_fit();
+        m_cachedPattern = -1;
+        m_prefetchCache.clear();
+        m_prefetchCache.shrink_to_fit();
+        m_prefetchPattern = -1;
+    #endif
     m_patternLength = 0;
     m_autoFadeInitiated = true;
     m_mayAutoAdvance = false;
@@ -876,6 +1484,7 @@ void Application::unloadModule() {
 }
 
 bool Application::loadModule(const char* path, bool forScanning) {
+    TRACE_SCOPE("loadModule");
     // unload currenly loaded module first
     unloadModule();
 
@@ -939,58 +1548,54 @@ bool Application::loadModule(const char* path, bool forScanning) {
 
     // load file into memory
     Dprintf("loading module: %s\n", m_fullpath.c_str());
-    FILE *f = fopen(m_fullpath.c_str(), "rb");
-    if (!f) { return fail("could not open file"); }
-    // fopen() may still succeed on directories, giving us a broken file
-    // descriptor with erratic behavior; try to detect this as best as we can
-    if (fseek(f, 0, SEEK_END) != 0) { fclose(f); return fail("invalid file"); }
-    size_t size = size_t(ftell(f));
-    if (size >= (size_t(-1) >> 1)) { fclose(f); return fail("invalid file"); }
-    if (size >= (64u << 20)) { fclose(f); return fail("file too large"); }  // 64 MiB ought to be enough for everybody
-    m_mod_data.resize(size);
-    fseek(f, 0, SEEK_SET);
-    if (fread(m_mod_data.data(), 1, size, f) != size) { fclose(f); return fail("could not read file"); }
-    fclose(f);
+    uint64_t tPhase = Trace::now();
+    const char* loadError = ModUtil::loadFile(m_fullpath.c_str(), m_mod_data);
+    Trace::complete("loadModule: read file", tPhase, Trace::now());
+    if (loadError) { return fail(loadError); }
 
     // load and setup OpenMPT instance
     AudioMutexGuard mtx_(m_sys);
-    std::map<std::string, std::string> ctls;
-    ctls["play.at_end"] = (m_config.loop && !forScanning) ? "continue" : "stop";
-    switch (m_config.filter) {
-        case FilterMethod::Auto:
-        case FilterMethod::Amiga:
-            ctls["render.resampler.emulate_amiga"] = "1";
-            break;
-        case FilterMethod::A500:
-            ctls["render.resampler.emulate_amiga"] = "1";
-            ctls["render.resampler.emulate_amiga_type"] = "a500";
-            break;
-        case FilterMethod::A1200:
-            ctls["render.resampler.emulate_amiga"] = "1";
-            ctls["render.resampler.emulate_amiga_type"] = "a1200";
-            break;
-        default: break;  // no Amiga resampler -> set later using set_render_param
-    }
-    try {
-        m_mod = new openmpt::module(m_mod_data, std::clog, ctls);
-    } catch (openmpt::exception& e) {
-        return fail(std::string("invalid module - ") + e.what());
-    }
-    if (!m_mod) { return fail("invalid module data"); }
+    std::string modError;
+    tPhase = Trace::now();
+    m_mod = ModUtil::createModule(m_mod_data, m_config, m_config.loop && !forScanning, modError);
+    Trace::complete("loadModule: parse module", tPhase, Trace::now());
+    if (!m_mod) { return fail(modError); }
     Dprintf("module loaded successfully.\n");
-    switch (m_config.filter) {
-        case FilterMethod::Auto:   m_mod->set_render_param(openmpt::module::render_param::RENDER_INTERPOLATIONFILTER_LENGTH, 0); break;
-        case FilterMethod::None:   m_mod->set_render_param(openmpt::module::render_param::RENDER_INTERPOLATIONFILTER_LENGTH, 1); break;
-        case FilterMethod::Linear: m_mod->set_render_param(openmpt::module::render_param::RENDER_INTERPOLATIONFILTER_LENGTH, 2); break;
-        case FilterMethod::Cubic:  m_mod->set_render_param(openmpt::module::render_param::RENDER_INTERPOLATIONFILTER_LENGTH, 4); break;
-        case FilterMethod::Sinc:   m_mod->set_render_param(openmpt::module::render_param::RENDER_INTERPOLATIONFILTER_LENGTH, 8); break;
-        default: break;  // Amiga -> no need to set up anything
-    }
-    m_mod->set_render_param(openmpt::module::render_param::RENDER_STEREOSEPARATION_PERCENT, m_config.stereoSeparation);
-    m_mod->set_render_param(openmpt::module::render_param::RENDER_VOLUMERAMPING_STRENGTH,   m_config.volumeRamping);
-    if (!forScanning) { updateGain(); }
+    m_modFileSize = m_mod_data.size();
+    m_modInstanceMemory = ModUtil::estimateModuleMemory(m_mod, m_modFileSize);
+    g_metrics.setFilename(m_fullpath);
+    m_audioCommands.clear();  // any pending commands were meant for the previous module
+    m_playMod = m_mod;
+    m_loopEnd = -1.0f;
+    std::vector<std::atomic<float>>(size_t(std::max(0, m_mod->get_num_channels()))).swap(m_playVU);
+    m_xfadeActive = false;
+    m_renderGain = 0.0f;
+    m_rampGain = m_rampTarget = 1.0f;
+    m_rampRemain = 0;
+    m_outputPaused = m_paused = false;
+    if (!forScanning) {
+        m_renderGain = targetGain();
+        Dprintf("master gain: %.2f dB\n", m_renderGain);
+        m_mod->set_render_param(openmpt::module::render_param::RENDER_MASTERGAIN_MILLIBEL, int(m_renderGain * 100.0f + 0.5f));
+        m_analysisStore.request(m_fullpath);
+        if (m_sys.headless() || m_eventLog.replaying()) {
+            // seeks snap to rows once the time index is available; to keep
+            // replays deterministic, it must be available right from the start
+            m_analysis = m_analysisStore.wait(m_fullpath);
+        } else {
+            m_analysis = m_analysisStore.get(m_fullpath);
+        }
+        if (m_analysis) { m_loopEnd = m_analysis->loopEnd; }
+        if (m_config.backgroundSeek && !m_sys.headless()) {
+            // (not in the headless runner, where seeks must be synchronous
+            // to keep event log replays deterministic)
+            m_seeker.start(m_mod_data, m_config, m_config.loop);
+            m_xfadeBuffer.resize(size_t(float(m_sampleRate) * declickRampTime + 1.5f) * 2u);
+        }
+    }
 
     // get info box metadata
+    tPhase = Trace::now();
     std::string artist(m_config.artist.empty() ? m_mod->get_metadata("artist") : m_config.artist);
     std::string title (m_config.title.empty()  ? m_mod->get_metadata("title")  : m_config.title);
     if (!m_config.autoHideFileName || (artist.empty() && title.empty())) {
@@ -1020,7 +1625,7 @@ bool Application::loadModule(const char* path, bool forScanning) {
     }
     m_shortDetails.emplace_back(std::to_string(m_mod->get_num_samples()) + " smp");
      m_longDetails.emplace_back(std::to_string(m_mod->get_num_samples()) + " samples");
-    int kBytes = int((m_mod_data.size() + 1023u) >> 10);  // actually kibibytes
+    int kBytes = int((m_modFileSize + 1023u) >> 10);  // actually kibibytes
     m_shortDetails.emplace_back(std::to_string(kBytes) + "KB");
      m_longDetails.emplace_back(std::to_string(kBytes) + "K bytes");
     int sec = int(m_mod->get_duration_seconds());
@@ -1073,6 +1678,7 @@ bool Application::loadModule(const char* path, bool forScanning) {
         }
     }
     m_metadata.ingest(meta2);
+    Trace::complete("loadModule: metadata", tPhase, Trace::now());
 
     // get channel names
     m_numChannels = m_mod->get_num_channels();
@@ -1089,6 +1695,16 @@ bool Application::loadModule(const char* path, bool forScanning) {
         m_channelNames.clear();
     }
 
+    // reserve pattern cache for the largest pattern
+    #if USE_PATTERN_CACHE
+        int maxRows = 0;
+        for (int pat = m_mod->get_num_patterns() - 1;  pat >= 0;  --pat) {
+            maxRows = std::max(maxRows, m_mod->get_pattern_num_rows(pat));
+        }
+        m_patternCache.reserve(size_t(maxRows) * size_t(m_numChannels));
+        m_prefetchCache.reserve(size_t(maxRows) * size_t(m_numChannels));
+    #endif
+
     // done!
     m_sys.setWindowTitle((PathUtil::basename(m_fullpath) + " - " + baseWindowTitle).c_str());
     m_duration = std::max(float(m_mod->get_duration_seconds()), 0.001f);
@@ -1096,8 +1712,12 @@ bool Application::loadModule(const char* path, bool forScanning) {
     m_metaTextAutoScroll = m_config.autoScrollEnabled;
     m_fadeActive = m_autoFadeInitiated = m_endReached = m_cancelScanning = false;
     m_scanning = forScanning;
+    publishPlayState();
     updateLayout(true);
-    if (m_config.autoPlay && !forScanning) { m_sys.play(); }
+    if (m_config.autoPlay && !forScanning) {
+        g_metrics.latency.startAudio();
+        m_sys.play();
+    }
     m_mayAutoAdvance = !forScanning && m_config.autoAdvance;
     return true;
 }
@@ -1156,11 +1776,14 @@ void Application::startScan(const char* specificFile) {
 }
 
 void Application::runScan() {
+    Trace::setThreadName("loudness scan");
+    TRACE_SCOPE("runScan");
     int16_t buffer[scanBufferSize * 2];
     m_config.loudness = InvalidLoudness;
     ebur128_state *r128 = ebur128_init(2, m_sampleRate, EBUR128_MODE_I);
     if (!r128) { return; }
     while (!m_cancelScanning && !m_endReached && m_mod) {
+        TRACE_SCOPE("scan chunk");
         //m_sys.lockAudioMutex();  // <- would be more correct, but we can also generate deadlocks this way, so don't do it
         size_t count = m_mod->read_interleaved_stereo(m_sampleRate, scanBufferSize, buffer);
         //m_sys.unlockAudioMutex();
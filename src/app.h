@@ -11,11 +11,9 @@
 #include <utility>
 #include <vector>
 #include <string>
-#if USE_PATTERN_CACHE
-    #include <unordered_map>
-#endif
 #include <thread>
 #include <atomic>
+#include <memory>
 
 #include "system.h"
 #include "renderer.h"
@@ -23,6 +21,14 @@
 #include "pathutil.h"
 #include "numset.h"
 #include "config.h"
+#include "modutil.h"
+#include "control.h"
+#include "eventlog.h"
+#include "analysis.h"
+#include "spectrum.h"
+#include "scopes.h"
+#include "mpscqueue.h"
+#include "seeker.h"
 
 namespace openmpt {
     class module;
@@ -38,10 +44,59 @@ class Application {
     std::atomic_bool m_clipped = false;
     openmpt::module* m_mod = nullptr;
     std::vector<std::byte> m_mod_data;
+    size_t m_modFileSize = 0;         //!< size of the module file (m_mod_data may be evicted)
+    size_t m_modInstanceMemory = 0;   //!< estimated memory used by m_mod
+    bool m_memoryOverBudget = false;  //!< memory budget exceeded even after evicting everything possible
     std::vector<uint32_t> m_playableExts;
     std::thread* m_scanThread = nullptr;
+    AnalysisStore m_analysisStore;
+    SpectrumAnalyzer m_spectrum;
+    ChannelScopes m_scopes;
+    std::shared_ptr<const ModuleAnalysis> m_analysis;  //!< analysis results of the current module, if available yet
+    uint32_t m_analysisGeneration = 0;
     float m_instanceGain = 0.0f;
 
+    // commands from the UI to the audio thread; the audio thread executes
+    // them at the start of each buffer, so the UI never waits for it
+    struct AudioCommand {
+        enum class Type : uint8_t {
+            SetGain,    //!< change master gain to 'value' dB (with a ramp)
+            Seek,       //!< seek to 'value' seconds
+            SeekOrder,  //!< seek to row 'row' of order 'value'
+            Fade,       //!< start fading out
+            Pause,      //!< ramp down, then output silence
+            Resume,     //!< cancel pause and fade-out, ramp up again
+            SetLoopEnd, //!< set the time (in seconds) at which the song loops, as found by the analysis
+        } type;
+        float value;
+        int row;
+    };
+    MPSCQueue<AudioCommand, 64> m_audioCommands;
+    StandbySeeker m_seeker;
+    int m_seekOrder = -1;        //!< target order of the last seek requested from the seeker (-1 = seek by time)
+    float m_seekTime = -1.0f;    //!< target time of the last seek requested from the seeker (-1 = not known)
+
+    // audio thread state
+    std::atomic<openmpt::module*> m_playMod { nullptr };  //!< instance being played: m_mod, or the seeker's instance (never used by the UI)
+    float m_renderGain = 0.0f;  //!< master gain currently set in OpenMPT, in dB
+    float m_rampGain = 1.0f;    //!< current de-click ramp factor
+    float m_rampTarget = 1.0f;  //!< final ramp factor (0.0 = pause after the ramp)
+    float m_rampStep = 0.0f;
+    int m_rampRemain = 0;       //!< ramp length remaining, in samples
+    bool m_outputPaused = false;
+    std::vector<int16_t> m_xfadeBuffer;  //!< previous instance's output, to crossfade after switching instances
+    size_t m_xfadePos = 0;
+    bool m_xfadeActive = false;
+    bool m_fadeActive = false;
+    int m_fadeGain, m_fadeRate;
+    float m_loopEnd = -1.0f;    //!< time at which the song loops, in seconds (negative = unknown)
+
+    // playback state published by the audio thread
+    std::atomic<uint64_t> m_playPos { 0 };     //!< current order, pattern and row, packed into 16 bits each
+    std::atomic<float> m_playTime { 0.0f };    //!< current position in seconds
+    std::atomic<float> m_playFade { -1.0f };   //!< fade-out gain, or negative if not fading
+    std::vector<std::atomic<float>> m_playVU;  //!< per-channel VU levels (resized only under the audio mutex)
+
     // configuration
     std::string m_mainIniFile;
     std::string m_dirIniFile;
@@ -91,6 +146,7 @@ class Application {
     int m_progX0, m_progY0, m_progX1, m_progY1;
     int m_progOuterDXY, m_progInnerDXY, m_progSize;
     int m_progPosX0, m_progPosDX;
+    int m_progMarkWidth;
     int m_metaStartX, m_metaShadowStartX;
     float m_metaTextX, m_metaTextMinY, m_metaTextMaxY;
     int m_pdPosChars, m_pdChannelChars;
@@ -101,7 +157,7 @@ class Application {
     int m_pdBarStartX, m_pdBarEndX, m_pdBarRadius;
     int m_toastTextSize, m_toastY, m_toastDX, m_toastDY;
     int m_channelNameBarStartY, m_channelNameTextY;
-    float m_channelNameOffsetX, m_vuHeight;
+    float m_channelNameOffsetX, m_vuHeight, m_spectrumHeight, m_scopeHeight;
     int m_clipX0, m_clipY0, m_clipX1, m_clipY1;
 
     // background image and logo data (texture, layout)
@@ -120,37 +176,70 @@ class Application {
     // current view/playback state
     float m_metaTextY, m_metaTextTargetY;
     bool m_metaTextAutoScroll = true;
-    bool m_infoVisible, m_metaVisible, m_namesVisible, m_vuVisible;
-    bool m_fadeActive = false;
-    int m_fadeGain, m_fadeRate;
-    bool m_autoFadeInitiated = false;
+    bool m_infoVisible, m_metaVisible, m_namesVisible, m_vuVisible, m_spectrumVisible, m_scopesVisible;
+    std::atomic_bool m_autoFadeInitiated = false;
+    bool m_paused = false;  //!< paused with the audio device still running
     bool m_multiScan = false;
     bool m_mayAutoAdvance = false;
     bool m_escapePressedOnce = false;
     float m_clipAlpha = 0.0f;
 
-    // pattern data cache
-    struct CacheItem { char text[16], attr[16]; };
+    // pattern data cache: the cells of the currently displayed pattern, and
+    // of the pattern that is expected to play next; the latter is formatted
+    // a few rows per frame ahead of time, so the frame where the pattern
+    // changes doesn't need to call (and allocate in) OpenMPT's formatting
+    // functions; the storage for both is reserved for the largest pattern
+    // when loading a module
+    using CacheItem = ModUtil::PatternCell;
     #if USE_PATTERN_CACHE
-        using CacheKey = uint32_t;
-        static inline CacheKey makeCacheKey(int pattern, int row, int channel)
-            { return uint32_t((pattern << 20) ^ (row << 10) ^ channel); }
-        std::unordered_map<CacheKey, CacheItem> m_patternCache;
+        std::vector<CacheItem> m_patternCache;   //!< [row * m_numChannels + channel]; empty text = not formatted yet
+        int m_cachedPattern = -1;                //!< pattern in m_patternCache (-1 = none, invalid)
+        std::vector<CacheItem> m_prefetchCache;  //!< same layout as m_patternCache
+        int m_prefetchPattern = -1;              //!< pattern in m_prefetchCache (-1 = none)
+        int m_prefetchRow = 0;                   //!< next row of m_prefetchCache to format
     #endif
 
+    // steady-state allocation check (see alloc_counter.h)
+    uint64_t m_frameAllocations = 0;
+    bool m_frameSteady = false;
+    uint8_t m_frameUIWindows = 0;  //!< bit mask of the ImGui windows open in the last frame
+
     // toast message
     std::string m_toastMessage;
     float m_toastAlpha;
 
+    // remote control
+    ControlServer m_control;
+
+    // input event recording and replay
+    EventLog m_eventLog;
+    double m_eventTime = 0.0;  //!< sum of all frame times so far
+
     // debug/config UI
     bool m_showDemo = false;
     bool m_showHelp = false;
     bool m_showConfig = false;
+    bool m_showMemory = false;
     bool m_uiConfigShowGlobal = true;
 
 public:  // interface from SystemInterface
     explicit inline Application(SystemInterface& sys) : m_sys(sys), m_metadata(m_renderer) {}
 
+    //! number of heap allocations during the last draw() call
+    //! (only valid if TM_COUNT_ALLOCATIONS is enabled)
+    inline uint64_t frameAllocations() const { return m_frameAllocations; }
+    //! whether the last draw() call was a steady-state frame during playback,
+    //! i.e. nothing was loaded or changed and no UI windows were opened
+    inline bool frameSteady() const { return m_frameSteady; }
+    //! whether events are being replayed (see Config::replay)
+    inline bool replayActive()   const { return m_eventLog.replaying(); }
+    //! whether all replayed events have been handled
+    inline bool replayFinished() const { return m_eventLog.replayFinished(); }
+    //! whether animations shall be driven by the frame pacer (see Config::framePacing)
+    inline bool framePacing() const { return m_config.framePacing; }
+    //! the renderer, for statistics
+    inline const TextBoxRenderer& renderer() const { return m_renderer; }
+
     int init(int argc, char* argv[]);
     void draw(float dt);
     void shutdown();
@@ -161,6 +250,7 @@ public:  // interface from SystemInterface
     void handleDropFile(const char* path);
     void handleResize(int w, int h);
     void handleMouseWheel(int delta);
+    void handleMouseClick(int x, int y);
 
 private:  // business logic
     std::string findPlayableSibling(const std::string& base, PathUtil::FindMode mode);
@@ -169,7 +259,22 @@ private:  // business logic
     bool loadModule(const char* path, bool forScanning=false);
     bool loadNextModule(bool reverse=false);
     void changeInstanceGain(float delta);
+    void seekTo(float time);
+    void seekBy(float seconds);
+    void seekOrder(int delta);
+    void requestSeek(float time, int order=-1, int row=0);
+    void switchInstance(openmpt::module* mod, bool stereo, int sampleRate);
+    void updateSpectrumAnalyzer();
+    void updateChannelScopes();
     void updateGain();
+    float targetGain() const;
+    void setPaused(bool paused);
+    inline bool playing() { return m_sys.isPlaying() && !m_paused; }
+    void sendAudioCommand(AudioCommand::Type type, float value=0.0f, int row=0);
+    void processAudioCommands(int sampleRate);
+    void startRamp(float from, float to, int sampleRate);
+    void startFade(int sampleRate);
+    void publishPlayState();
     void cycleBoxVisibility();
     int toPixels(int value) const;
     int toTextSize(int value) const;
@@ -179,7 +284,12 @@ private:  // business logic
     void updateImages();
     void updateImage(ExternalImage& img, const std::string& path, int channels, const char* what);
     void updateLayout(bool resetBoxVisibility=false);
-    void formatPatternDataCell(CacheItem& dest, int pat, int row, int ch) const;
+    void switchPatternCache();
+    uint64_t prefetchPatternCache();
+    void updateMemoryUsage();
+    void enforceMemoryBudget();
+    inline void formatPatternDataCell(CacheItem& dest, int pat, int row, int ch) const
+        { ModUtil::formatPatternCell(dest, m_mod, pat, row, ch, m_pdChannelChars); }
     void drawPatternDisplayCell(float x, float y, const char* text, const char* attr, float alpha=1.0f, bool pipe=true);
     static void formatPosition(int order, int pattern, int row, char* text, char* attr, int size);
     void addMetadataGroup(TextArea& block, const std::vector<std::string>& data, const char* title, bool numbering=true, int indexStart=1);
@@ -193,10 +303,13 @@ private:  // business logic
     void toastVersion();
     void toastPosition();
     void fadeOut();
+    void handleRemoteCommands();
+    void replayEvents();
     void startScan(const char* specificFile=nullptr);
     void runScan();
     void stopScan();
     void uiHelpWindow();
     void uiConfigWindow();
+    void uiMemoryWindow();
     void uiSaveConfig();
 };
@@ -12,6 +12,7 @@
 #include "config.h"
 #include "renderer.h"
 #include "textarea.h"
+#include "trace.h"
 #include "app.h"
 
 int Application::textWidth(int size, const char* text) const {
@@ -30,6 +31,7 @@ int Application::toTextSize(int value) const {
 }
 
 void Application::updateLayout(bool resetBoxVisibility) {
+    TRACE_SCOPE("updateLayout");
     m_screenSizeX = m_renderer.viewportWidth();
     m_screenSizeY = m_renderer.viewportHeight();
     m_renderer.setFont(m_config.font.c_str());
@@ -40,6 +42,8 @@ void Application::updateLayout(bool resetBoxVisibility) {
         m_metaVisible  = m_config.metaEnabled && metaValid();
         m_namesVisible = m_config.channelNamesEnabled && namesValid();
         m_vuVisible    = m_config.vuEnabled;
+        m_spectrumVisible = m_config.spectrumEnabled;
+        m_scopesVisible = m_config.scopesEnabled;
     } else {
         m_infoVisible  = m_infoVisible  && infoValid();
         m_metaVisible  = m_metaVisible  && metaValid();
@@ -161,6 +165,7 @@ void Application::updateLayout(bool resetBoxVisibility) {
         int innerRadius = m_progSize - (m_progInnerDXY << 1);
         m_progPosX0 = m_progX0 + m_progInnerDXY + innerRadius;
         m_progPosDX = m_progX1 - m_progInnerDXY - m_progPosX0;
+        m_progMarkWidth = std::max(1, toPixels(2));
     }
 
     // set up pattern display geometry -- step 1: define possible formats
@@ -240,6 +245,10 @@ void Application::updateLayout(bool resetBoxVisibility) {
     m_channelNameBarStartY = m_channelNameTextY - cnGap;
     m_channelNameOffsetX = float(m_pdChannelWidth) * 0.5f;
     m_vuHeight = float(toPixels(m_config.vuHeight));
+    m_spectrumHeight = float(toPixels(m_config.spectrumHeight));
+    updateSpectrumAnalyzer();
+    m_scopeHeight = float(toPixels(m_config.scopeHeight));
+    updateChannelScopes();
 
     // set up background image geometry
     if (m_background.tex) {
@@ -314,8 +323,9 @@ void Application::updateLayout(bool resetBoxVisibility) {
 
     // done!
     #if USE_PATTERN_CACHE
-        m_patternCache.clear();
+        m_cachedPattern = m_prefetchPattern = -1;
     #endif
+    updateMemoryUsage();
     Dprintf("updateLayout(): channels=%d pdTextSize=%d pdRows=%d\n", m_numChannels, m_pdTextSize, m_pdRows);
 }
 
@@ -12,6 +12,7 @@
 #include "util.h"
 #include "config.h"
 #include "config_item.h"
+#include "metrics.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -19,6 +20,7 @@ static const char* helpText[] = {
     "F1",                  "show/hide help window",
     "F2",                  "show/hide global configuration window",
     "F3",                  "show/hide file-specific configuration window",
+    "F4",                  "show/hide memory usage",
     "F5",                  "reaload the current module and configuration",
     "F10 or Q",            "quit the application immediately",
     "F11",                 "toggle fullscreen mode",
@@ -26,7 +28,11 @@ static const char* helpText[] = {
     "Space",               "pause / continue playback",
     "Tab",                 "show / hide the info and metadata bars",
     "Enter",               "show / hide the hake VU meters",
+    "Shift+Enter",         "show / hide the spectrum analyzer",
+    "O",                   "show / hide the channel oscilloscopes",
     "Cursor Left/Right",   "seek backward / forward one order",
+    "Ctrl+Left/Right",     "seek backward / forward 10 seconds",
+    "click progress bar",  "seek to that position",
     "PageUp / PageDown",   "load previous / next module in the current directory",
     "Ctrl+Home / Ctrl+End","load first / next module in the current directory",
     "file drag&drop",      "load another module",
@@ -253,3 +259,48 @@ void Application::uiConfigWindow() {
 
     ImGui::End();
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Application::uiMemoryWindow() {
+    const ImGuiViewport* vp = ImGui::GetMainViewport();
+    ImGui::SetNextWindowPos(ImVec2(vp->WorkPos.x + 8.0f, vp->WorkPos.y + 8.0f), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Memory Usage", &m_showMemory, ImGuiWindowFlags_NoNavInputs | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_AlwaysAutoResize)) {
+        static const char* categoryNames[int(MemoryCategory::Count)] = {
+            "module file data",
+            "module instance (est.)",
+            "pattern cache",
+            "metadata text",
+            "textures",
+            "analysis results",
+        };
+        auto row = [] (const char* name, uint64_t bytes) {
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%10.1f KiB", double(bytes) * (1.0 / 1024.0));
+        };
+        if (ImGui::BeginTable("memory", 2, ImGuiTableFlags_SizingFixedFit)) {
+            for (int i = 0;  i < int(MemoryCategory::Count);  ++i) {
+                row(categoryNames[i], g_metrics.getMemory(MemoryCategory(i)));
+            }
+            ImGui::TableNextRow();
+            row("total", g_metrics.memoryTotal());
+            uint64_t budget = g_metrics.memoryBudget;
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted("budget");
+            ImGui::TableNextColumn();
+            if (budget) { ImGui::Text("%10.1f KiB", double(budget) * (1.0 / 1024.0)); }
+            else        { ImGui::TextUnformatted("unlimited"); }
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted("evictions");
+            ImGui::TableNextColumn();
+            ImGui::Text("%10llu", (unsigned long long)g_metrics.memoryEvictions.load());
+            ImGui::EndTable();
+        }
+        if (m_memoryOverBudget) {
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "over budget, nothing left to evict");
+        }
+    }
+    ImGui::End();
+}
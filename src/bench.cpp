@@ -0,0 +1,766 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+// tm_bench: headless benchmark suite for TrackMeister's hot paths,
+//           and deterministic audio rendering regression checker
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include <vector>
+#include <string>
+#include <map>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+
+#include <libopenmpt/libopenmpt.hpp>
+#include <ebur128.h>
+
+#include "util.h"
+#include "pathutil.h"
+#include "config.h"
+#include "modutil.h"
+#include "renderer.h"
+#include "version.h"
+
+#ifndef TM_MIXER_ARCH
+    #define TM_MIXER_ARCH ""
+#endif
+
+constexpr int benchSampleRate = 48000;
+constexpr size_t benchBufferSize = 4096;
+
+////////////////////////////////////////////////////////////////////////////////
+
+//! simple stopwatch
+class Timer {
+    std::chrono::steady_clock::time_point m_start;
+public:
+    inline Timer() : m_start(std::chrono::steady_clock::now()) {}
+    inline double seconds() const
+        { return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count(); }
+};
+
+//! a single named benchmark result
+struct Result {
+    std::string key;
+    double value;
+};
+
+//! benchmark options
+struct Options {
+    std::vector<std::string> inputs;
+    std::string outputFile;
+    std::string baselineFile;
+    std::string iniFile;
+    double tolerance = 10.0;     // percent
+    double renderSeconds = 10.0;  // per module and render setting
+    int iterations = 3;
+    bool audioCheck = false;
+    bool exact = false;
+    double levelTolerance = 0.05;  // dB
+    int jobs = 0;  // 0 = number of CPU cores
+    std::string filters;  // comma-separated list of filter names (empty = all)
+};
+
+//! a module from the corpus, loaded into memory
+struct CorpusItem {
+    std::string path;
+    std::vector<std::byte> data;
+};
+
+static void usage(const char* argv0) {
+    printf("Usage: %s [OPTIONS] <corpus directory or module file>...\n", argv0);
+    printf("Options:\n");
+    printf("  -o, --output FILE     write JSON results into FILE instead of stdout\n");
+    printf("  -b, --baseline FILE   compare against a previously saved JSON result file\n");
+    printf("  -t, --tolerance PCT   allowed deviation from the baseline, in percent (default: 10)\n");
+    printf("  -s, --seconds SEC     seconds of audio to render per module and setting (default: 10)\n");
+    printf("  -n, --iterations N    number of iterations for the micro-benchmarks (default: 3)\n");
+    printf("  -f, --filters LIST    only render with these filters (comma-separated, e.g. 'a500,a1200')\n");
+    printf("  -i, --ini FILE        INI file to use for the configuration benchmark\n");
+    printf("                        (default: tm.ini in the corpus or program directory)\n");
+    printf("Audio regression check mode:\n");
+    printf("  -a, --audio           instead of benchmarking, render every module with every\n");
+    printf("                        filter and stereo separation setting and record hashes and\n");
+    printf("                        levels (-o), or compare against previously recorded ones (-b)\n");
+    printf("  -j, --jobs N          number of rendering threads (default: number of CPU cores)\n");
+    printf("  -l, --level-tol DB    allowed peak/RMS level deviation if hashes differ (default: 0.05)\n");
+    printf("  -x, --exact           treat any hash difference as a failure\n");
+}
+
+static bool parseArgs(int argc, char* argv[], Options& opt) {
+    for (int i = 1;  i < argc;  ++i) {
+        const char* arg = argv[i];
+        auto isOpt = [&] (const char* shortOpt, const char* longOpt) -> bool
+            { return !strcmp(arg, shortOpt) || !strcmp(arg, longOpt); };
+        auto value = [&] () -> const char* {
+            if ((i + 1) >= argc) {
+                fprintf(stderr, "error: option '%s' requires an argument\n", arg);
+                return nullptr;
+            }
+            return argv[++i];
+        };
+        const char* v = nullptr;
+        if (isOpt("-h", "--help")) { usage(argv[0]); exit(0); }
+        else if (isOpt("-o", "--output"))     { if (!(v = value())) { return false; }  opt.outputFile.assign(v); }
+        else if (isOpt("-b", "--baseline"))   { if (!(v = value())) { return false; }  opt.baselineFile.assign(v); }
+        else if (isOpt("-i", "--ini"))        { if (!(v = value())) { return false; }  opt.iniFile.assign(v); }
+        else if (isOpt("-f", "--filters"))    { if (!(v = value())) { return false; }  opt.filters.assign(v); }
+        else if (isOpt("-t", "--tolerance"))  { if (!(v = value())) { return false; }  opt.tolerance = atof(v); }
+        else if (isOpt("-s", "--seconds"))    { if (!(v = value())) { return false; }  opt.renderSeconds = atof(v); }
+        else if (isOpt("-n", "--iterations")) { if (!(v = value())) { return false; }  opt.iterations = std::max(1, atoi(v)); }
+        else if (isOpt("-j", "--jobs"))       { if (!(v = value())) { return false; }  opt.jobs = std::max(0, atoi(v)); }
+        else if (isOpt("-l", "--level-tol"))  { if (!(v = value())) { return false; }  opt.levelTolerance = atof(v); }
+        else if (isOpt("-a", "--audio"))      { opt.audioCheck = true; }
+        else if (isOpt("-x", "--exact"))      { opt.exact = true; }
+        else if (arg[0] == '-') { fprintf(stderr, "error: unknown option '%s'\n", arg); return false; }
+        else { opt.inputs.emplace_back(arg); }
+    }
+    if (opt.inputs.empty()) { usage(argv[0]); return false; }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// corpus handling
+
+static std::vector<uint32_t> s_playableExts;
+
+static bool isPlayable(const char* basename) {
+    if (PathUtil::matchExtList(basename, s_playableExts.data())) { return true; }
+    // old-school Amiga naming scheme ("mod.foo")
+    return (toLower(basename[0]) == 'm') && (toLower(basename[1]) == 'o')
+        && (toLower(basename[2]) == 'd') && (basename[3] == '.');
+}
+
+static void collectCorpus(const std::vector<std::string>& inputs, std::vector<CorpusItem>& corpus, double& readTime) {
+    for (auto& ext : openmpt::get_supported_extensions()) {
+        s_playableExts.push_back(makeFourCC(ext.c_str()));
+    }
+    s_playableExts.push_back(0);
+
+    std::vector<std::string> paths;
+    for (const auto& input : inputs) {
+        if (!PathUtil::isDir(input)) { paths.push_back(input); continue; }
+        std::string path(PathUtil::findSibling(input + PathUtil::pathSep, PathUtil::FindMode::First, isPlayable));
+        while (!path.empty()) {
+            paths.push_back(path);
+            path = PathUtil::findSibling(path, PathUtil::FindMode::Next, isPlayable);
+        }
+    }
+
+    readTime = 0.0;
+    for (const auto& path : paths) {
+        CorpusItem item;
+        item.path.assign(path);
+        Timer t;
+        const char* err = ModUtil::loadFile(path.c_str(), item.data);
+        readTime += t.seconds();
+        if (err) { fprintf(stderr, "%s: %s\n", path.c_str(), err); continue; }
+        corpus.push_back(std::move(item));
+    }
+}
+
+static openmpt::module* createModule(const CorpusItem& item, const Config& config) {
+    std::string error;
+    openmpt::module* mod = ModUtil::createModule(item.data, config, false, error);
+    if (!mod) { fprintf(stderr, "%s: %s\n", item.path.c_str(), error.c_str()); }
+    return mod;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// individual benchmarks
+
+//! format name of a corpus item for the per-format results
+//! (lowercase file extension, or "mod" for old-school Amiga names)
+static std::string formatName(const std::string& path) {
+    std::string base(PathUtil::basename(path));
+    if (isPlayable(base.c_str()) && !PathUtil::matchExtList(base.c_str(), s_playableExts.data())) { return "mod"; }
+    std::string ext;
+    for (char c : PathUtil::getExt(base)) {
+        c = toLower(c);
+        if (isDigit(c) || ((c >= 'a') && (c <= 'z'))) { ext.push_back(c); }
+    }
+    return ext.empty() ? "unknown" : ext;
+}
+
+static void benchLoad(const std::vector<CorpusItem>& corpus, double readTime, std::vector<Result>& results) {
+    Config config;
+    double parseTime = 0.0;
+    std::map<std::string, std::pair<double, int>> perFormat;  // format -> (total time, count)
+    for (const auto& item : corpus) {
+        Timer t;
+        std::unique_ptr<openmpt::module> mod(createModule(item, config));
+        double dt = t.seconds();
+        parseTime += dt;
+        auto& pf = perFormat[formatName(item.path)];
+        pf.first += dt;
+        ++pf.second;
+    }
+    double n = double(std::max(size_t(1), corpus.size()));
+    results.push_back({ "load_read_ms",  readTime  * 1000.0 / n });
+    results.push_back({ "load_parse_ms", parseTime * 1000.0 / n });
+    for (const auto& pf : perFormat) {
+        results.push_back({ "load_parse_" + pf.first + "_ms", pf.second.first * 1000.0 / double(pf.second.second) });
+    }
+}
+
+//! all render settings that are benchmarked and checked
+static const struct FilterInfo { FilterMethod filter; const char* name; } filters[] = {
+    { FilterMethod::None,   "none"   },
+    { FilterMethod::Linear, "linear" },
+    { FilterMethod::Cubic,  "cubic"  },
+    { FilterMethod::Sinc,   "sinc"   },
+    { FilterMethod::Amiga,  "amiga"  },
+    { FilterMethod::A500,   "a500"   },
+    { FilterMethod::A1200,  "a1200"  },
+    { FilterMethod::Auto,   "auto"   },
+};
+static const int separations[] = { 0, 100, 200 };
+static std::vector<FilterInfo> s_benchFilters;  //!< filters selected with -f
+
+//! fill s_benchFilters from the -f option
+//! \returns false if the option contains an unknown filter name
+static bool selectFilters(const Options& opt) {
+    s_benchFilters.clear();
+    if (opt.filters.empty()) {
+        s_benchFilters.assign(std::begin(filters), std::end(filters));
+        return true;
+    }
+    size_t pos = 0;
+    while (pos <= opt.filters.size()) {
+        size_t end = opt.filters.find(',', pos);
+        if (end == std::string::npos) { end = opt.filters.size(); }
+        std::string name(opt.filters.substr(pos, end - pos));
+        pos = end + 1;
+        if (name.empty()) { continue; }
+        const FilterInfo* info = nullptr;
+        for (const auto& f : filters) {
+            if (name == f.name) { info = &f; }
+        }
+        if (!info) { fprintf(stderr, "error: unknown filter '%s'\n", name.c_str()); return false; }
+        s_benchFilters.push_back(*info);
+    }
+    return !s_benchFilters.empty();
+}
+
+static void benchRender(const std::vector<CorpusItem>& corpus, const Options& opt, std::vector<Result>& results) {
+    std::vector<int16_t> buffer(benchBufferSize * 2);
+    size_t maxFrames = size_t(opt.renderSeconds * benchSampleRate);
+
+    for (const auto& f : s_benchFilters) {
+        for (int sep : separations) {
+            Config config;
+            config.filter = f.filter;
+            config.stereoSeparation = sep;
+            size_t totalFrames = 0;
+            double totalTime = 0.0;
+            for (const auto& item : corpus) {
+                std::unique_ptr<openmpt::module> mod(createModule(item, config));
+                if (!mod) { continue; }
+                size_t frames = 0;
+                Timer t;
+                while (frames < maxFrames) {
+                    size_t count = mod->read_interleaved_stereo(benchSampleRate, std::min(benchBufferSize, maxFrames - frames), buffer.data());
+                    if (!count) { break; }
+                    frames += count;
+                }
+                totalTime += t.seconds();
+                totalFrames += frames;
+            }
+            char key[64];
+            snprintf(key, 64, "render_%s_sep%d_x_realtime", f.name, sep);
+            results.push_back({ key, (totalTime > 0.0) ? (double(totalFrames) / benchSampleRate / totalTime) : 0.0 });
+        }
+    }
+}
+
+static void benchScan(const std::vector<CorpusItem>& corpus, const Options& opt, std::vector<Result>& results) {
+    // same procedure as Application::runScan(), but limited in length
+    Config config;
+    std::vector<int16_t> buffer(benchBufferSize * 2);
+    size_t maxFrames = size_t(opt.renderSeconds * benchSampleRate);
+    size_t totalFrames = 0;
+    double totalTime = 0.0;
+    for (const auto& item : corpus) {
+        std::unique_ptr<openmpt::module> mod(createModule(item, config));
+        if (!mod) { continue; }
+        Timer t;
+        ebur128_state *r128 = ebur128_init(2, benchSampleRate, EBUR128_MODE_I);
+        if (!r128) { continue; }
+        size_t frames = 0;
+        while (frames < maxFrames) {
+            size_t count = mod->read_interleaved_stereo(benchSampleRate, std::min(benchBufferSize, maxFrames - frames), buffer.data());
+            if (!count) { break; }
+            ebur128_add_frames_short(r128, buffer.data(), count);
+            frames += count;
+        }
+        double res = InvalidLoudness;
+        ebur128_loudness_global(r128, &res);
+        ebur128_destroy(&r128);
+        totalTime += t.seconds();
+        totalFrames += frames;
+    }
+    results.push_back({ "scan_x_realtime", (totalTime > 0.0) ? (double(totalFrames) / benchSampleRate / totalTime) : 0.0 });
+}
+
+static void benchPatternCells(const std::vector<CorpusItem>& corpus, const Options& opt, std::vector<Result>& results, TextBoxRenderer& renderer) {
+    // all channel widths used by the pattern display formats in updateLayout()
+    static const int widths[] = { 3, 6, 9, 13 };
+    Config config;
+    std::vector<ModUtil::PatternCell> cellBuffer;
+    uint64_t cells = 0;
+    double cellTime = 0.0;
+    uint64_t quadsBefore = renderer.quadsEmitted();
+    double glyphTime = 0.0;
+    const float textSize = 32.0f;
+    for (const auto& item : corpus) {
+        std::unique_ptr<openmpt::module> mod(createModule(item, config));
+        if (!mod) { continue; }
+        int numPatterns = mod->get_num_patterns();
+        int numChannels = mod->get_num_channels();
+        for (int iter = 0;  iter < opt.iterations;  ++iter) {
+            for (int chars : widths) {
+                for (int pat = 0;  pat < numPatterns;  ++pat) {
+                    // time whole passes instead of single cells, so the
+                    // clock overhead doesn't dominate the measurement
+                    int numRows = mod->get_pattern_num_rows(pat);
+                    cellBuffer.resize(size_t(numRows) * size_t(numChannels));
+                    Timer tc;
+                    ModUtil::PatternCell* cell = cellBuffer.data();
+                    for (int row = 0;  row < numRows;  ++row) {
+                        for (int ch = 0;  ch < numChannels;  ++ch) {
+                            ModUtil::formatPatternCell(*cell++, mod.get(), pat, row, ch, chars);
+                        }
+                    }
+                    cellTime += tc.seconds();
+                    cells += uint64_t(cellBuffer.size());
+
+                    // emit the glyphs the same way drawPatternDisplayCell() does
+                    Timer tg;
+                    cell = cellBuffer.data();
+                    for (int row = 0;  row < numRows;  ++row) {
+                        for (int ch = 0;  ch < numChannels;  ++ch) {
+                            float x = float(ch * chars) * textSize * 0.5f;
+                            char c[2] = " ";
+                            for (const char* p = (cell++)->text;  *p;  ++p) {
+                                c[0] = *p;
+                                x = renderer.text(x, float(row % 32) * textSize, textSize, c, 0u, 0xFFFFFFFFu);
+                            }
+                        }
+                    }
+                    glyphTime += tg.seconds();
+                }
+            }
+        }
+    }
+    renderer.flush();
+    uint64_t quads = renderer.quadsEmitted() - quadsBefore;
+    results.push_back({ "pattern_cells_per_sec", (cellTime  > 0.0) ? (double(cells) / cellTime)  : 0.0 });
+    results.push_back({ "glyph_quads_per_sec",   (glyphTime > 0.0) ? (double(quads) / glyphTime) : 0.0 });
+}
+
+static void benchConfig(const Options& opt, const char* argv0, std::vector<Result>& results) {
+    // find an INI file to parse
+    std::string iniFile(opt.iniFile);
+    if (iniFile.empty() && !opt.inputs.empty()) {
+        std::string candidate(PathUtil::isDir(opt.inputs[0]) ? opt.inputs[0] : PathUtil::dirname(opt.inputs[0]));
+        PathUtil::joinInplace(candidate, "tm.ini");
+        if (PathUtil::isFile(candidate)) { iniFile.assign(candidate); }
+    }
+    if (iniFile.empty()) {
+        std::string candidate(argv0);
+        PathUtil::dirnameInplace(candidate);
+        PathUtil::joinInplace(candidate, "tm.ini");
+        if (PathUtil::isFile(candidate)) { iniFile.assign(candidate); }
+    }
+
+    constexpr int loops = 100;
+    int iterations = opt.iterations * loops;
+    if (!iniFile.empty()) {
+        Timer t;
+        for (int i = iterations;  i;  --i) {
+            Config global, file;
+            global.load(iniFile.c_str());
+            file.load(iniFile.c_str(), "bench.mod");
+        }
+        results.push_back({ "config_load_ms", t.seconds() * 1000.0 / double(iterations) });
+    } else {
+        fprintf(stderr, "no INI file found, skipping configuration load benchmark\n");
+    }
+
+    // same procedure as Application::updateConfig()
+    Config global, uiGlobal, file, uiFile, cmdline, merged;
+    global.load(iniFile.c_str());
+    file.load(iniFile.c_str(), "bench.mod");
+    Timer t;
+    for (int i = iterations;  i;  --i) {
+        merged.reset();
+        merged.import(global);
+        merged.import(uiGlobal);
+        merged.import(file);
+        merged.import(uiFile);
+        merged.import(cmdline);
+        uiFile.importAllUnset(merged);
+    }
+    results.push_back({ "config_merge_ms", t.seconds() * 1000.0 / double(iterations) });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// result output and baseline comparison
+
+static bool writeResults(const Options& opt, size_t corpusSize, const std::vector<Result>& results) {
+    FILE* f = opt.outputFile.empty() ? stdout : fopen(opt.outputFile.c_str(), "w");
+    if (!f) { fprintf(stderr, "error: could not open '%s' for writing\n", opt.outputFile.c_str()); return false; }
+    fprintf(f, "{\n");
+    fprintf(f, "  \"version\": \"%s\",\n", g_ProductVersion);
+    fprintf(f, "  \"mixer_arch\": \"%s\",\n", TM_MIXER_ARCH[0] ? TM_MIXER_ARCH : "default");
+    fprintf(f, "  \"modules\": %d,\n", int(corpusSize));
+    fprintf(f, "  \"render_seconds\": %g,\n", opt.renderSeconds);
+    fprintf(f, "  \"results\": {\n");
+    for (size_t i = 0;  i < results.size();  ++i) {
+        fprintf(f, "    \"%s\": %.6g%s\n", results[i].key.c_str(), results[i].value, ((i + 1) < results.size()) ? "," : "");
+    }
+    fprintf(f, "  }\n");
+    fprintf(f, "}\n");
+    if (f != stdout) { fclose(f); }
+    return true;
+}
+
+//! extremely simple extraction of all '"key": number' pairs from a JSON file
+static bool loadBaseline(const char* filename, std::vector<Result>& baseline) {
+    FILE* f = fopen(filename, "rb");
+    if (!f) { return false; }
+    std::string json;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) { json.append(buf, n); }
+    fclose(f);
+    size_t pos = 0;
+    while ((pos = json.find('"', pos)) != std::string::npos) {
+        size_t end = json.find('"', pos + 1);
+        if (end == std::string::npos) { break; }
+        std::string key(json.substr(pos + 1, end - pos - 1));
+        pos = end + 1;
+        while ((pos < json.size()) && isSpace(json[pos])) { ++pos; }
+        if ((pos >= json.size()) || (json[pos] != ':')) { continue; }
+        ++pos;
+        while ((pos < json.size()) && isSpace(json[pos])) { ++pos; }
+        const char* start = &json.c_str()[pos];
+        char* numEnd = nullptr;
+        double value = strtod(start, &numEnd);
+        if (numEnd == start) { continue; }
+        baseline.push_back({ key, value });
+        pos += size_t(numEnd - start);
+    }
+    return true;
+}
+
+static bool endsWith(const std::string& s, const char* suffix) {
+    size_t n = strlen(suffix);
+    return (s.size() >= n) && !s.compare(s.size() - n, n, suffix);
+}
+
+//! compare results against a baseline
+//! \returns the number of detected regressions
+static int compareBaseline(const Options& opt, const std::vector<Result>& results) {
+    std::vector<Result> baseline;
+    if (!loadBaseline(opt.baselineFile.c_str(), baseline)) {
+        fprintf(stderr, "error: could not read baseline file '%s'\n", opt.baselineFile.c_str());
+        return 1;
+    }
+    int regressions = 0;
+    double tol = opt.tolerance * 0.01;
+    for (const auto& res : results) {
+        const Result* base = nullptr;
+        for (const auto& b : baseline) {
+            if (b.key == res.key) { base = &b; break; }
+        }
+        if (!base || (base->value <= 0.0)) { continue; }
+        bool lowerIsBetter = endsWith(res.key, "_ms");
+        double change = (res.value - base->value) / base->value * 100.0;
+        bool regressed = lowerIsBetter ? (res.value > (base->value * (1.0 + tol)))
+                                       : (res.value < (base->value * (1.0 - tol)));
+        fprintf(stderr, "%-8s %-32s %12.4g -> %12.4g  (%+.1f%%)\n",
+                regressed ? "REGRESS" : "ok", res.key.c_str(), base->value, res.value, change);
+        if (regressed) { ++regressions; }
+    }
+    return regressions;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// audio regression check
+
+//! rendering result of a single module with a single setting
+struct AudioFingerprint {
+    std::string file;  //!< base name of the module file
+    const char* filter = "";
+    int separation = 0;
+    uint64_t frames = 0;
+    uint64_t hash = 0;  //!< FNV-1a over all 16-bit samples, in little-endian order
+    double peak[2] = { -200.0, -200.0 };  //!< in dBFS
+    double rms[2]  = { -200.0, -200.0 };  //!< in dBFS
+    bool valid = false;
+};
+
+static inline double toDB(double level) {
+    return 20.0 * std::log10(std::max(level, 1E-10));
+}
+
+static void renderFingerprint(const CorpusItem& item, const FilterInfo& filter, int separation, size_t maxFrames, AudioFingerprint& fp) {
+    Config config;
+    config.filter = filter.filter;
+    config.stereoSeparation = separation;
+    fp.file = PathUtil::basename(item.path);
+    fp.filter = filter.name;
+    fp.separation = separation;
+    std::string error;
+    std::unique_ptr<openmpt::module> mod(ModUtil::createModule(item.data, config, false, error));
+    if (!mod) { return; }
+    std::vector<int16_t> buffer(benchBufferSize * 2);
+    uint64_t hash = 0xCBF29CE484222325ull;
+    int peak[2] = { 0, 0 };
+    double sumSq[2] = { 0.0, 0.0 };
+    size_t frames = 0;
+    while (frames < maxFrames) {
+        size_t count = mod->read_interleaved_stereo(benchSampleRate, std::min(benchBufferSize, maxFrames - frames), buffer.data());
+        if (!count) { break; }
+        const int16_t* pos = buffer.data();
+        for (size_t i = 0;  i < count;  ++i) {
+            for (int c = 0;  c < 2;  ++c) {
+                int v = *pos++;
+                uint16_t u = uint16_t(v);
+                hash = (hash ^ (u & 0xFFu)) * 0x100000001B3ull;
+                hash = (hash ^ (u >> 8))    * 0x100000001B3ull;
+                peak[c] = std::max(peak[c], std::abs(v));
+                sumSq[c] += double(v) * double(v);
+            }
+        }
+        frames += count;
+    }
+    fp.frames = frames;
+    fp.hash = hash;
+    for (int c = 0;  c < 2;  ++c) {
+        fp.peak[c] = toDB(double(peak[c]) / 32768.0);
+        fp.rms[c]  = frames ? toDB(std::sqrt(sumSq[c] / double(frames)) / 32768.0) : -200.0;
+    }
+    fp.valid = true;
+}
+
+//! render all modules with all settings, using multiple threads
+//! \returns the total rendering speed (as a multiple of realtime)
+static double renderFingerprints(const std::vector<CorpusItem>& corpus, const Options& opt, std::vector<AudioFingerprint>& fps) {
+    size_t numFilters = s_benchFilters.size();
+    constexpr size_t numSeps = sizeof(separations) / sizeof(*separations);
+    size_t numJobs = corpus.size() * numFilters * numSeps;
+    size_t maxFrames = size_t(opt.renderSeconds * benchSampleRate);
+    fps.clear();
+    fps.resize(numJobs);
+    std::atomic<size_t> nextJob = 0;
+    auto worker = [&] () {
+        for (;;) {
+            size_t job = nextJob++;
+            if (job >= numJobs) { break; }
+            renderFingerprint(corpus[job / (numFilters * numSeps)],
+                              s_benchFilters[(job / numSeps) % numFilters],
+                              separations[job % numSeps],
+                              maxFrames, fps[job]);
+        }
+    };
+    int numThreads = opt.jobs ? opt.jobs : int(std::thread::hardware_concurrency());
+    numThreads = std::max(1, std::min(numThreads, int(numJobs)));
+    fprintf(stderr, "rendering %d module/setting combinations with %d thread(s) ...\n", int(numJobs), numThreads);
+    Timer t;
+    std::vector<std::thread> threads;
+    for (int i = 0;  i < numThreads;  ++i) { threads.emplace_back(worker); }
+    for (auto& th : threads) { th.join(); }
+    double elapsed = t.seconds();
+    uint64_t totalFrames = 0;
+    for (const auto& fp : fps) {
+        if (!fp.valid) { fprintf(stderr, "%s: could not render with filter=%s separation=%d\n", fp.file.c_str(), fp.filter, fp.separation); }
+        totalFrames += fp.frames;
+    }
+    return (elapsed > 0.0) ? (double(totalFrames) / benchSampleRate / elapsed) : 0.0;
+}
+
+static bool writeFingerprints(const Options& opt, const std::vector<AudioFingerprint>& fps, double speed) {
+    FILE* f = opt.outputFile.empty() ? stdout : fopen(opt.outputFile.c_str(), "w");
+    if (!f) { fprintf(stderr, "error: could not open '%s' for writing\n", opt.outputFile.c_str()); return false; }
+    fprintf(f, "{\n");
+    fprintf(f, "  \"version\": \"%s\",\n", g_ProductVersion);
+    fprintf(f, "  \"mixer_arch\": \"%s\",\n", TM_MIXER_ARCH[0] ? TM_MIXER_ARCH : "default");
+    fprintf(f, "  \"sample_rate\": %d,\n", benchSampleRate);
+    fprintf(f, "  \"render_seconds\": %g,\n", opt.renderSeconds);
+    fprintf(f, "  \"render_x_realtime\": %.6g,\n", speed);
+    fprintf(f, "  \"fingerprints\": [\n");
+    bool first = true;
+    for (const auto& fp : fps) {
+        if (!fp.valid) { continue; }
+        // one record per line; loadFingerprints() relies on that
+        fprintf(f, "%s    {\"file\": \"", first ? "" : ",\n");
+        for (char c : fp.file) {
+            if ((c == '"') || (c == '\\')) { fputc('\\', f); }
+            fputc(c, f);
+        }
+        fprintf(f, "\", \"filter\": \"%s\", \"separation\": %d, \"frames\": %llu, \"hash\": \"%016llx\", "
+                   "\"peak_l\": %.4f, \"peak_r\": %.4f, \"rms_l\": %.4f, \"rms_r\": %.4f}",
+                fp.filter, fp.separation, (unsigned long long)fp.frames, (unsigned long long)fp.hash,
+                fp.peak[0], fp.peak[1], fp.rms[0], fp.rms[1]);
+        first = false;
+    }
+    fprintf(f, "\n  ]\n");
+    fprintf(f, "}\n");
+    if (f != stdout) { fclose(f); }
+    return true;
+}
+
+//! extract a string or numeric field from a single-line JSON record
+static bool getField(const std::string& line, const char* key, std::string& value) {
+    std::string pattern("\"");
+    pattern.append(key);
+    pattern.append("\":");
+    size_t pos = line.find(pattern);
+    if (pos == std::string::npos) { return false; }
+    pos += pattern.size();
+    while ((pos < line.size()) && isSpace(line[pos])) { ++pos; }
+    value.clear();
+    if ((pos < line.size()) && (line[pos] == '"')) {
+        for (++pos;  (pos < line.size()) && (line[pos] != '"');  ++pos) {
+            if ((line[pos] == '\\') && ((pos + 1) < line.size())) { ++pos; }
+            value.push_back(line[pos]);
+        }
+    } else {
+        while ((pos < line.size()) && (line[pos] != ',') && (line[pos] != '}')) { value.push_back(line[pos++]); }
+    }
+    return true;
+}
+
+static bool loadFingerprints(const char* filename, std::vector<AudioFingerprint>& fps) {
+    FILE* f = fopen(filename, "r");
+    if (!f) { return false; }
+    std::string line;
+    int c;
+    do {
+        c = fgetc(f);
+        if ((c != EOF) && (c != '\n')) { line.push_back(char(c)); continue; }
+        std::string file, filter, v;
+        if (getField(line, "file", file) && getField(line, "filter", filter)) {
+            AudioFingerprint fp;
+            fp.file.assign(file);
+            fp.filter = "";
+            for (const auto& fi : filters) {
+                if (filter == fi.name) { fp.filter = fi.name; }
+            }
+            if (getField(line, "separation", v)) { fp.separation = atoi(v.c_str()); }
+            if (getField(line, "frames", v))     { fp.frames = strtoull(v.c_str(), nullptr, 10); }
+            if (getField(line, "hash", v))       { fp.hash = strtoull(v.c_str(), nullptr, 16); }
+            if (getField(line, "peak_l", v))     { fp.peak[0] = atof(v.c_str()); }
+            if (getField(line, "peak_r", v))     { fp.peak[1] = atof(v.c_str()); }
+            if (getField(line, "rms_l", v))      { fp.rms[0] = atof(v.c_str()); }
+            if (getField(line, "rms_r", v))      { fp.rms[1] = atof(v.c_str()); }
+            fp.valid = true;
+            fps.push_back(fp);
+        }
+        line.clear();
+    } while (c != EOF);
+    fclose(f);
+    return true;
+}
+
+//! compare rendered fingerprints against a baseline
+//! \returns the number of divergences
+static int compareFingerprints(const Options& opt, const std::vector<AudioFingerprint>& fps) {
+    std::vector<AudioFingerprint> baseline;
+    if (!loadFingerprints(opt.baselineFile.c_str(), baseline)) {
+        fprintf(stderr, "error: could not read baseline file '%s'\n", opt.baselineFile.c_str());
+        return 1;
+    }
+    int same = 0, drift = 0, diverged = 0, unknown = 0;
+    for (const auto& fp : fps) {
+        if (!fp.valid) { ++diverged; continue; }
+        const AudioFingerprint* base = nullptr;
+        for (const auto& b : baseline) {
+            if ((b.file == fp.file) && !strcmp(b.filter, fp.filter) && (b.separation == fp.separation)) { base = &b; break; }
+        }
+        if (!base) { ++unknown; continue; }
+        if ((base->hash == fp.hash) && (base->frames == fp.frames)) { ++same; continue; }
+        double maxDev = 0.0;
+        for (int c = 0;  c < 2;  ++c) {
+            maxDev = std::max(maxDev, std::abs(fp.peak[c] - base->peak[c]));
+            maxDev = std::max(maxDev, std::abs(fp.rms[c]  - base->rms[c]));
+        }
+        bool ok = !opt.exact && (base->frames == fp.frames) && (maxDev <= opt.levelTolerance);
+        fprintf(stderr, "%-8s %s [%s, sep %d]: hash %016llx -> %016llx, frames %llu -> %llu, max level deviation %.4f dB\n",
+                ok ? "drift" : "DIVERGE", fp.file.c_str(), fp.filter, fp.separation,
+                (unsigned long long)base->hash, (unsigned long long)fp.hash,
+                (unsigned long long)base->frames, (unsigned long long)fp.frames, maxDev);
+        if (ok) { ++drift; } else { ++diverged; }
+    }
+    fprintf(stderr, "%d identical, %d drifted within tolerance, %d diverged, %d not in baseline\n", same, drift, diverged, unknown);
+    return diverged;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt) || !selectFilters(opt)) { return 2; }
+    const char* cpuError = ModUtil::checkCPU();
+    if (cpuError) { fprintf(stderr, "error: %s\n", cpuError); return 2; }
+
+    std::vector<CorpusItem> corpus;
+    double readTime = 0.0;
+    collectCorpus(opt.inputs, corpus, readTime);
+    if (corpus.empty()) { fprintf(stderr, "error: no modules found\n"); return 2; }
+
+    if (opt.audioCheck) {
+        std::vector<AudioFingerprint> fps;
+        double speed = renderFingerprints(corpus, opt, fps);
+        fprintf(stderr, "total rendering speed: %.1fx realtime\n", speed);
+        if (!opt.baselineFile.empty()) {
+            int diverged = compareFingerprints(opt, fps);
+            if (!opt.outputFile.empty() && !writeFingerprints(opt, fps, speed)) { return 2; }
+            return diverged ? 1 : 0;
+        }
+        return writeFingerprints(opt, fps, speed) ? 0 : 2;
+    }
+
+    fprintf(stderr, "benchmarking %d modules ...\n", int(corpus.size()));
+
+    TextBoxRenderer renderer;
+    if (!renderer.initHeadless(1920, 1080)) {
+        fprintf(stderr, "error: could not initialize headless renderer: %s\n", renderer.error());
+        return 2;
+    }
+
+    std::vector<Result> results;
+    fprintf(stderr, "- module loading\n");           benchLoad(corpus, readTime, results);
+    fprintf(stderr, "- audio rendering\n");          benchRender(corpus, opt, results);
+    fprintf(stderr, "- loudness scan\n");            benchScan(corpus, opt, results);
+    fprintf(stderr, "- pattern cells and glyphs\n"); benchPatternCells(corpus, opt, results, renderer);
+    fprintf(stderr, "- configuration\n");            benchConfig(opt, argv[0], results);
+    renderer.shutdown();
+
+    if (!writeResults(opt, corpus.size(), results)) { return 2; }
+    if (!opt.baselineFile.empty()) {
+        int regressions = compareBaseline(opt, results);
+        if (regressions) {
+            fprintf(stderr, "%d regression(s) detected\n", regressions);
+            return 1;
+        }
+    }
+    return 0;
+}
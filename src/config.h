@@ -49,8 +49,11 @@ struct Config {
     bool     fullscreen               = false;        //!< whether to run in fullscreen mode [startup]
     int      windowWidth              = 1920;         //!< initial window width  in non-fullscreen mode, in pixels [startup, min 640, max 3840]
     int      windowHeight             = 1080;         //!< initial window height in non-fullscreen mode, in pixels [startup, min 480, max 2160]
+    bool     softwareRendering        = false;        //!< draw on the CPU instead of using OpenGL (this is done automatically if OpenGL 3.3 isn't available) [startup]
+    float    renderScale              = 1.0f;         //!< resolution at which everything except the pattern display is drawn, relative to the screen resolution; values below 1 reduce the GPU load on weak graphics chips at high resolutions (0 = automatic, based on the measured GPU time per frame) [max 1]
+    bool     framePacing              = true;         //!< advance animations by the predicted time between two displayed frames (locked to the display's refresh rate) instead of the measured, more jittery time between two drawn frames
     float    alphaGamma               = 2.2f;         //!< fake gamma-correct rendering by applying gamma to the alpha channel; higher values = thicker and less aliasing for bright-on-dark text [min .5, max 3]
-    std::string font;                                 //!< font to use for all displays: 'inconsolata' (default), 'iosevka', 'topaz'/'topaz1200'/'topaz500', 'pc' (note: all font sizes will be rounded down to an integer multiple of 16 pixels if a bitmap font is used) [values (default) | Inconsolata | Iosevka | Topaz500 | Topaz1200 | PC]
+    std::string font;                                 //!< font to use for all displays: 'inconsolata' (default), 'iosevka', 'topaz'/'topaz1200'/'topaz500', 'pc', or the path of a TrueType font file (.ttf/.otf/.ttc; glyphs are generated on first use and cached in a 'fontcache' directory next to tm.ini) (note: all font sizes will be rounded down to an integer multiple of 16 pixels if a bitmap font is used) [values (default) | Inconsolata | Iosevka | Topaz500 | Topaz1200 | PC]
 
     // audio rendering
     int      sampleRate               = 48000;        //!< audio sampling rate [startup, min 8000, max 96000]
@@ -70,6 +73,7 @@ struct Config {
     bool     fadeOutAfterLoop         = false;        //!< whether to trigger a slow fade-out after the song looped
     float    fadeOutAt                = 0.0f;         //!< number of seconds after which the song shall be slowly faded out automatically (0 = no auto-fade) [max 1000]
     float    fadeDuration             = 10.f;         //!< duration of a fade-out, in seconds
+    bool     backgroundSeek           = true;         //!< seek on standby instances of the module in a background thread, so that seeking in large modules doesn't interrupt the audio; costs the memory of two more module instances [reload]
 
     // metadata scrolling
     bool     autoScrollEnabled        = true;         //!< whether to enable automatic scrolling in the metadata sidebar after loading a module
@@ -129,6 +133,10 @@ struct Config {
     uint32_t progressBorderColor      = 0xFF888888u;  //!< color of the progress bar's border
     uint32_t progressOuterColor       = 0xFF222222u;  //!< color of the progress bar's empty area (note: this is drawn on top of the border, so be careful with alpha!)
     uint32_t progressInnerColor       = 0xFF888888u;  //!< color of the actual progress indicator (note: this is drawn on top of the other two progress bar elements, so be careful with alpha!)
+    uint32_t progressOrderColor       = 0x40FFFFFFu;  //!< color of the marks that show where each order starts in the progress bar; these only appear once the module has been analyzed in the background
+    bool     progressWaveform         = false;        //!< whether to show a waveform overview of the whole song in the progress bar; this only appears once the module has been analyzed in the background
+    uint32_t progressWavePeakColor    = 0x60FFFFFFu;  //!< color of the peak (minimum/maximum) part of the waveform overview
+    uint32_t progressWaveRMSColor     = 0x80FFFFFFu;  //!< color of the RMS part of the waveform overview
 
     // metadata bar
     bool     metaEnabled              = true;         //!< whether to enable the metadata sidebar by default after loading a module [reload]
@@ -185,6 +193,19 @@ struct Config {
     uint32_t vuUpperColor             = 0x10FF80FFu;  //!< color of the upper end of the fake VU meters
     uint32_t vuLowerColor             = 0x50FF00FFu;  //!< color of the lower end of the fake VU meters
 
+    // spectrum analyzer
+    bool     spectrumEnabled          = false;        //!< whether to enable the spectrum analyzer (which, unlike the VU meters, shows the actual audio output) by default after loading a module [reload]
+    int      spectrumHeight           = 200;          //!< height of the spectrum analyzer [max 1000]
+    int      spectrumBands            = 64;           //!< number of frequency bands in the spectrum analyzer [min 4, max 256]
+    uint32_t spectrumUpperColor       = 0x20FFC040u;  //!< color of the upper end of the spectrum analyzer bars
+    uint32_t spectrumLowerColor       = 0x60FF8000u;  //!< color of the lower end of the spectrum analyzer bars
+
+    // channel oscilloscopes
+    bool     scopesEnabled            = false;        //!< whether to enable the per-channel oscilloscopes by default after loading a module; note that these need additional module instances (up to one per channel), running on all spare CPU cores [reload]
+    int      scopeHeight              = 100;          //!< height of the channel oscilloscopes [max 1000]
+    float    scopeGain                = 2.0f;         //!< amplification of the signal shown in the channel oscilloscopes [min .1, max 20]
+    uint32_t scopeColor               = 0xC0FFFFFFu;  //!< color of the channel oscilloscopes
+
     // clipping indicator
     bool     clipEnabled              = false;        //!< whether the clipping indicator is enabled
     int      clipSize                 = 8;            //!< circumference of the clipping indicator [max 200]
@@ -203,6 +224,13 @@ struct Config {
     uint32_t toastTextColor           = 0xFFFFFFFFu;  //!< text color of a "toast" status message
     float    toastDuration            = 2.0f;         //!< time a "toast" status message shall be visible until it's completely faded out
 
+    // diagnostics
+    std::string trace;                                //!< if set, record a timeline of audio callbacks, frames, module loads etc. and write it into this file in Chrome trace-event JSON format on exit (view with ui.perfetto.dev or chrome://tracing) [startup]
+    int      controlPort              = 0;            //!< if nonzero, accept remote control commands and metrics queries on this TCP port on the loopback interface (use an SSH tunnel to access it from another machine) [startup, max 65535]
+    std::string record;                               //!< if set, record all key presses, dropped files, window resizes and mouse wheel events along with their timing into this file [startup]
+    std::string replay;                               //!< if set, replay the events recorded into this file with the 'record' option (use the same module file or directory on the command line as during recording); most useful with the tm_headless tool, which replays with a deterministic virtual clock [startup]
+    int      memoryBudget             = 0;            //!< memory budget for module data, caches, metadata text and textures, in MiB; if it's exceeded, the least valuable cached data is discarded first (0 = unlimited; current usage is shown with F4 and in the remote control metrics) [global, max 65536]
+
     NumberSet set;
     inline Config() {}
     inline void reset() { Config defaultConfig; *this = defaultConfig; }
@@ -52,16 +52,37 @@ const ConfigItem g_ConfigItems[] = { {
         [] (Config& src) -> void* { return static_cast<void*>(&src.windowHeight); },
         [] (const Config& src, Config& dest) { dest.windowHeight = src.windowHeight; }
     }, {
-        6, ConfigItem::DataType::Float, 0,
+        6, ConfigItem::DataType::Bool, ConfigItem::Flags::Startup,
+        "software rendering",
+        "draw on the CPU instead of using OpenGL (this is done automatically if OpenGL 3.3 isn't available)",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.softwareRendering); },
+        [] (const Config& src, Config& dest) { dest.softwareRendering = src.softwareRendering; }
+    }, {
+        7, ConfigItem::DataType::Float, 0,
+        "render scale",
+        "resolution at which everything except the pattern display is drawn, relative to the screen resolution; values below 1 reduce the GPU load on weak graphics chips at high resolutions (0 = automatic, based on the measured GPU time per frame)",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.renderScale); },
+        [] (const Config& src, Config& dest) { dest.renderScale = src.renderScale; }
+    }, {
+        8, ConfigItem::DataType::Bool, 0,
+        "frame pacing",
+        "advance animations by the predicted time between two displayed frames (locked to the display's refresh rate) instead of the measured, more jittery time between two drawn frames",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.framePacing); },
+        [] (const Config& src, Config& dest) { dest.framePacing = src.framePacing; }
+    }, {
+        9, ConfigItem::DataType::Float, 0,
         "alpha gamma",
         "fake gamma-correct rendering by applying gamma to the alpha channel; higher values = thicker and less aliasing for bright-on-dark text",
         nullptr, 0.5f, 3.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.alphaGamma); },
         [] (const Config& src, Config& dest) { dest.alphaGamma = src.alphaGamma; }
     }, {
-        7, ConfigItem::DataType::String, 0,
+        10, ConfigItem::DataType::String, 0,
         "font",
-        "font to use for all displays: 'inconsolata' (default), 'iosevka', 'topaz'/'topaz1200'/'topaz500', 'pc' (note: all font sizes will be rounded down to an integer multiple of 16 pixels if a bitmap font is used)",
+        "font to use for all displays: 'inconsolata' (default), 'iosevka', 'topaz'/'topaz1200'/'topaz500', 'pc', or the path of a TrueType font file (.ttf/.otf/.ttc; glyphs are generated on first use and cached in a 'fontcache' directory next to tm.ini) (note: all font sizes will be rounded down to an integer multiple of 16 pixels if a bitmap font is used)",
         "(default)\0Inconsolata\0Iosevka\0Topaz500\0Topaz1200\0PC\0\0", 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.font); },
         [] (const Config& src, Config& dest) { dest.font = src.font; }
@@ -70,56 +91,56 @@ const ConfigItem g_ConfigItems[] = { {
         "audio rendering",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        8, ConfigItem::DataType::Int, ConfigItem::Flags::Startup,
+        11, ConfigItem::DataType::Int, ConfigItem::Flags::Startup,
         "sample rate",
         "audio sampling rate",
         nullptr, 8000.0f, 96000.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.sampleRate); },
         [] (const Config& src, Config& dest) { dest.sampleRate = src.sampleRate; }
     }, {
-        9, ConfigItem::DataType::Int, ConfigItem::Flags::Startup,
+        12, ConfigItem::DataType::Int, ConfigItem::Flags::Startup,
         "audio buffer size",
         "size of the audio buffer, in samples; if there are dropouts, try doubling this value",
         nullptr, 64.0f, 4096.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.audioBufferSize); },
         [] (const Config& src, Config& dest) { dest.audioBufferSize = src.audioBufferSize; }
     }, {
-        10, ConfigItem::DataType::Enum, ConfigItem::Flags::Reload,
+        13, ConfigItem::DataType::Enum, ConfigItem::Flags::Reload,
         "filter",
         "audio resampling filter to be used [possible values: 'None', 'Linear', 'Cubic', 'Sinc', 'Amiga', 'A500', 'A1200', 'Auto']",
         "None\0Linear\0Cubic\0Sinc\0Amiga\0A500\0A1200\0Auto\0\0", 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.filter); },
         [] (const Config& src, Config& dest) { dest.filter = src.filter; }
     }, {
-        11, ConfigItem::DataType::Int, ConfigItem::Flags::Reload,
+        14, ConfigItem::DataType::Int, ConfigItem::Flags::Reload,
         "stereo separation",
         "amount of stereo separation, in percent (0 = mono, 100 = half stereo for MOD / full stereo for others, 200 = full stereo for MOD)",
         nullptr, 0.0f, 200.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.stereoSeparation); },
         [] (const Config& src, Config& dest) { dest.stereoSeparation = src.stereoSeparation; }
     }, {
-        12, ConfigItem::DataType::Int, ConfigItem::Flags::Reload,
+        15, ConfigItem::DataType::Int, ConfigItem::Flags::Reload,
         "volume ramping",
         "volume ramping strength (0 = no ramping, 10 = softest ramping, -1 = recommended default)",
         nullptr, -1.0f, 10.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.volumeRamping); },
         [] (const Config& src, Config& dest) { dest.volumeRamping = src.volumeRamping; }
     }, {
-        13, ConfigItem::DataType::Float, ConfigItem::Flags::Reload,
+        16, ConfigItem::DataType::Float, ConfigItem::Flags::Reload,
         "gain",
         "global gain to apply, in decibels",
         nullptr, -24.0f, 24.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.gain); },
         [] (const Config& src, Config& dest) { dest.gain = src.gain; }
     }, {
-        14, ConfigItem::DataType::Float, ConfigItem::Flags::Hidden,
+        17, ConfigItem::DataType::Float, ConfigItem::Flags::Hidden,
         "loudness",
         "the current track's measured loudness, in decibels; values < -100 mean \"no loudness measured\"",
         nullptr, -24.0f, 24.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.loudness); },
         [] (const Config& src, Config& dest) { dest.loudness = src.loudness; }
     }, {
-        15, ConfigItem::DataType::Float, ConfigItem::Flags::Reload,
+        18, ConfigItem::DataType::Float, ConfigItem::Flags::Reload,
         "target loudness",
         "target loudness, in decibels (or LUFS); if the automatically measured 'loudness' parameter is valid, an extra gain will be applied (in addition to 'gain') so that the loudness is corrected to this value",
         nullptr, -24.0f, 24.0f,
@@ -130,74 +151,81 @@ const ConfigItem g_ConfigItems[] = { {
         "playback control",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        16, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        19, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
         "auto play",
         "automatically start playing when loading a module; you may want to turn this off for actual competitions",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.autoPlay); },
         [] (const Config& src, Config& dest) { dest.autoPlay = src.autoPlay; }
     }, {
-        17, ConfigItem::DataType::Bool, 0,
+        20, ConfigItem::DataType::Bool, 0,
         "auto advance",
         "automatically continue with the next song in the directory if the current song stopped; allows for jukebox-like functionality",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.autoAdvance); },
         [] (const Config& src, Config& dest) { dest.autoAdvance = src.autoAdvance; }
     }, {
-        18, ConfigItem::DataType::Bool, ConfigItem::Flags::Global,
+        21, ConfigItem::DataType::Bool, ConfigItem::Flags::Global,
         "shuffle",
         "play tracks of the directory endlessly, and in random order",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.shuffle); },
         [] (const Config& src, Config& dest) { dest.shuffle = src.shuffle; }
     }, {
-        19, ConfigItem::DataType::Bool, 0,
+        22, ConfigItem::DataType::Bool, 0,
         "loop",
         "whether to loop the song after it's finished, or play the song's programmed loop if it there is one",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.loop); },
         [] (const Config& src, Config& dest) { dest.loop = src.loop; }
     }, {
-        20, ConfigItem::DataType::Bool, 0,
+        23, ConfigItem::DataType::Bool, 0,
         "fade out after loop",
         "whether to trigger a slow fade-out after the song looped",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.fadeOutAfterLoop); },
         [] (const Config& src, Config& dest) { dest.fadeOutAfterLoop = src.fadeOutAfterLoop; }
     }, {
-        21, ConfigItem::DataType::Float, 0,
+        24, ConfigItem::DataType::Float, 0,
         "fade out at",
         "number of seconds after which the song shall be slowly faded out automatically (0 = no auto-fade)",
         nullptr, 0.0f, 1000.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.fadeOutAt); },
         [] (const Config& src, Config& dest) { dest.fadeOutAt = src.fadeOutAt; }
     }, {
-        22, ConfigItem::DataType::Float, 0,
+        25, ConfigItem::DataType::Float, 0,
         "fade duration",
         "duration of a fade-out, in seconds",
         nullptr, 0.0f, 60.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.fadeDuration); },
         [] (const Config& src, Config& dest) { dest.fadeDuration = src.fadeDuration; }
+    }, {
+        26, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        "background seek",
+        "seek on standby instances of the module in a background thread, so that seeking in large modules doesn't interrupt the audio; costs the memory of two more module instances",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.backgroundSeek); },
+        [] (const Config& src, Config& dest) { dest.backgroundSeek = src.backgroundSeek; }
     }, {
         0, ConfigItem::DataType::SectionHeader, 0, nullptr,
         "metadata scrolling",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        23, ConfigItem::DataType::Bool, 0,
+        27, ConfigItem::DataType::Bool, 0,
         "auto scroll enabled",
         "whether to enable automatic scrolling in the metadata sidebar after loading a module",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.autoScrollEnabled); },
         [] (const Config& src, Config& dest) { dest.autoScrollEnabled = src.autoScrollEnabled; }
     }, {
-        24, ConfigItem::DataType::Float, 0,
+        28, ConfigItem::DataType::Float, 0,
         "max scroll duration",
         "maximum duration after which automatic metadata scrolling reaches the end, in seconds; if the module is shorter than that, the module's duration will be used instead",
         nullptr, 0.0f, 1000.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.maxScrollDuration); },
         [] (const Config& src, Config& dest) { dest.maxScrollDuration = src.maxScrollDuration; }
     }, {
-        25, ConfigItem::DataType::Float, 0,
+        29, ConfigItem::DataType::Float, 0,
         "scroll delay",
         "delay (in seconds) before autoscrolling begins, and ends early before the track end",
         nullptr, 0.0f, 100.0f,
@@ -208,42 +236,42 @@ const ConfigItem g_ConfigItems[] = { {
         "background colors",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        26, ConfigItem::DataType::Color, 0,
+        30, ConfigItem::DataType::Color, 0,
         "empty background",
         "background color of \"no module loaded\" screen",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.emptyBackground); },
         [] (const Config& src, Config& dest) { dest.emptyBackground = src.emptyBackground; }
     }, {
-        27, ConfigItem::DataType::Color, 0,
+        31, ConfigItem::DataType::Color, 0,
         "pattern background",
         "background color of pattern display",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternBackground); },
         [] (const Config& src, Config& dest) { dest.patternBackground = src.patternBackground; }
     }, {
-        28, ConfigItem::DataType::Color, 0,
+        32, ConfigItem::DataType::Color, 0,
         "info background",
         "background color of the top information bar",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoBackground); },
         [] (const Config& src, Config& dest) { dest.infoBackground = src.infoBackground; }
     }, {
-        29, ConfigItem::DataType::Color, 0,
+        33, ConfigItem::DataType::Color, 0,
         "meta background",
         "background color of the metadata sidebar",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaBackground); },
         [] (const Config& src, Config& dest) { dest.metaBackground = src.metaBackground; }
     }, {
-        30, ConfigItem::DataType::Color, 0,
+        34, ConfigItem::DataType::Color, 0,
         "shadow color",
         "color of the info and metadata bar's shadows",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.shadowColor); },
         [] (const Config& src, Config& dest) { dest.shadowColor = src.shadowColor; }
     }, {
-        31, ConfigItem::DataType::String, ConfigItem::Flags::Image,
+        35, ConfigItem::DataType::String, ConfigItem::Flags::Image,
         "background image",
         "background image; must be a PNG file; will be cropped and scaled to fill the entire screen (without distorting the aspect ratio)",
         nullptr, 0.0f, 1.0f,
@@ -254,42 +282,42 @@ const ConfigItem g_ConfigItems[] = { {
         "background logo",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        32, ConfigItem::DataType::Bool, 0,
+        36, ConfigItem::DataType::Bool, 0,
         "logo enabled",
         "whether to show a logo at all",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.logoEnabled); },
         [] (const Config& src, Config& dest) { dest.logoEnabled = src.logoEnabled; }
     }, {
-        33, ConfigItem::DataType::String, ConfigItem::Flags::Image,
+        37, ConfigItem::DataType::String, ConfigItem::Flags::Image,
         "logo",
         "custom logo file; must be a grayscale PNG file with high-contrast black-on-white artwork; will be downscaled by a power of two so it fits into the canvas",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.logo); },
         [] (const Config& src, Config& dest) { dest.logo = src.logo; }
     }, {
-        34, ConfigItem::DataType::Bool, 0,
+        38, ConfigItem::DataType::Bool, 0,
         "logo scaling",
         "whether to allow arbitrary downscaling of the logo (if false, only allow power-of-two downscaling)",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.logoScaling); },
         [] (const Config& src, Config& dest) { dest.logoScaling = src.logoScaling; }
     }, {
-        35, ConfigItem::DataType::Int, 0,
+        39, ConfigItem::DataType::Int, 0,
         "logo margin",
         "minimum distance between the logo image and the surrounding screen or panel edges",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.logoMargin); },
         [] (const Config& src, Config& dest) { dest.logoMargin = src.logoMargin; }
     }, {
-        36, ConfigItem::DataType::Int, 0,
+        40, ConfigItem::DataType::Int, 0,
         "logo pos X",
         "horizontal logo position, in percent of the available area (0 = left, 50 = center, 100 = right)",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.logoPosX); },
         [] (const Config& src, Config& dest) { dest.logoPosX = src.logoPosX; }
     }, {
-        37, ConfigItem::DataType::Int, 0,
+        41, ConfigItem::DataType::Int, 0,
         "logo pos Y",
         "vertical logo position, in percent of the available area (0 = top, 50 = center, 100 = bottom)",
         nullptr, 0.0f, 100.0f,
@@ -300,35 +328,35 @@ const ConfigItem g_ConfigItems[] = { {
         "\"no module loaded\" screen",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        38, ConfigItem::DataType::Int, 0,
+        42, ConfigItem::DataType::Int, 0,
         "empty text size",
         "size of the \"no module loaded\" text",
         nullptr, 1.0f, 200.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.emptyTextSize); },
         [] (const Config& src, Config& dest) { dest.emptyTextSize = src.emptyTextSize; }
     }, {
-        39, ConfigItem::DataType::Int, 0,
+        43, ConfigItem::DataType::Int, 0,
         "empty logo pos Y",
         "vertical position of the center of the logo on the \"no module loaded\" screen",
         nullptr, 0.0f, 1000.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.emptyLogoPosY); },
         [] (const Config& src, Config& dest) { dest.emptyLogoPosY = src.emptyLogoPosY; }
     }, {
-        40, ConfigItem::DataType::Int, 0,
+        44, ConfigItem::DataType::Int, 0,
         "empty text pos Y",
         "vertical position of the \"no module loaded\" text",
         nullptr, 0.0f, 1000.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.emptyTextPosY); },
         [] (const Config& src, Config& dest) { dest.emptyTextPosY = src.emptyTextPosY; }
     }, {
-        41, ConfigItem::DataType::Color, 0,
+        45, ConfigItem::DataType::Color, 0,
         "empty text color",
         "color of the \"no module loaded\" text",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.emptyTextColor); },
         [] (const Config& src, Config& dest) { dest.emptyTextColor = src.emptyTextColor; }
     }, {
-        42, ConfigItem::DataType::Color, 0,
+        46, ConfigItem::DataType::Color, 0,
         "empty logo color",
         "logo color on the \"no module loaded\" screen",
         nullptr, 0.0f, 1.0f,
@@ -339,133 +367,133 @@ const ConfigItem g_ConfigItems[] = { {
         "info bar",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        43, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        47, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
         "info enabled",
         "whether to enable the top information bar by default after loading a module",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoEnabled); },
         [] (const Config& src, Config& dest) { dest.infoEnabled = src.infoEnabled; }
     }, {
-        44, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        48, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
         "track number enabled",
         "whether to extract and display the track number from the filename; used if the filename starts with two digits followed by a dash (-), underscore (_) or space",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.trackNumberEnabled); },
         [] (const Config& src, Config& dest) { dest.trackNumberEnabled = src.trackNumberEnabled; }
     }, {
-        45, ConfigItem::DataType::Bool, 0,
+        49, ConfigItem::DataType::Bool, 0,
         "show time",
         "show current time in track at the end of the details line",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.showTime); },
         [] (const Config& src, Config& dest) { dest.showTime = src.showTime; }
     }, {
-        46, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        50, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
         "hide file ext",
         "whether to remove the file extension from the filename in the info bar",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.hideFileExt); },
         [] (const Config& src, Config& dest) { dest.hideFileExt = src.hideFileExt; }
     }, {
-        47, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        51, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
         "auto hide file name",
         "whether to hide the filename completely if title and/or artist information is available",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.autoHideFileName); },
         [] (const Config& src, Config& dest) { dest.autoHideFileName = src.autoHideFileName; }
     }, {
-        48, ConfigItem::DataType::Int, 0,
+        52, ConfigItem::DataType::Int, 0,
         "info margin X",
         "outer left margin inside the info bar",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoMarginX); },
         [] (const Config& src, Config& dest) { dest.infoMarginX = src.infoMarginX; }
     }, {
-        49, ConfigItem::DataType::Int, 0,
+        53, ConfigItem::DataType::Int, 0,
         "info margin Y",
         "upper and lower margin inside the info bar",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoMarginY); },
         [] (const Config& src, Config& dest) { dest.infoMarginY = src.infoMarginY; }
     }, {
-        50, ConfigItem::DataType::Int, 0,
+        54, ConfigItem::DataType::Int, 0,
         "info track text size",
         "text size of the track number",
         nullptr, 1.0f, 500.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoTrackTextSize); },
         [] (const Config& src, Config& dest) { dest.infoTrackTextSize = src.infoTrackTextSize; }
     }, {
-        51, ConfigItem::DataType::Int, 0,
+        55, ConfigItem::DataType::Int, 0,
         "info text size",
         "text size of the filename, title and artist lines",
         nullptr, 1.0f, 200.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoTextSize); },
         [] (const Config& src, Config& dest) { dest.infoTextSize = src.infoTextSize; }
     }, {
-        52, ConfigItem::DataType::Int, 0,
+        56, ConfigItem::DataType::Int, 0,
         "info details text size",
         "text size of the technical details line",
         nullptr, 1.0f, 200.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoDetailsTextSize); },
         [] (const Config& src, Config& dest) { dest.infoDetailsTextSize = src.infoDetailsTextSize; }
     }, {
-        53, ConfigItem::DataType::Int, 0,
+        57, ConfigItem::DataType::Int, 0,
         "info line spacing",
         "extra space between the info bar's lines",
         nullptr, -100.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoLineSpacing); },
         [] (const Config& src, Config& dest) { dest.infoLineSpacing = src.infoLineSpacing; }
     }, {
-        54, ConfigItem::DataType::Int, 0,
+        58, ConfigItem::DataType::Int, 0,
         "info track padding X",
         "horitontal space between the track number and the other information in the info bar",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoTrackPaddingX); },
         [] (const Config& src, Config& dest) { dest.infoTrackPaddingX = src.infoTrackPaddingX; }
     }, {
-        55, ConfigItem::DataType::Int, 0,
+        59, ConfigItem::DataType::Int, 0,
         "info key padding X",
         "horizontal space between the \"File\", \"Artist\" and \"Title\" heading and the content text",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoKeyPaddingX); },
         [] (const Config& src, Config& dest) { dest.infoKeyPaddingX = src.infoKeyPaddingX; }
     }, {
-        56, ConfigItem::DataType::Color, 0,
+        60, ConfigItem::DataType::Color, 0,
         "info track color",
         "color of the track number",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoTrackColor); },
         [] (const Config& src, Config& dest) { dest.infoTrackColor = src.infoTrackColor; }
     }, {
-        57, ConfigItem::DataType::Color, 0,
+        61, ConfigItem::DataType::Color, 0,
         "info key color",
         "color of the \"File\", \"Artist\" and \"Title\" headings",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoKeyColor); },
         [] (const Config& src, Config& dest) { dest.infoKeyColor = src.infoKeyColor; }
     }, {
-        58, ConfigItem::DataType::Color, 0,
+        62, ConfigItem::DataType::Color, 0,
         "info colon color",
         "color of the colon following the headings",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoColonColor); },
         [] (const Config& src, Config& dest) { dest.infoColonColor = src.infoColonColor; }
     }, {
-        59, ConfigItem::DataType::Color, 0,
+        63, ConfigItem::DataType::Color, 0,
         "info value color",
         "color of the file, artist and title texts",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoValueColor); },
         [] (const Config& src, Config& dest) { dest.infoValueColor = src.infoValueColor; }
     }, {
-        60, ConfigItem::DataType::Color, 0,
+        64, ConfigItem::DataType::Color, 0,
         "info details color",
         "color of the technical details line",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.infoDetailsColor); },
         [] (const Config& src, Config& dest) { dest.infoDetailsColor = src.infoDetailsColor; }
     }, {
-        61, ConfigItem::DataType::Int, 0,
+        65, ConfigItem::DataType::Int, 0,
         "info shadow size",
         "width of the shadow below the info bar",
         nullptr, 0.0f, 100.0f,
@@ -476,158 +504,186 @@ const ConfigItem g_ConfigItems[] = { {
         "progress bar",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        62, ConfigItem::DataType::Bool, 0,
+        66, ConfigItem::DataType::Bool, 0,
         "progress enabled",
         "whether to show a progress bar",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.progressEnabled); },
         [] (const Config& src, Config& dest) { dest.progressEnabled = src.progressEnabled; }
     }, {
-        63, ConfigItem::DataType::Int, 0,
+        67, ConfigItem::DataType::Int, 0,
         "progress height",
         "height (\"thickness\") of the progress bar",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.progressHeight); },
         [] (const Config& src, Config& dest) { dest.progressHeight = src.progressHeight; }
     }, {
-        64, ConfigItem::DataType::Int, 0,
+        68, ConfigItem::DataType::Int, 0,
         "progress margin top",
         "extra space to insert above the progress bar",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.progressMarginTop); },
         [] (const Config& src, Config& dest) { dest.progressMarginTop = src.progressMarginTop; }
     }, {
-        65, ConfigItem::DataType::Int, 0,
+        69, ConfigItem::DataType::Int, 0,
         "progress border size",
         "size/thickness/width of the progress bar's border (0 = no border)",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.progressBorderSize); },
         [] (const Config& src, Config& dest) { dest.progressBorderSize = src.progressBorderSize; }
     }, {
-        66, ConfigItem::DataType::Int, 0,
+        70, ConfigItem::DataType::Int, 0,
         "progress border padding",
         "inside padding between the actual progress indicator and the progress bar's border",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.progressBorderPadding); },
         [] (const Config& src, Config& dest) { dest.progressBorderPadding = src.progressBorderPadding; }
     }, {
-        67, ConfigItem::DataType::Color, 0,
+        71, ConfigItem::DataType::Color, 0,
         "progress border color",
         "color of the progress bar's border",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.progressBorderColor); },
         [] (const Config& src, Config& dest) { dest.progressBorderColor = src.progressBorderColor; }
     }, {
-        68, ConfigItem::DataType::Color, 0,
+        72, ConfigItem::DataType::Color, 0,
         "progress outer color",
         "color of the progress bar's empty area (note: this is drawn on top of the border, so be careful with alpha!)",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.progressOuterColor); },
         [] (const Config& src, Config& dest) { dest.progressOuterColor = src.progressOuterColor; }
     }, {
-        69, ConfigItem::DataType::Color, 0,
+        73, ConfigItem::DataType::Color, 0,
         "progress inner color",
         "color of the actual progress indicator (note: this is drawn on top of the other two progress bar elements, so be careful with alpha!)",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.progressInnerColor); },
         [] (const Config& src, Config& dest) { dest.progressInnerColor = src.progressInnerColor; }
+    }, {
+        74, ConfigItem::DataType::Color, 0,
+        "progress order color",
+        "color of the marks that show where each order starts in the progress bar; these only appear once the module has been analyzed in the background",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.progressOrderColor); },
+        [] (const Config& src, Config& dest) { dest.progressOrderColor = src.progressOrderColor; }
+    }, {
+        75, ConfigItem::DataType::Bool, 0,
+        "progress waveform",
+        "whether to show a waveform overview of the whole song in the progress bar; this only appears once the module has been analyzed in the background",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.progressWaveform); },
+        [] (const Config& src, Config& dest) { dest.progressWaveform = src.progressWaveform; }
+    }, {
+        76, ConfigItem::DataType::Color, 0,
+        "progress wave peak color",
+        "color of the peak (minimum/maximum) part of the waveform overview",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.progressWavePeakColor); },
+        [] (const Config& src, Config& dest) { dest.progressWavePeakColor = src.progressWavePeakColor; }
+    }, {
+        77, ConfigItem::DataType::Color, 0,
+        "progress wave r m s color",
+        "color of the RMS part of the waveform overview",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.progressWaveRMSColor); },
+        [] (const Config& src, Config& dest) { dest.progressWaveRMSColor = src.progressWaveRMSColor; }
     }, {
         0, ConfigItem::DataType::SectionHeader, 0, nullptr,
         "metadata bar",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        70, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        78, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
         "meta enabled",
         "whether to enable the metadata sidebar by default after loading a module",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaEnabled); },
         [] (const Config& src, Config& dest) { dest.metaEnabled = src.metaEnabled; }
     }, {
-        71, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        79, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
         "meta show message",
         "whether the metadata sidebar shall include the module message section",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaShowMessage); },
         [] (const Config& src, Config& dest) { dest.metaShowMessage = src.metaShowMessage; }
     }, {
-        72, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        80, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
         "meta show instrument names",
         "whether the metadata sidebar shall include the instrument names section",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaShowInstrumentNames); },
         [] (const Config& src, Config& dest) { dest.metaShowInstrumentNames = src.metaShowInstrumentNames; }
     }, {
-        73, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        81, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
         "meta show sample names",
         "whether the metadata sidebar shall include the sample names section",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaShowSampleNames); },
         [] (const Config& src, Config& dest) { dest.metaShowSampleNames = src.metaShowSampleNames; }
     }, {
-        74, ConfigItem::DataType::Int, 0,
+        82, ConfigItem::DataType::Int, 0,
         "meta margin X",
         "left and right margin inside the metadata sidebar",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaMarginX); },
         [] (const Config& src, Config& dest) { dest.metaMarginX = src.metaMarginX; }
     }, {
-        75, ConfigItem::DataType::Int, 0,
+        83, ConfigItem::DataType::Int, 0,
         "meta margin Y",
         "upper and lower margin inside the metadata sidebar",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaMarginY); },
         [] (const Config& src, Config& dest) { dest.metaMarginY = src.metaMarginY; }
     }, {
-        76, ConfigItem::DataType::Int, 0,
+        84, ConfigItem::DataType::Int, 0,
         "meta text size",
         "text size in the metadata sidebar",
         nullptr, 1.0f, 200.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaTextSize); },
         [] (const Config& src, Config& dest) { dest.metaTextSize = src.metaTextSize; }
     }, {
-        77, ConfigItem::DataType::Int, ConfigItem::Flags::Reload,
+        85, ConfigItem::DataType::Int, ConfigItem::Flags::Reload,
         "meta message width",
         "approximate number of characters per line to allocate for the module message",
         nullptr, 25.0f, 80.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaMessageWidth); },
         [] (const Config& src, Config& dest) { dest.metaMessageWidth = src.metaMessageWidth; }
     }, {
-        78, ConfigItem::DataType::Int, 0,
+        86, ConfigItem::DataType::Int, 0,
         "meta section margin",
         "vertical gap between sections in the metadata sidebar",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaSectionMargin); },
         [] (const Config& src, Config& dest) { dest.metaSectionMargin = src.metaSectionMargin; }
     }, {
-        79, ConfigItem::DataType::Color, ConfigItem::Flags::Reload,
+        87, ConfigItem::DataType::Color, ConfigItem::Flags::Reload,
         "meta heading color",
         "color of a section heading in the metadata sidebar",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaHeadingColor); },
         [] (const Config& src, Config& dest) { dest.metaHeadingColor = src.metaHeadingColor; }
     }, {
-        80, ConfigItem::DataType::Color, ConfigItem::Flags::Reload,
+        88, ConfigItem::DataType::Color, ConfigItem::Flags::Reload,
         "meta text color",
         "color of normal text in the metadata sidebar",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaTextColor); },
         [] (const Config& src, Config& dest) { dest.metaTextColor = src.metaTextColor; }
     }, {
-        81, ConfigItem::DataType::Color, ConfigItem::Flags::Reload,
+        89, ConfigItem::DataType::Color, ConfigItem::Flags::Reload,
         "meta index color",
         "color of the instrument/sample numbers in the metadata sidebar",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaIndexColor); },
         [] (const Config& src, Config& dest) { dest.metaIndexColor = src.metaIndexColor; }
     }, {
-        82, ConfigItem::DataType::Color, ConfigItem::Flags::Reload,
+        90, ConfigItem::DataType::Color, ConfigItem::Flags::Reload,
         "meta colon color",
         "color of the colon between instrument/sample number and name in the metadata sidebar",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.metaColonColor); },
         [] (const Config& src, Config& dest) { dest.metaColonColor = src.metaColonColor; }
     }, {
-        83, ConfigItem::DataType::Int, 0,
+        91, ConfigItem::DataType::Int, 0,
         "meta shadow size",
         "width of the shadow left to the the metadata sidebar",
         nullptr, 0.0f, 100.0f,
@@ -638,168 +694,168 @@ const ConfigItem g_ConfigItems[] = { {
         "pattern display",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        84, ConfigItem::DataType::Int, 0,
+        92, ConfigItem::DataType::Int, 0,
         "pattern text size",
         "desired size of the pattern display text",
         nullptr, 1.0f, 200.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternTextSize); },
         [] (const Config& src, Config& dest) { dest.patternTextSize = src.patternTextSize; }
     }, {
-        85, ConfigItem::DataType::Int, 0,
+        93, ConfigItem::DataType::Int, 0,
         "pattern min text size",
         "minimum allowed size of the pattern display text (if the pattern still doesn't fit with this, some channels won't be visible)",
         nullptr, 1.0f, 200.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternMinTextSize); },
         [] (const Config& src, Config& dest) { dest.patternMinTextSize = src.patternMinTextSize; }
     }, {
-        86, ConfigItem::DataType::Int, 0,
+        94, ConfigItem::DataType::Int, 0,
         "pattern line spacing",
         "extra vertical gap between rows in the pattern display",
         nullptr, -100.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternLineSpacing); },
         [] (const Config& src, Config& dest) { dest.patternLineSpacing = src.patternLineSpacing; }
     }, {
-        87, ConfigItem::DataType::Int, 0,
+        95, ConfigItem::DataType::Int, 0,
         "pattern margin X",
         "left and right margin inside the pattern display",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternMarginX); },
         [] (const Config& src, Config& dest) { dest.patternMarginX = src.patternMarginX; }
     }, {
-        88, ConfigItem::DataType::Int, 0,
+        96, ConfigItem::DataType::Int, 0,
         "pattern bar padding X",
         "extra left and right padding of the current row bar in the pattern display",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternBarPaddingX); },
         [] (const Config& src, Config& dest) { dest.patternBarPaddingX = src.patternBarPaddingX; }
     }, {
-        89, ConfigItem::DataType::Int, 0,
+        97, ConfigItem::DataType::Int, 0,
         "pattern bar border percent",
         "border radius of the current row bar, in percent of the text size",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternBarBorderPercent); },
         [] (const Config& src, Config& dest) { dest.patternBarBorderPercent = src.patternBarBorderPercent; }
     }, {
-        90, ConfigItem::DataType::Color, 0,
+        98, ConfigItem::DataType::Color, 0,
         "pattern logo color",
         "color of the background logo",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternLogoColor); },
         [] (const Config& src, Config& dest) { dest.patternLogoColor = src.patternLogoColor; }
     }, {
-        91, ConfigItem::DataType::Color, 0,
+        99, ConfigItem::DataType::Color, 0,
         "pattern bar background",
         "fill color of the current row bar",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternBarBackground); },
         [] (const Config& src, Config& dest) { dest.patternBarBackground = src.patternBarBackground; }
     }, {
-        92, ConfigItem::DataType::Color, 0,
+        100, ConfigItem::DataType::Color, 0,
         "pattern text color",
         "color of normal text in the pattern display (not used, as everything in the pattern display is covered by the following highlighting colors)",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternTextColor); },
         [] (const Config& src, Config& dest) { dest.patternTextColor = src.patternTextColor; }
     }, {
-        93, ConfigItem::DataType::Color, 0,
+        101, ConfigItem::DataType::Color, 0,
         "pattern dot color",
         "text color of the dots indicating unset notes/instruments/effects etc.",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternDotColor); },
         [] (const Config& src, Config& dest) { dest.patternDotColor = src.patternDotColor; }
     }, {
-        94, ConfigItem::DataType::Color, 0,
+        102, ConfigItem::DataType::Color, 0,
         "pattern note color",
         "text color of normal notes (e.g. \"G#4\")",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternNoteColor); },
         [] (const Config& src, Config& dest) { dest.patternNoteColor = src.patternNoteColor; }
     }, {
-        95, ConfigItem::DataType::Color, 0,
+        103, ConfigItem::DataType::Color, 0,
         "pattern special color",
         "text color of special notes (e.g. \"===\")",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternSpecialColor); },
         [] (const Config& src, Config& dest) { dest.patternSpecialColor = src.patternSpecialColor; }
     }, {
-        96, ConfigItem::DataType::Color, 0,
+        104, ConfigItem::DataType::Color, 0,
         "pattern instrument color",
         "text color of the instrument/sample index column",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternInstrumentColor); },
         [] (const Config& src, Config& dest) { dest.patternInstrumentColor = src.patternInstrumentColor; }
     }, {
-        97, ConfigItem::DataType::Color, 0,
+        105, ConfigItem::DataType::Color, 0,
         "pattern vol effect color",
         "text color of the volume effect column (e.g. the 'v' before the volume)",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternVolEffectColor); },
         [] (const Config& src, Config& dest) { dest.patternVolEffectColor = src.patternVolEffectColor; }
     }, {
-        98, ConfigItem::DataType::Color, 0,
+        106, ConfigItem::DataType::Color, 0,
         "pattern vol param color",
         "text color of the volume effect parameter column",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternVolParamColor); },
         [] (const Config& src, Config& dest) { dest.patternVolParamColor = src.patternVolParamColor; }
     }, {
-        99, ConfigItem::DataType::Color, 0,
+        107, ConfigItem::DataType::Color, 0,
         "pattern effect color",
         "text color of the effect type column",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternEffectColor); },
         [] (const Config& src, Config& dest) { dest.patternEffectColor = src.patternEffectColor; }
     }, {
-        100, ConfigItem::DataType::Color, 0,
+        108, ConfigItem::DataType::Color, 0,
         "pattern effect param color",
         "text color of the effect parameter column",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternEffectParamColor); },
         [] (const Config& src, Config& dest) { dest.patternEffectParamColor = src.patternEffectParamColor; }
     }, {
-        101, ConfigItem::DataType::Color, 0,
+        109, ConfigItem::DataType::Color, 0,
         "pattern pos order color",
         "text color of the order number",
         nullptr, 0.0f, 1000.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternPosOrderColor); },
         [] (const Config& src, Config& dest) { dest.patternPosOrderColor = src.patternPosOrderColor; }
     }, {
-        102, ConfigItem::DataType::Color, 0,
+        110, ConfigItem::DataType::Color, 0,
         "pattern pos pattern color",
         "text color of the pattern number",
         nullptr, 0.0f, 1000.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternPosPatternColor); },
         [] (const Config& src, Config& dest) { dest.patternPosPatternColor = src.patternPosPatternColor; }
     }, {
-        103, ConfigItem::DataType::Color, 0,
+        111, ConfigItem::DataType::Color, 0,
         "pattern pos row color",
         "text color of the row number",
         nullptr, 0.0f, 1000.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternPosRowColor); },
         [] (const Config& src, Config& dest) { dest.patternPosRowColor = src.patternPosRowColor; }
     }, {
-        104, ConfigItem::DataType::Color, 0,
+        112, ConfigItem::DataType::Color, 0,
         "pattern pos dot color",
         "text color of the colon or dot between the order/pattern/row numbers",
         nullptr, 0.0f, 1000.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternPosDotColor); },
         [] (const Config& src, Config& dest) { dest.patternPosDotColor = src.patternPosDotColor; }
     }, {
-        105, ConfigItem::DataType::Color, 0,
+        113, ConfigItem::DataType::Color, 0,
         "pattern sep color",
         "text color of the bar ('|') between channels",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternSepColor); },
         [] (const Config& src, Config& dest) { dest.patternSepColor = src.patternSepColor; }
     }, {
-        106, ConfigItem::DataType::Float, 0,
+        114, ConfigItem::DataType::Float, 0,
         "pattern alpha falloff",
         "amount of alpha falloff for the outermost rows in the pattern display; 0.0 = no falloff, 1.0 = falloff to full transparency",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.patternAlphaFalloff); },
         [] (const Config& src, Config& dest) { dest.patternAlphaFalloff = src.patternAlphaFalloff; }
     }, {
-        107, ConfigItem::DataType::Float, 0,
+        115, ConfigItem::DataType::Float, 0,
         "pattern alpha falloff shape",
         "shape (power) of the alpha falloff in the pattern display; the higher, the more rows will retain a relatively high opacity",
         nullptr, 0.1f, 10.0f,
@@ -810,35 +866,35 @@ const ConfigItem g_ConfigItems[] = { {
         "channel names",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        108, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        116, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
         "channel names enabled",
         "whether to enable the channel name displays by default after loading a module",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.channelNamesEnabled); },
         [] (const Config& src, Config& dest) { dest.channelNamesEnabled = src.channelNamesEnabled; }
     }, {
-        109, ConfigItem::DataType::Int, 0,
+        117, ConfigItem::DataType::Int, 0,
         "channel name padding Y",
         "extra vertical padding in the channel name boxes",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.channelNamePaddingY); },
         [] (const Config& src, Config& dest) { dest.channelNamePaddingY = src.channelNamePaddingY; }
     }, {
-        110, ConfigItem::DataType::Color, 0,
+        118, ConfigItem::DataType::Color, 0,
         "channel name upper color",
         "color of the upper end of the channel name boxes",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.channelNameUpperColor); },
         [] (const Config& src, Config& dest) { dest.channelNameUpperColor = src.channelNameUpperColor; }
     }, {
-        111, ConfigItem::DataType::Color, 0,
+        119, ConfigItem::DataType::Color, 0,
         "channel name lower color",
         "color of the lower end of the channel name boxes",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.channelNameLowerColor); },
         [] (const Config& src, Config& dest) { dest.channelNameLowerColor = src.channelNameLowerColor; }
     }, {
-        112, ConfigItem::DataType::Color, 0,
+        120, ConfigItem::DataType::Color, 0,
         "channel name text color",
         "channel name text color",
         nullptr, 0.0f, 1.0f,
@@ -849,81 +905,152 @@ const ConfigItem g_ConfigItems[] = { {
         "fake VU meters",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        113, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        121, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
         "VU enabled",
         "whether to enable the fake VU meters by default after loading a module",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.vuEnabled); },
         [] (const Config& src, Config& dest) { dest.vuEnabled = src.vuEnabled; }
     }, {
-        114, ConfigItem::DataType::Int, 0,
+        122, ConfigItem::DataType::Int, 0,
         "VU height",
         "height of the fake VU meters",
         nullptr, 0.0f, 1000.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.vuHeight); },
         [] (const Config& src, Config& dest) { dest.vuHeight = src.vuHeight; }
     }, {
-        115, ConfigItem::DataType::Color, 0,
+        123, ConfigItem::DataType::Color, 0,
         "VU upper color",
         "color of the upper end of the fake VU meters",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.vuUpperColor); },
         [] (const Config& src, Config& dest) { dest.vuUpperColor = src.vuUpperColor; }
     }, {
-        116, ConfigItem::DataType::Color, 0,
+        124, ConfigItem::DataType::Color, 0,
         "VU lower color",
         "color of the lower end of the fake VU meters",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.vuLowerColor); },
         [] (const Config& src, Config& dest) { dest.vuLowerColor = src.vuLowerColor; }
+    }, {
+        0, ConfigItem::DataType::SectionHeader, 0, nullptr,
+        "spectrum analyzer",
+        nullptr, 0.0f, 0.0f, nullptr, nullptr
+    }, {
+        125, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        "spectrum enabled",
+        "whether to enable the spectrum analyzer (which, unlike the VU meters, shows the actual audio output) by default after loading a module",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.spectrumEnabled); },
+        [] (const Config& src, Config& dest) { dest.spectrumEnabled = src.spectrumEnabled; }
+    }, {
+        126, ConfigItem::DataType::Int, 0,
+        "spectrum height",
+        "height of the spectrum analyzer",
+        nullptr, 0.0f, 1000.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.spectrumHeight); },
+        [] (const Config& src, Config& dest) { dest.spectrumHeight = src.spectrumHeight; }
+    }, {
+        127, ConfigItem::DataType::Int, 0,
+        "spectrum bands",
+        "number of frequency bands in the spectrum analyzer",
+        nullptr, 4.0f, 256.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.spectrumBands); },
+        [] (const Config& src, Config& dest) { dest.spectrumBands = src.spectrumBands; }
+    }, {
+        128, ConfigItem::DataType::Color, 0,
+        "spectrum upper color",
+        "color of the upper end of the spectrum analyzer bars",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.spectrumUpperColor); },
+        [] (const Config& src, Config& dest) { dest.spectrumUpperColor = src.spectrumUpperColor; }
+    }, {
+        129, ConfigItem::DataType::Color, 0,
+        "spectrum lower color",
+        "color of the lower end of the spectrum analyzer bars",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.spectrumLowerColor); },
+        [] (const Config& src, Config& dest) { dest.spectrumLowerColor = src.spectrumLowerColor; }
+    }, {
+        0, ConfigItem::DataType::SectionHeader, 0, nullptr,
+        "channel oscilloscopes",
+        nullptr, 0.0f, 0.0f, nullptr, nullptr
+    }, {
+        130, ConfigItem::DataType::Bool, ConfigItem::Flags::Reload,
+        "scopes enabled",
+        "whether to enable the per-channel oscilloscopes by default after loading a module; note that these need additional module instances (up to one per channel), running on all spare CPU cores",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.scopesEnabled); },
+        [] (const Config& src, Config& dest) { dest.scopesEnabled = src.scopesEnabled; }
+    }, {
+        131, ConfigItem::DataType::Int, 0,
+        "scope height",
+        "height of the channel oscilloscopes",
+        nullptr, 0.0f, 1000.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.scopeHeight); },
+        [] (const Config& src, Config& dest) { dest.scopeHeight = src.scopeHeight; }
+    }, {
+        132, ConfigItem::DataType::Float, 0,
+        "scope gain",
+        "amplification of the signal shown in the channel oscilloscopes",
+        nullptr, 0.1f, 20.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.scopeGain); },
+        [] (const Config& src, Config& dest) { dest.scopeGain = src.scopeGain; }
+    }, {
+        133, ConfigItem::DataType::Color, 0,
+        "scope color",
+        "color of the channel oscilloscopes",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.scopeColor); },
+        [] (const Config& src, Config& dest) { dest.scopeColor = src.scopeColor; }
     }, {
         0, ConfigItem::DataType::SectionHeader, 0, nullptr,
         "clipping indicator",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        117, ConfigItem::DataType::Bool, 0,
+        134, ConfigItem::DataType::Bool, 0,
         "clip enabled",
         "whether the clipping indicator is enabled",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.clipEnabled); },
         [] (const Config& src, Config& dest) { dest.clipEnabled = src.clipEnabled; }
     }, {
-        118, ConfigItem::DataType::Int, 0,
+        135, ConfigItem::DataType::Int, 0,
         "clip size",
         "circumference of the clipping indicator",
         nullptr, 0.0f, 200.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.clipSize); },
         [] (const Config& src, Config& dest) { dest.clipSize = src.clipSize; }
     }, {
-        119, ConfigItem::DataType::Int, 0,
+        136, ConfigItem::DataType::Int, 0,
         "clip pos X",
         "horizontal clipping indicator position, in percent of the available area (0 = left, 50 = center, 100 = right)",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.clipPosX); },
         [] (const Config& src, Config& dest) { dest.clipPosX = src.clipPosX; }
     }, {
-        120, ConfigItem::DataType::Int, 0,
+        137, ConfigItem::DataType::Int, 0,
         "clip pos Y",
         "vertical clipping indicator position, in percent of the available area (0 = top, 50 = center, 100 = bottom)",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.clipPosY); },
         [] (const Config& src, Config& dest) { dest.clipPosY = src.clipPosY; }
     }, {
-        121, ConfigItem::DataType::Int, 0,
+        138, ConfigItem::DataType::Int, 0,
         "clip margin",
         "margin around the screen edges that clipPos may not exceed, even at the 0/100 settings",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.clipMargin); },
         [] (const Config& src, Config& dest) { dest.clipMargin = src.clipMargin; }
     }, {
-        122, ConfigItem::DataType::Color, 0,
+        139, ConfigItem::DataType::Color, 0,
         "clip color",
         "color of the clipping indicator",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.clipColor); },
         [] (const Config& src, Config& dest) { dest.clipColor = src.clipColor; }
     }, {
-        123, ConfigItem::DataType::Float, 0,
+        140, ConfigItem::DataType::Float, 0,
         "clip fade time",
         "time the clipping indicator takes to fade out completely, in seconds",
         nullptr, 0.0f, 60.0f,
@@ -934,54 +1061,93 @@ const ConfigItem g_ConfigItems[] = { {
         "toast messages",
         nullptr, 0.0f, 0.0f, nullptr, nullptr
     }, {
-        124, ConfigItem::DataType::Int, 0,
+        141, ConfigItem::DataType::Int, 0,
         "toast text size",
         "text size of a \"toast\" status message",
         nullptr, 1.0f, 200.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.toastTextSize); },
         [] (const Config& src, Config& dest) { dest.toastTextSize = src.toastTextSize; }
     }, {
-        125, ConfigItem::DataType::Int, 0,
+        142, ConfigItem::DataType::Int, 0,
         "toast margin X",
         "left and right margin inside a \"toast\" status message (not including the rounded borders)",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.toastMarginX); },
         [] (const Config& src, Config& dest) { dest.toastMarginX = src.toastMarginX; }
     }, {
-        126, ConfigItem::DataType::Int, 0,
+        143, ConfigItem::DataType::Int, 0,
         "toast margin Y",
         "top and bottom margin inside a \"toast\" status message",
         nullptr, 0.0f, 100.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.toastMarginY); },
         [] (const Config& src, Config& dest) { dest.toastMarginY = src.toastMarginY; }
     }, {
-        127, ConfigItem::DataType::Int, 0,
+        144, ConfigItem::DataType::Int, 0,
         "toast position Y",
         "vertical position of a \"toast\" status message, relative to the top of the display",
         nullptr, 0.0f, 1000.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.toastPositionY); },
         [] (const Config& src, Config& dest) { dest.toastPositionY = src.toastPositionY; }
     }, {
-        128, ConfigItem::DataType::Color, 0,
+        145, ConfigItem::DataType::Color, 0,
         "toast background color",
         "background color of a \"toast\" status message",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.toastBackgroundColor); },
         [] (const Config& src, Config& dest) { dest.toastBackgroundColor = src.toastBackgroundColor; }
     }, {
-        129, ConfigItem::DataType::Color, 0,
+        146, ConfigItem::DataType::Color, 0,
         "toast text color",
         "text color of a \"toast\" status message",
         nullptr, 0.0f, 1.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.toastTextColor); },
         [] (const Config& src, Config& dest) { dest.toastTextColor = src.toastTextColor; }
     }, {
-        130, ConfigItem::DataType::Float, 0,
+        147, ConfigItem::DataType::Float, 0,
         "toast duration",
         "time a \"toast\" status message shall be visible until it's completely faded out",
         nullptr, 0.0f, 60.0f,
         [] (Config& src) -> void* { return static_cast<void*>(&src.toastDuration); },
         [] (const Config& src, Config& dest) { dest.toastDuration = src.toastDuration; }
+    }, {
+        0, ConfigItem::DataType::SectionHeader, 0, nullptr,
+        "diagnostics",
+        nullptr, 0.0f, 0.0f, nullptr, nullptr
+    }, {
+        148, ConfigItem::DataType::String, ConfigItem::Flags::Startup,
+        "trace",
+        "if set, record a timeline of audio callbacks, frames, module loads etc. and write it into this file in Chrome trace-event JSON format on exit (view with ui.perfetto.dev or chrome://tracing)",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.trace); },
+        [] (const Config& src, Config& dest) { dest.trace = src.trace; }
+    }, {
+        149, ConfigItem::DataType::Int, ConfigItem::Flags::Startup,
+        "control port",
+        "if nonzero, accept remote control commands and metrics queries on this TCP port on the loopback interface (use an SSH tunnel to access it from another machine)",
+        nullptr, 0.0f, 65535.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.controlPort); },
+        [] (const Config& src, Config& dest) { dest.controlPort = src.controlPort; }
+    }, {
+        150, ConfigItem::DataType::String, ConfigItem::Flags::Startup,
+        "record",
+        "if set, record all key presses, dropped files, window resizes and mouse wheel events along with their timing into this file",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.record); },
+        [] (const Config& src, Config& dest) { dest.record = src.record; }
+    }, {
+        151, ConfigItem::DataType::String, ConfigItem::Flags::Startup,
+        "replay",
+        "if set, replay the events recorded into this file with the 'record' option (use the same module file or directory on the command line as during recording); most useful with the tm_headless tool, which replays with a deterministic virtual clock",
+        nullptr, 0.0f, 1.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.replay); },
+        [] (const Config& src, Config& dest) { dest.replay = src.replay; }
+    }, {
+        152, ConfigItem::DataType::Int, ConfigItem::Flags::Global,
+        "memory budget",
+        "memory budget for module data, caches, metadata text and textures, in MiB; if it's exceeded, the least valuable cached data is discarded first (0 = unlimited; current usage is shown with F4 and in the remote control metrics)",
+        nullptr, 0.0f, 65536.0f,
+        [] (Config& src) -> void* { return static_cast<void*>(&src.memoryBudget); },
+        [] (const Config& src, Config& dest) { dest.memoryBudget = src.memoryBudget; }
     },
     { 0, ConfigItem::DataType::SectionHeader, 0, nullptr, nullptr, nullptr, 0.0f, 0.0f, nullptr, nullptr }
 };
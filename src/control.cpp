@@ -0,0 +1,318 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+#else
+    #include <sys/types.h>
+    #include <sys/socket.h>
+    #include <sys/select.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <string>
+#include <mutex>
+#include <thread>
+
+#include "util.h"
+#include "metrics.h"
+#include "control.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// platform abstraction
+
+#ifdef _WIN32
+    using NativeSocket = SOCKET;
+    static inline void closeSocket(NativeSocket s) { closesocket(s); }
+#else
+    using NativeSocket = int;
+    static inline void closeSocket(NativeSocket s) { close(s); }
+#endif
+#ifdef MSG_NOSIGNAL
+    constexpr int sendFlags = MSG_NOSIGNAL;  // don't die from SIGPIPE if the client disconnects
+#else
+    constexpr int sendFlags = 0;
+#endif
+
+//! maximum length of a command line; longer lines are ignored
+constexpr size_t maxLineLength = 4096;
+
+//! wait until a socket becomes readable, or the timeout expires
+static bool waitReadable(NativeSocket s, int timeoutMsec) {
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(s, &fds);
+    struct timeval tv;
+    tv.tv_sec = timeoutMsec / 1000;
+    tv.tv_usec = (timeoutMsec % 1000) * 1000;
+    return select(int(s) + 1, &fds, nullptr, nullptr, &tv) > 0;
+}
+
+static bool sendAll(NativeSocket s, const std::string& data) {
+    const char* pos = data.c_str();
+    size_t remain = data.size();
+    while (remain) {
+        auto sent = send(s, pos, int(remain), sendFlags);
+        if (sent <= 0) { return false; }
+        pos += sent;
+        remain -= size_t(sent);
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// server thread
+
+bool ControlServer::start(int port) {
+    stop();
+    #ifdef _WIN32
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa)) { return false; }
+    #endif
+    NativeSocket s = socket(AF_INET, SOCK_STREAM, 0);
+    #ifdef _WIN32
+        if (s == INVALID_SOCKET) { Dprintf("control server: socket() failed\n"); return false; }
+    #else
+        if (s < 0) { Dprintf("control server: socket() failed\n"); return false; }
+    #endif
+    int yes = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&yes), sizeof(yes));
+    struct sockaddr_in addr;
+    ::memset(static_cast<void*>(&addr), 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(uint16_t(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // never accept connections from other hosts
+    if (bind(s, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) || listen(s, 1)) {
+        Dprintf("control server: could not listen on port %d\n", port);
+        closeSocket(s);
+        return false;
+    }
+    m_listener = Socket(s);
+    m_quit = false;
+    m_thread = new std::thread(&ControlServer::run, this);
+    Dprintf("control server: listening on 127.0.0.1:%d\n", port);
+    return true;
+}
+
+void ControlServer::stop() {
+    if (m_thread) {
+        m_quit = true;
+        m_thread->join();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    if (m_listener != ~Socket(0)) {
+        closeSocket(NativeSocket(m_listener));
+        m_listener = ~Socket(0);
+        #ifdef _WIN32
+            WSACleanup();
+        #endif
+    }
+    std::lock_guard<std::mutex> lock(m_queueLock);
+    m_queue.clear();
+}
+
+void ControlServer::run() {
+    NativeSocket listener = NativeSocket(m_listener);
+    while (!m_quit) {
+        if (!waitReadable(listener, 200)) { continue; }
+        NativeSocket client = accept(listener, nullptr, nullptr);
+        #ifdef _WIN32
+            if (client == INVALID_SOCKET) { continue; }
+        #else
+            if (client < 0) { continue; }
+        #endif
+        Dprintf("control server: client connected\n");
+        serveClient(Socket(client));
+        closeSocket(client);
+        Dprintf("control server: client disconnected\n");
+    }
+}
+
+void ControlServer::serveClient(Socket client_) {
+    NativeSocket client = NativeSocket(client_);
+    std::string line, reply;
+    bool overlong = false;
+    char buffer[512];
+    while (!m_quit) {
+        if (!waitReadable(client, 200)) { continue; }
+        auto size = recv(client, buffer, int(sizeof(buffer)), 0);
+        if (size <= 0) { return; }
+        for (int i = 0;  i < int(size);  ++i) {
+            char c = buffer[i];
+            if (c == '\r') { continue; }
+            if (c != '\n') {
+                if (line.size() < maxLineLength) { line.push_back(c); }
+                else { overlong = true; }
+                continue;
+            }
+            reply.clear();
+            bool keep = true;
+            if (overlong) {
+                reply.assign("ERROR line too long\n");
+            } else {
+                keep = handleLine(line.c_str(), reply);
+            }
+            line.clear();
+            overlong = false;
+            if (!sendAll(client, reply) || !keep) { return; }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// command parsing
+
+static bool matchWord(const char* &pos, const char* word) {
+    size_t len = strlen(word);
+    for (size_t i = 0;  i < len;  ++i) {
+        if (toLower(pos[i]) != word[i]) { return false; }
+    }
+    if (pos[len] && !isSpace(pos[len])) { return false; }
+    pos += len;
+    while (isSpace(*pos)) { ++pos; }
+    return true;
+}
+
+bool ControlServer::handleLine(const char* line, std::string& reply) {
+    while (isSpace(*line)) { ++line; }
+    if (!*line) {
+        return true;  // silently ignore empty lines
+    } else if (matchWord(line, "quit") || matchWord(line, "exit")) {
+        reply.assign("OK\n");
+        return false;
+    } else if (matchWord(line, "help")) {
+        reply.assign(
+            "key [ctrl+][shift+][alt+]<name>  - press a key (e.g. 'key space', 'key ctrl+L', 'key PgDn')\n"
+            "load <path>                      - load a module\n"
+            "metrics [section]                - report metrics (position, audio, frames, latency, cache, memory)\n"
+            "quit                             - close connection\n"
+            "OK\n");
+    } else if (matchWord(line, "key")) {
+        Command cmd;
+        cmd.type = Command::Type::Key;
+        cmd.timeUs = Metrics::nowUs();
+        if (!parseKey(line, cmd)) {
+            reply.assign("ERROR unknown key\n");
+        } else {
+            std::lock_guard<std::mutex> lock(m_queueLock);
+            m_queue.push_back(cmd);
+            reply.assign("OK\n");
+        }
+    } else if (matchWord(line, "load")) {
+        if (!*line) {
+            reply.assign("ERROR missing path\n");
+        } else {
+            Command cmd;
+            cmd.type = Command::Type::Load;
+            cmd.timeUs = Metrics::nowUs();
+            cmd.path.assign(line);
+            while (!cmd.path.empty() && isSpace(cmd.path.back())) { cmd.path.pop_back(); }
+            std::lock_guard<std::mutex> lock(m_queueLock);
+            m_queue.push_back(cmd);
+            reply.assign("OK\n");
+        }
+    } else if (matchWord(line, "metrics")) {
+        std::string section(line);
+        while (!section.empty() && isSpace(section.back())) { section.pop_back(); }
+        if (g_metrics.report(reply, section.c_str())) {
+            reply.append("OK\n");
+        } else {
+            reply.assign("ERROR unknown metrics section\n");
+        }
+    } else {
+        reply.assign("ERROR unknown command\n");
+    }
+    return true;
+}
+
+bool ControlServer::parseKey(const char* spec, Command& cmd) {
+    std::string name(spec);
+    while (!name.empty() && isSpace(name.back())) { name.pop_back(); }
+    cmd.ctrl = cmd.shift = cmd.alt = false;
+
+    // strip modifier prefixes
+    for (;;) {
+        auto sep = name.find('+');
+        if ((sep == std::string::npos) || (sep == 0) || (sep == (name.size() - 1u))) { break; }
+        std::string mod(name.substr(0, sep));
+        for (auto& c : mod) { c = toLower(c); }
+        if      (mod == "ctrl")  { cmd.ctrl  = true; }
+        else if (mod == "shift") { cmd.shift = true; }
+        else if (mod == "alt")   { cmd.alt   = true; }
+        else { break; }
+        name.erase(0, sep + 1u);
+    }
+    if (name.empty()) { return false; }
+
+    // single characters are taken literally (letters in uppercase)
+    if (name.size() == 1u) {
+        char c = name[0];
+        if ((c >= 'a') && (c <= 'z')) { c -= 32; }
+        cmd.key = c;
+        return true;
+    }
+
+    // named keys
+    std::string lname(name);
+    for (auto& c : lname) { c = toLower(c); }
+    if ((lname[0] == 'f') && isDigit(lname[1])) {
+        int n = atoi(&lname[1]);
+        if ((n < 1) || (n > 12)) { return false; }
+        cmd.key = 0xF0 + n;
+        return true;
+    }
+    static const struct { const char* name; int key; } namedKeys[] = {
+        { "space",  ' '  },
+        { "enter",  '\r' },
+        { "return", '\r' },
+        { "tab",    '\t' },
+        { "esc",    27   },
+        { "escape", 27   },
+        { "plus",   '+'  },
+        { "minus",  '-'  },
+        { "left",   int(makeFourCC("Left"))  },
+        { "right",  int(makeFourCC("Right")) },
+        { "up",     int(makeFourCC("Up"))    },
+        { "down",   int(makeFourCC("Down"))  },
+        { "pgup",   int(makeFourCC("PgUp"))  },
+        { "pgdn",   int(makeFourCC("PgDn"))  },
+        { "home",   int(makeFourCC("Home"))  },
+        { "end",    int(makeFourCC("End"))   },
+        { "ins",    int(makeFourCC("Ins"))   },
+        { "del",    int(makeFourCC("Del"))   },
+        { "kp+",    int(makeFourCC("KP+"))   },
+        { "kp-",    int(makeFourCC("KP-"))   },
+    };
+    for (const auto& k : namedKeys) {
+        if (lname == k.name) { cmd.key = k.key; return true; }
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// main thread interface
+
+bool ControlServer::poll(Command& cmd) {
+    // never wait for the server thread; if it's busy, we'll try next frame
+    std::unique_lock<std::mutex> lock(m_queueLock, std::try_to_lock);
+    if (!lock.owns_lock() || m_queue.empty()) { return false; }
+    cmd = std::move(m_queue.front());
+    m_queue.pop_front();
+    return true;
+}
@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+//! Remote control server.
+//!
+//! Listens on a TCP port on the loopback interface (so it can be reached
+//! from other machines only through an SSH tunnel or similar) and accepts
+//! a simple line-based text protocol:
+//! - "key [ctrl+][shift+][alt+]<name>" simulates a key press
+//! - "load <path>" loads a module
+//! - "metrics [section]" reports metrics from g_metrics
+//! - "help" lists the commands, "quit" closes the connection
+//! Every reply ends with a line that is either "OK" or "ERROR <message>".
+//!
+//! Commands are executed by the main thread, which polls them once per
+//! frame; metrics are answered directly from the server thread.
+class ControlServer {
+public:
+    struct Command {
+        enum class Type { Key, Load } type;
+        int key = 0;
+        bool ctrl = false, shift = false, alt = false;
+        std::string path;
+        uint64_t timeUs = 0;  //!< time of reception, in Metrics::nowUs() units
+    };
+
+    inline ControlServer() {}
+    inline ~ControlServer() { stop(); }
+
+    //! start listening on the specified port
+    //! \returns false if the server could not be started
+    bool start(int port);
+
+    //! stop the server thread and close all sockets
+    void stop();
+
+    //! fetch the next pending command; never blocks
+    //! \returns false if there's no pending command
+    bool poll(Command& cmd);
+
+    //! parse a key specification like "ctrl+shift+S" or "PgDn"
+    //! into a key code as used by Application::handleKey()
+    //! \returns false if the key name is not recognized
+    static bool parseKey(const char* spec, Command& cmd);
+
+private:
+    using Socket = uintptr_t;  // large enough for both POSIX fds and WinSock SOCKETs
+    Socket m_listener = ~Socket(0);
+    std::thread* m_thread = nullptr;
+    std::atomic<bool> m_quit = false;
+    std::mutex m_queueLock;
+    std::deque<Command> m_queue;
+
+    void run();
+    void serveClient(Socket client);
+    bool handleLine(const char* line, std::string& reply);
+};
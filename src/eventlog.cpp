@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <string>
+#include <vector>
+
+#include "util.h"
+#include "eventlog.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// recording
+
+bool EventLog::startRecording(const char* filename) {
+    stopRecording(0.0);
+    if (!filename || !filename[0]) { return false; }
+    m_recordFile = fopen(filename, "w");
+    if (!m_recordFile) { return false; }
+    fprintf(m_recordFile, "# TrackMeister event log\n");
+    return true;
+}
+
+void EventLog::record(const Event& ev) {
+    if (!m_recordFile) { return; }
+    fprintf(m_recordFile, "%.6f ", ev.time);
+    switch (ev.type) {
+        case Type::Key:
+            fprintf(m_recordFile, "key %d %s%s%s\n", ev.key, ev.ctrl ? "c" : "", ev.shift ? "s" : "", ev.alt ? "a" : "");
+            break;
+        case Type::Drop:   fprintf(m_recordFile, "drop %s\n", ev.path.c_str());         break;
+        case Type::Resize: fprintf(m_recordFile, "resize %d %d\n", ev.x, ev.y);         break;
+        case Type::Wheel:  fprintf(m_recordFile, "wheel %d\n", ev.key);                 break;
+        case Type::Click:  fprintf(m_recordFile, "click %d %d\n", ev.x, ev.y);          break;
+        case Type::End:    fprintf(m_recordFile, "end\n");                              break;
+    }
+    fflush(m_recordFile);  // events are rare, and we want to have them even after a crash
+}
+
+void EventLog::stopRecording(double time) {
+    if (!m_recordFile) { return; }
+    Event ev;
+    ev.time = time;
+    ev.type = Type::End;
+    record(ev);
+    fclose(m_recordFile);
+    m_recordFile = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// replay
+
+static bool matchToken(const char* &pos, const char* token) {
+    size_t len = strlen(token);
+    if (strncmp(pos, token, len) || (pos[len] && !isSpace(pos[len]))) { return false; }
+    pos += len;
+    while (isSpace(*pos)) { ++pos; }
+    return true;
+}
+
+bool EventLog::loadReplay(const char* filename) {
+    m_replay.clear();
+    m_replayPos = 0;
+    if (!filename || !filename[0]) { return false; }
+    FILE* f = fopen(filename, "r");
+    if (!f) { return false; }
+    char line[4096];
+    int lineNo = 0;
+    bool ok = true;
+    while (ok && fgets(line, int(sizeof(line)), f)) {
+        ++lineNo;
+        size_t len = strlen(line);
+        while (len && ((line[len-1] == '\n') || (line[len-1] == '\r'))) { line[--len] = '\0'; }
+        const char* pos = line;
+        while (isSpace(*pos)) { ++pos; }
+        if (!*pos || (*pos == '#')) { continue; }
+        Event ev;
+        char* end = nullptr;
+        ev.time = strtod(pos, &end);
+        ok = (end != pos);
+        pos = end;
+        while (isSpace(*pos)) { ++pos; }
+        if (!ok) {
+            // handled below
+        } else if (matchToken(pos, "key")) {
+            ev.type = Type::Key;
+            ev.key = int(strtol(pos, &end, 10));
+            ok = (end != pos);
+            for (pos = end;  *pos;  ++pos) {
+                if      (*pos == 'c') { ev.ctrl  = true; }
+                else if (*pos == 's') { ev.shift = true; }
+                else if (*pos == 'a') { ev.alt   = true; }
+            }
+        } else if (matchToken(pos, "drop")) {
+            ev.type = Type::Drop;
+            ev.path.assign(pos);
+            ok = !ev.path.empty();
+        } else if (matchToken(pos, "resize")) {
+            ev.type = Type::Resize;
+            ev.x = int(strtol(pos, &end, 10));
+            ev.y = int(strtol(end, &end, 10));
+            ok = (ev.x > 0) && (ev.y > 0);
+        } else if (matchToken(pos, "wheel")) {
+            ev.type = Type::Wheel;
+            ev.key = int(strtol(pos, &end, 10));
+            ok = (end != pos);
+        } else if (matchToken(pos, "click")) {
+            ev.type = Type::Click;
+            ev.x = int(strtol(pos, &end, 10));
+            ok = (end != pos);
+            pos = end;
+            ev.y = int(strtol(pos, &end, 10));
+            ok = ok && (end != pos);
+        } else if (matchToken(pos, "end")) {
+            ev.type = Type::End;
+        } else {
+            ok = false;
+        }
+        if (ok) { m_replay.push_back(ev); }
+    }
+    fclose(f);
+    if (!ok) {
+        Dprintf("event log '%s' is malformed in line %d\n", filename, lineNo);
+        (void)lineNo;  // not used in Release builds
+        m_replay.clear();
+        return false;
+    }
+    Dprintf("loaded %d events for replay from '%s'\n", int(m_replay.size()), filename);
+    return !m_replay.empty();
+}
+
+bool EventLog::nextDue(double time, Event& ev) {
+    while ((m_replayPos < m_replay.size()) && (m_replay[m_replayPos].time <= time)) {
+        const Event& next = m_replay[m_replayPos++];
+        if (next.type != Type::End) { ev = next; return true; }
+    }
+    return false;
+}
@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+//! Input event recorder and player.
+//!
+//! Events are stored in a line-based text file, one event per line,
+//! each starting with the application time (in seconds, as accumulated
+//! from the frame times passed to Application::draw()) of the frame
+//! *before* which the event has been handled:
+//! - "<time> key <code> [c][s][a]" (key code as used by handleKey(),
+//!   optionally followed by the Ctrl/Shift/Alt modifier flags)
+//! - "<time> drop <path>"
+//! - "<time> resize <width> <height>"
+//! - "<time> wheel <delta>"
+//! - "<time> click <x> <y>" (left mouse button, in pixels)
+//! - "<time> end" (end of the recording)
+//! Lines starting with '#' are comments.
+class EventLog {
+public:
+    enum class Type { Key, Drop, Resize, Wheel, Click, End };
+    struct Event {
+        double time = 0.0;
+        Type type = Type::End;
+        int key = 0;       //!< key code (Key) or delta (Wheel)
+        int x = 0, y = 0;  //!< size (Resize) or position (Click)
+        bool ctrl = false, shift = false, alt = false;
+        std::string path;  //!< Drop only
+    };
+
+    inline EventLog() {}
+    inline ~EventLog() { stopRecording(0.0); }
+
+    //! start recording into a file
+    //! \returns false if the file can't be created
+    bool startRecording(const char* filename);
+    //! add an event to the recording (does nothing if not recording)
+    void record(const Event& ev);
+    inline void recordKey(double time, int key, bool ctrl, bool shift, bool alt) {
+        if (!m_recordFile) { return; }
+        Event ev;  ev.time = time;  ev.type = Type::Key;  ev.key = key;
+        ev.ctrl = ctrl;  ev.shift = shift;  ev.alt = alt;
+        record(ev);
+    }
+    inline void recordDrop(double time, const char* path) {
+        if (!m_recordFile || !path) { return; }
+        Event ev;  ev.time = time;  ev.type = Type::Drop;  ev.path.assign(path);
+        record(ev);
+    }
+    inline void recordResize(double time, int width, int height) {
+        if (!m_recordFile) { return; }
+        Event ev;  ev.time = time;  ev.type = Type::Resize;  ev.x = width;  ev.y = height;
+        record(ev);
+    }
+    inline void recordWheel(double time, int delta) {
+        if (!m_recordFile) { return; }
+        Event ev;  ev.time = time;  ev.type = Type::Wheel;  ev.key = delta;
+        record(ev);
+    }
+    inline void recordClick(double time, int x, int y) {
+        if (!m_recordFile) { return; }
+        Event ev;  ev.time = time;  ev.type = Type::Click;  ev.x = x;  ev.y = y;
+        record(ev);
+    }
+    //! write the end marker and close the recording
+    void stopRecording(double time);
+    inline bool recording() const { return !!m_recordFile; }
+
+    //! load a recording for replay
+    //! \returns false if the file can't be read or is malformed
+    bool loadReplay(const char* filename);
+    //! fetch the next replay event that is due at or before a specific time
+    //! \returns false if there are no (more) events due yet
+    bool nextDue(double time, Event& ev);
+    inline bool replaying() const { return !m_replay.empty(); }
+    //! check whether all events (including the end marker) have been replayed
+    inline bool replayFinished() const { return replaying() && (m_replayPos >= m_replay.size()); }
+
+private:
+    FILE* m_recordFile = nullptr;
+    std::vector<Event> m_replay;
+    size_t m_replayPos = 0;
+};
@@ -0,0 +1,1143 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cmath>
+#include <cfloat>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "util.h"
+#include "pathutil.h"
+#include "trace.h"
+#include "fontgen.h"
+
+// default character set; keep in sync with font/charset.txt
+static const uint32_t defaultCharset[][2] = {
+    {     32,    126 },
+    {    160,    255 },
+    { 0xFFFD, 0xFFFD },
+};
+
+// fallback glyph candidates, in order of preference (same as in font/convert_font.py)
+static const uint32_t fallbackCodepoints[] = { 0xFFFD, 0x25FB, 0x25FC, 0x25FD, 0x25FE, 0x25A1, 0x25A0, '?', 32 };
+
+constexpr uint32_t cacheMagic        = makeFourCC("TMfc");
+constexpr uint32_t cacheVersion      = 1;         // increment whenever the generated data changes
+constexpr size_t   maxFontFileSize   = 64u << 20;
+constexpr int      maxCompositeDepth = 8;         // maximum nesting level of composite glyphs
+constexpr int      maxGlyphSize      = 512;       // maximum glyph bitmap size, in pixels
+constexpr double   cornerAngle       = 3.0;       // edges meeting at a greater angle (in radians) form a corner
+constexpr double   clashThreshold    = 1.001;     // distance difference (in pixels) between neighbors that's considered a clash
+constexpr double   pi                = 3.14159265358979323846;
+
+///////////////////////////////////////////////////////////////////////////////
+
+///// font file access helpers
+
+// big-endian reads that return zero outside of the file
+static inline uint32_t getU8(const std::vector<uint8_t>& d, size_t pos)
+    { return (pos < d.size()) ? d[pos] : 0u; }
+static inline uint32_t getU16(const std::vector<uint8_t>& d, size_t pos)
+    { return (getU8(d, pos) << 8) | getU8(d, pos + 1u); }
+static inline int32_t getS16(const std::vector<uint8_t>& d, size_t pos)
+    { return int16_t(uint16_t(getU16(d, pos))); }
+static inline uint32_t getU32(const std::vector<uint8_t>& d, size_t pos)
+    { return (getU16(d, pos) << 16) | getU16(d, pos + 2u); }
+static inline double getF2Dot14(const std::vector<uint8_t>& d, size_t pos)
+    { return double(getS16(d, pos)) * (1.0 / 16384.0); }
+
+constexpr uint32_t tableTag(const char* s) {
+    return (uint32_t(uint8_t(s[0])) << 24) | (uint32_t(uint8_t(s[1])) << 16)
+         | (uint32_t(uint8_t(s[2])) <<  8) |  uint32_t(uint8_t(s[3]));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///// geometry
+
+struct Vec2 {
+    double x, y;
+    inline Vec2() : x(0.0), y(0.0) {}
+    inline Vec2(double x_, double y_) : x(x_), y(y_) {}
+    inline Vec2 operator+ (const Vec2& o) const { return Vec2(x + o.x, y + o.y); }
+    inline Vec2 operator- (const Vec2& o) const { return Vec2(x - o.x, y - o.y); }
+    inline Vec2 operator* (double f)      const { return Vec2(x * f, y * f); }
+    inline bool operator==(const Vec2& o) const { return (x == o.x) && (y == o.y); }
+    inline double length() const { return std::sqrt(x * x + y * y); }
+    inline Vec2 normalized() const
+        { double l = length();  return (l > 0.0) ? Vec2(x / l, y / l) : Vec2(0.0, 1.0); }
+};
+static inline double dot  (const Vec2& a, const Vec2& b) { return a.x * b.x + a.y * b.y; }
+static inline double cross(const Vec2& a, const Vec2& b) { return a.x * b.y - a.y * b.x; }
+static inline Vec2   mix  (const Vec2& a, const Vec2& b, double t) { return a + (b - a) * t; }
+static inline double nonZeroSign(double x) { return (x > 0.0) ? 1.0 : -1.0; }
+static inline double median(double a, double b, double c)
+    { return std::max(std::min(a, b), std::min(std::max(a, b), c)); }
+
+// solve a*x^2 + b*x + c = 0
+static int solveQuadratic(double x[2], double a, double b, double c) {
+    if ((a == 0.0) || (std::fabs(b) > 1e12 * std::fabs(a))) {
+        if (b == 0.0) { return 0; }
+        x[0] = -c / b;
+        return 1;
+    }
+    double dscr = b * b - 4.0 * a * c;
+    if (dscr > 0.0) {
+        dscr = std::sqrt(dscr);
+        x[0] = (-b + dscr) / (2.0 * a);
+        x[1] = (-b - dscr) / (2.0 * a);
+        return 2;
+    } else if (dscr == 0.0) {
+        x[0] = -b / (2.0 * a);
+        return 1;
+    }
+    return 0;
+}
+
+// solve a*x^3 + b*x^2 + c*x + d = 0
+static int solveCubic(double x[3], double a, double b, double c, double d) {
+    if ((a == 0.0) || (std::fabs(b / a) >= 1e6)) { return solveQuadratic(x, b, c, d); }
+    b /= a;  c /= a;  d /= a;
+    double b2 = b * b;
+    double q = (b2 - 3.0 * c) / 9.0;
+    double r = (b * (2.0 * b2 - 9.0 * c) + 27.0 * d) / 54.0;
+    double r2 = r * r;
+    double q3 = q * q * q;
+    b /= 3.0;
+    if (r2 < q3) {
+        double t = std::acos(std::clamp(r / std::sqrt(q3), -1.0, 1.0));
+        q = -2.0 * std::sqrt(q);
+        x[0] = q * std::cos(t / 3.0) - b;
+        x[1] = q * std::cos((t + 2.0 * pi) / 3.0) - b;
+        x[2] = q * std::cos((t - 2.0 * pi) / 3.0) - b;
+        return 3;
+    }
+    double u = ((r < 0.0) ? 1.0 : -1.0) * std::pow(std::fabs(r) + std::sqrt(r2 - q3), 1.0 / 3.0);
+    double v = (u == 0.0) ? 0.0 : (q / u);
+    x[0] = (u + v) - b;
+    if ((u == v) || (std::fabs(u - v) < 1e-12 * std::fabs(u + v))) {
+        x[1] = -0.5 * (u + v) - b;
+        return 2;
+    }
+    return 1;
+}
+
+// signed distance with a secondary criterion for equally distant edges
+// (the one that's more orthogonal to the direction towards the point wins)
+struct SignedDistance {
+    double distance = -DBL_MAX;
+    double dot = 1.0;
+    inline SignedDistance() {}
+    inline SignedDistance(double distance_, double dot_) : distance(distance_), dot(dot_) {}
+    inline bool operator< (const SignedDistance& o) const {
+        return (std::fabs(distance) < std::fabs(o.distance))
+           || ((std::fabs(distance) == std::fabs(o.distance)) && (dot < o.dot));
+    }
+};
+
+// edge color bits (an edge contributes to all channels whose bit is set)
+namespace EdgeColor {
+    constexpr uint8_t Black   = 0;
+    constexpr uint8_t Red     = 1;
+    constexpr uint8_t Green   = 2;
+    constexpr uint8_t Yellow  = 3;
+    constexpr uint8_t Blue    = 4;
+    constexpr uint8_t Magenta = 5;
+    constexpr uint8_t Cyan    = 6;
+    constexpr uint8_t White   = 7;
+}
+
+// linear or quadratic Bezier segment of a glyph outline
+struct EdgeSegment {
+    Vec2 p[3];  // start point, control point (midpoint for lines), end point
+    bool quadratic;
+    uint8_t color = EdgeColor::White;
+
+    inline EdgeSegment(const Vec2& a, const Vec2& b)
+        : p{a, mix(a, b, 0.5), b}, quadratic(false) {}
+    inline EdgeSegment(const Vec2& a, const Vec2& c, const Vec2& b)
+        : p{a, c, b}, quadratic(true) {}
+
+    inline Vec2 point(double t) const
+        { return quadratic ? mix(mix(p[0], p[1], t), mix(p[1], p[2], t), t) : mix(p[0], p[2], t); }
+
+    inline Vec2 direction(double t) const {
+        if (!quadratic) { return p[2] - p[0]; }
+        Vec2 tangent = mix(p[1] - p[0], p[2] - p[1], t);
+        return ((tangent.x == 0.0) && (tangent.y == 0.0)) ? (p[2] - p[0]) : tangent;
+    }
+
+    inline void reverse() { std::swap(p[0], p[2]); }
+
+    void bounds(double& l, double& b, double& r, double& t) const {
+        auto include = [&] (const Vec2& v) {
+            l = std::min(l, v.x);  b = std::min(b, v.y);
+            r = std::max(r, v.x);  t = std::max(t, v.y);
+        };
+        include(p[0]);
+        include(p[2]);
+        if (quadratic) {
+            // add the extrema in both directions
+            Vec2 d0 = p[1] - p[0], d1 = p[2] - p[1] - d0;
+            if (d1.x != 0.0) { double s = -d0.x / d1.x;  if ((s > 0.0) && (s < 1.0)) { include(point(s)); } }
+            if (d1.y != 0.0) { double s = -d0.y / d1.y;  if ((s > 0.0) && (s < 1.0)) { include(point(s)); } }
+        }
+    }
+
+    void splitInThirds(std::vector<EdgeSegment>& out) const {
+        if (!quadratic) {
+            out.emplace_back(p[0], point(1.0 / 3.0));
+            out.emplace_back(point(1.0 / 3.0), point(2.0 / 3.0));
+            out.emplace_back(point(2.0 / 3.0), p[2]);
+        } else {
+            out.emplace_back(p[0], mix(p[0], p[1], 1.0 / 3.0), point(1.0 / 3.0));
+            out.emplace_back(point(1.0 / 3.0), mix(mix(p[0], p[1], 5.0 / 9.0), mix(p[1], p[2], 4.0 / 9.0), 0.5), point(2.0 / 3.0));
+            out.emplace_back(point(2.0 / 3.0), mix(p[1], p[2], 2.0 / 3.0), p[2]);
+        }
+    }
+
+    // signed distance from a point to the segment; also returns the curve
+    // parameter of the nearest point, which is outside of [0,1] if it's
+    // an endpoint and the point is "behind" it
+    SignedDistance signedDistance(const Vec2& origin, double& param) const {
+        if (!quadratic) {
+            Vec2 aq = origin - p[0];
+            Vec2 ab = p[2] - p[0];
+            param = dot(aq, ab) / dot(ab, ab);
+            Vec2 eq = ((param > 0.5) ? p[2] : p[0]) - origin;
+            double endpointDistance = eq.length();
+            if ((param > 0.0) && (param < 1.0)) {
+                double orthoDistance = cross(aq, ab) / ab.length();
+                if (std::fabs(orthoDistance) < endpointDistance) { return SignedDistance(orthoDistance, 0.0); }
+            }
+            return SignedDistance(nonZeroSign(cross(aq, ab)) * endpointDistance,
+                                  std::fabs(dot(ab.normalized(), eq.normalized())));
+        }
+        Vec2 qa = p[0] - origin;
+        Vec2 ab = p[1] - p[0];
+        Vec2 br = p[2] - p[1] - ab;
+        double t[3];
+        int solutions = solveCubic(t, dot(br, br), 3.0 * dot(ab, br), 2.0 * dot(ab, ab) + dot(qa, br), dot(qa, ab));
+
+        Vec2 epDir = direction(0.0);
+        double minDistance = nonZeroSign(cross(epDir, qa)) * qa.length();
+        param = -dot(qa, epDir) / dot(epDir, epDir);
+        epDir = direction(1.0);
+        double distance = (p[2] - origin).length();
+        if (distance < std::fabs(minDistance)) {
+            minDistance = nonZeroSign(cross(epDir, p[2] - origin)) * distance;
+            param = dot(origin - p[1], epDir) / dot(epDir, epDir);
+        }
+        for (int i = 0;  i < solutions;  ++i) {
+            if ((t[i] > 0.0) && (t[i] < 1.0)) {
+                Vec2 qe = qa + ab * (2.0 * t[i]) + br * (t[i] * t[i]);
+                distance = qe.length();
+                if (distance <= std::fabs(minDistance)) {
+                    minDistance = nonZeroSign(cross(ab + br * t[i], qe)) * distance;
+                    param = t[i];
+                }
+            }
+        }
+        if ((param >= 0.0) && (param <= 1.0)) { return SignedDistance(minDistance, 0.0); }
+        if (param < 0.5) { return SignedDistance(minDistance, std::fabs(dot(direction(0.0).normalized(), qa.normalized()))); }
+        return SignedDistance(minDistance, std::fabs(dot(direction(1.0).normalized(), (p[2] - origin).normalized())));
+    }
+
+    // convert a signed distance to an endpoint into the distance to the
+    // segment's tangent line at that endpoint ("pseudo-distance")
+    void toPseudoDistance(SignedDistance& d, const Vec2& origin, double param) const {
+        if (param < 0.0) {
+            Vec2 dir = direction(0.0).normalized();
+            Vec2 aq = origin - p[0];
+            if (dot(aq, dir) < 0.0) {
+                double pseudoDistance = cross(aq, dir);
+                if (std::fabs(pseudoDistance) <= std::fabs(d.distance)) { d = SignedDistance(pseudoDistance, 0.0); }
+            }
+        } else if (param > 1.0) {
+            Vec2 dir = direction(1.0).normalized();
+            Vec2 bq = origin - p[2];
+            if (dot(bq, dir) > 0.0) {
+                double pseudoDistance = cross(bq, dir);
+                if (std::fabs(pseudoDistance) <= std::fabs(d.distance)) { d = SignedDistance(pseudoDistance, 0.0); }
+            }
+        }
+    }
+};
+
+typedef std::vector<EdgeSegment> Contour;
+
+struct RuntimeFont::Shape {
+    std::vector<Contour> contours;
+};
+
+static void reverseContour(Contour& contour) {
+    std::reverse(contour.begin(), contour.end());
+    for (auto& edge : contour) { edge.reverse(); }
+}
+
+// shoelace formula; positive for clockwise contours
+static double contourArea(const Contour& contour) {
+    if (contour.empty()) { return 0.0; }
+    auto shoelace = [] (const Vec2& a, const Vec2& b) { return (b.x - a.x) * (a.y + b.y); };
+    double total = 0.0;
+    if (contour.size() == 1u) {
+        Vec2 a = contour[0].point(0.0), b = contour[0].point(1.0 / 3.0), c = contour[0].point(2.0 / 3.0);
+        total = shoelace(a, b) + shoelace(b, c) + shoelace(c, a);
+    } else if (contour.size() == 2u) {
+        Vec2 a = contour[0].point(0.0), b = contour[0].point(0.5), c = contour[1].point(0.0), d = contour[1].point(0.5);
+        total = shoelace(a, b) + shoelace(b, c) + shoelace(c, d) + shoelace(d, a);
+    } else {
+        Vec2 prev = contour.back().point(0.0);
+        for (const auto& edge : contour) {
+            Vec2 cur = edge.point(0.0);
+            total += shoelace(prev, cur);
+            prev = cur;
+        }
+    }
+    return total;
+}
+
+// convert a TrueType contour (on-curve and off-curve points, with implied
+// on-curve points between two consecutive off-curve points) into edges
+static void addContour(std::vector<Contour>& contours, const Vec2* points, const uint8_t* flags, int count) {
+    if (count < 2) { return; }
+    struct Point { Vec2 p; bool on; };
+    std::vector<Point> pts;
+    pts.reserve(size_t(count) + 1u);
+    int first = 0;
+    while ((first < count) && !(flags[first] & 1)) { ++first; }
+    if (first >= count) {
+        // no on-curve point at all -> start at an implied one
+        pts.push_back({ mix(points[count - 1], points[0], 0.5), true });
+        first = 0;
+    }
+    for (int i = 0;  i < count;  ++i) {
+        int j = (first + i) % count;
+        pts.push_back({ points[j], !!(flags[j] & 1) });
+    }
+
+    Contour contour;
+    Vec2 cur = pts[0].p, ctrl;
+    bool haveCtrl = false;
+    for (size_t i = 1;  i <= pts.size();  ++i) {
+        const Point& pt = pts[i % pts.size()];
+        if (pt.on) {
+            if (haveCtrl) { contour.emplace_back(cur, ctrl, pt.p); }
+            else if (!(pt.p == cur)) { contour.emplace_back(cur, pt.p); }
+            cur = pt.p;
+            haveCtrl = false;
+        } else {
+            if (haveCtrl) {
+                Vec2 mid = mix(ctrl, pt.p, 0.5);
+                contour.emplace_back(cur, ctrl, mid);
+                cur = mid;
+            }
+            ctrl = pt.p;
+            haveCtrl = true;
+        }
+    }
+    if (!contour.empty()) { contours.push_back(std::move(contour)); }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///// MSDF generation
+
+// assign colors to the edges, such that two edges meeting at a corner
+// never share more than one channel (simple edge coloring strategy
+// from Viktor Chlumsky's msdfgen, with a fixed seed)
+static void switchColor(uint8_t& color, uint64_t& seed, uint8_t banned=EdgeColor::Black) {
+    uint8_t combined = color & banned;
+    if ((combined == EdgeColor::Red) || (combined == EdgeColor::Green) || (combined == EdgeColor::Blue)) {
+        color = combined ^ EdgeColor::White;
+        return;
+    }
+    if ((color == EdgeColor::Black) || (color == EdgeColor::White)) {
+        static const uint8_t start[3] = { EdgeColor::Cyan, EdgeColor::Magenta, EdgeColor::Yellow };
+        color = start[seed % 3u];
+        seed /= 3u;
+        return;
+    }
+    int shifted = color << (1 + int(seed & 1u));
+    color = uint8_t((shifted | (shifted >> 3)) & EdgeColor::White);
+    seed >>= 1;
+}
+
+static void colorEdges(std::vector<Contour>& contours) {
+    const double crossThreshold = std::sin(cornerAngle);
+    uint64_t seed = 0;
+    std::vector<int> corners;
+    for (auto& contour : contours) {
+        // find corners
+        corners.clear();
+        Vec2 prevDir = contour.back().direction(1.0).normalized();
+        for (int i = 0;  i < int(contour.size());  ++i) {
+            Vec2 dir = contour[i].direction(0.0).normalized();
+            if ((dot(prevDir, dir) <= 0.0) || (std::fabs(cross(prevDir, dir)) > crossThreshold)) {
+                corners.push_back(i);
+            }
+            prevDir = contour[i].direction(1.0).normalized();
+        }
+
+        if (corners.empty()) {
+            // smooth contour
+            for (auto& edge : contour) { edge.color = EdgeColor::White; }
+        } else if (corners.size() == 1u) {
+            // "teardrop" shape: use three colors along the contour
+            uint8_t colors[3] = { EdgeColor::White, EdgeColor::White, EdgeColor::White };
+            switchColor(colors[0], seed);
+            colors[2] = colors[0];
+            switchColor(colors[2], seed);
+            int corner = corners[0];
+            int m = int(contour.size());
+            if (m >= 3) {
+                for (int i = 0;  i < m;  ++i) {
+                    int third = int(3.0 + 2.875 * double(i) / double(m - 1) - 1.4375 + 0.5) - 3;
+                    contour[(corner + i) % m].color = colors[1 + third];
+                }
+            } else {
+                // fewer than three edges for three colors -> split them
+                Contour parts;
+                for (int i = 0;  i < m;  ++i) { contour[(corner + i) % m].splitInThirds(parts); }
+                if (m >= 2) {
+                    for (int i = 0;  i < 6;  ++i) { parts[i].color = colors[i >> 1]; }
+                } else {
+                    for (int i = 0;  i < 3;  ++i) { parts[i].color = colors[i]; }
+                }
+                contour = std::move(parts);
+            }
+        } else {
+            // multiple corners: switch colors at each of them
+            int numCorners = int(corners.size());
+            int spline = 0;
+            int start = corners[0];
+            int m = int(contour.size());
+            uint8_t color = EdgeColor::White;
+            switchColor(color, seed);
+            uint8_t initialColor = color;
+            for (int i = 0;  i < m;  ++i) {
+                int index = (start + i) % m;
+                if (((spline + 1) < numCorners) && (corners[spline + 1] == index)) {
+                    ++spline;
+                    switchColor(color, seed, (spline == (numCorners - 1)) ? initialColor : EdgeColor::Black);
+                }
+                contour[index].color = color;
+            }
+        }
+    }
+}
+
+// nearest edge of each color channel
+struct EdgeSelector {
+    SignedDistance minDistance[3];
+    const EdgeSegment* edge[3];
+    double param[3];
+
+    inline void reset() {
+        for (int ch = 0;  ch < 3;  ++ch) {
+            minDistance[ch] = SignedDistance();
+            edge[ch] = nullptr;
+            param[ch] = 0.0;
+        }
+    }
+    inline void add(const EdgeSegment& e, const Vec2& p) {
+        double t;
+        SignedDistance d = e.signedDistance(p, t);
+        for (int ch = 0;  ch < 3;  ++ch) {
+            if ((e.color & (1 << ch)) && (d < minDistance[ch])) {
+                minDistance[ch] = d;
+                edge[ch] = &e;
+                param[ch] = t;
+            }
+        }
+    }
+    inline void merge(const EdgeSelector& o) {
+        for (int ch = 0;  ch < 3;  ++ch) {
+            if (o.minDistance[ch] < minDistance[ch]) {
+                minDistance[ch] = o.minDistance[ch];
+                edge[ch] = o.edge[ch];
+                param[ch] = o.param[ch];
+            }
+        }
+    }
+    inline void distance(const Vec2& p, double* d) const {
+        for (int ch = 0;  ch < 3;  ++ch) {
+            SignedDistance sd = minDistance[ch];
+            if (edge[ch]) { edge[ch]->toPseudoDistance(sd, p, param[ch]); }
+            d[ch] = sd.distance;
+        }
+    }
+};
+
+// compute the multi-channel distance of a point, resolving overlapping
+// contours properly (msdfgen's "overlapping contour combiner")
+static void multiDistance(const std::vector<Contour>& contours, const std::vector<int>& windings,
+                          std::vector<EdgeSelector>& sel, std::vector<double>& dist,
+                          const Vec2& p, double* out)
+{
+    int n = int(contours.size());
+    EdgeSelector shapeSel, innerSel, outerSel;
+    shapeSel.reset();  innerSel.reset();  outerSel.reset();
+    for (int i = 0;  i < n;  ++i) {
+        sel[i].reset();
+        for (const auto& edge : contours[i]) { sel[i].add(edge, p); }
+        double* d = &dist[size_t(i) * 3u];
+        sel[i].distance(p, d);
+        double md = median(d[0], d[1], d[2]);
+        shapeSel.merge(sel[i]);
+        if ((windings[i] > 0) && (md >= 0.0)) { innerSel.merge(sel[i]); }
+        if ((windings[i] < 0) && (md <= 0.0)) { outerSel.merge(sel[i]); }
+    }
+
+    double shapeDist[3], innerDist[3], outerDist[3];
+    shapeSel.distance(p, shapeDist);
+    innerSel.distance(p, innerDist);
+    outerSel.distance(p, outerDist);
+    double innerScalar = median(innerDist[0], innerDist[1], innerDist[2]);
+    double outerScalar = median(outerDist[0], outerDist[1], outerDist[2]);
+
+    double result[3];
+    int winding;
+    if ((innerScalar >= 0.0) && (std::fabs(innerScalar) <= std::fabs(outerScalar))) {
+        std::copy(innerDist, innerDist + 3, result);
+        winding = 1;
+        for (int i = 0;  i < n;  ++i) {
+            if (windings[i] <= 0) { continue; }
+            const double* d = &dist[size_t(i) * 3u];
+            double md = median(d[0], d[1], d[2]);
+            if ((std::fabs(md) < std::fabs(outerScalar)) && (md > median(result[0], result[1], result[2]))) {
+                std::copy(d, d + 3, result);
+            }
+        }
+    } else if ((outerScalar <= 0.0) && (std::fabs(outerScalar) < std::fabs(innerScalar))) {
+        std::copy(outerDist, outerDist + 3, result);
+        winding = -1;
+        for (int i = 0;  i < n;  ++i) {
+            if (windings[i] >= 0) { continue; }
+            const double* d = &dist[size_t(i) * 3u];
+            double md = median(d[0], d[1], d[2]);
+            if ((std::fabs(md) < std::fabs(innerScalar)) && (md < median(result[0], result[1], result[2]))) {
+                std::copy(d, d + 3, result);
+            }
+        }
+    } else {
+        std::copy(shapeDist, shapeDist + 3, out);
+        return;
+    }
+    for (int i = 0;  i < n;  ++i) {
+        if (windings[i] == winding) { continue; }
+        const double* d = &dist[size_t(i) * 3u];
+        double md = median(d[0], d[1], d[2]);
+        double mr = median(result[0], result[1], result[2]);
+        if (((md * mr) >= 0.0) && (std::fabs(md) < std::fabs(mr))) { std::copy(d, d + 3, result); }
+    }
+    if (median(result[0], result[1], result[2]) == median(shapeDist[0], shapeDist[1], shapeDist[2])) {
+        std::copy(shapeDist, shapeDist + 3, result);
+    }
+    std::copy(result, result + 3, out);
+}
+
+// check whether two neighboring pixels would interpolate into an artifact
+static bool detectClash(const float* a, const float* b, float threshold) {
+    // sort channels so that pairs go from biggest to smallest absolute difference
+    float a0 = a[0], a1 = a[1], a2 = a[2];
+    float b0 = b[0], b1 = b[1], b2 = b[2];
+    if (std::fabs(b0 - a0) < std::fabs(b1 - a1)) { std::swap(a0, a1);  std::swap(b0, b1); }
+    if (std::fabs(b1 - a1) < std::fabs(b2 - a2)) {
+        std::swap(a1, a2);  std::swap(b1, b2);
+        if (std::fabs(b0 - a0) < std::fabs(b1 - a1)) { std::swap(a0, a1);  std::swap(b0, b1); }
+    }
+    return (std::fabs(b1 - a1) >= threshold)
+        && !((b0 == b1) && (b0 == b2))  // ignore if the other pixel has already been equalized
+        && (std::fabs(a2 - 0.5f) >= std::fabs(b2 - 0.5f));  // only flag the pixel farther from the edge
+}
+
+// replace pixels that clash with their neighbors by their median
+static void correctErrors(std::vector<float>& field, int w, int h, float threshold) {
+    std::vector<size_t> clashes;
+    auto px = [&] (int x, int y) -> float* { return &field[(size_t(y) * size_t(w) + size_t(x)) * 3u]; };
+    auto equalize = [&] () {
+        for (size_t i : clashes) {
+            float* p = &field[i * 3u];
+            p[0] = p[1] = p[2] = float(median(p[0], p[1], p[2]));
+        }
+        clashes.clear();
+    };
+    for (int y = 0;  y < h;  ++y) {
+        for (int x = 0;  x < w;  ++x) {
+            const float* p = px(x, y);
+            if (((x > 0)       && detectClash(p, px(x - 1, y), threshold))
+            ||  ((x < (w - 1)) && detectClash(p, px(x + 1, y), threshold))
+            ||  ((y > 0)       && detectClash(p, px(x, y - 1), threshold))
+            ||  ((y < (h - 1)) && detectClash(p, px(x, y + 1), threshold))) {
+                clashes.push_back(size_t(y) * size_t(w) + size_t(x));
+            }
+        }
+    }
+    equalize();
+    for (int y = 0;  y < h;  ++y) {
+        for (int x = 0;  x < w;  ++x) {
+            const float* p = px(x, y);
+            if (((x > 0)       && (y > 0)       && detectClash(p, px(x - 1, y - 1), 2.0f * threshold))
+            ||  ((x < (w - 1)) && (y > 0)       && detectClash(p, px(x + 1, y - 1), 2.0f * threshold))
+            ||  ((x > 0)       && (y < (h - 1)) && detectClash(p, px(x - 1, y + 1), 2.0f * threshold))
+            ||  ((x < (w - 1)) && (y < (h - 1)) && detectClash(p, px(x + 1, y + 1), 2.0f * threshold))) {
+                clashes.push_back(size_t(y) * size_t(w) + size_t(x));
+            }
+        }
+    }
+    equalize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///// TrueType parsing
+
+bool RuntimeFont::isFontFile(const char* name) {
+    static const uint32_t exts[] = { makeFourCC("ttf"), makeFourCC("otf"), makeFourCC("ttc"), 0 };
+    return name && PathUtil::matchExtList(name, exts);
+}
+
+const char* RuntimeFont::parse() {
+    const auto& d = m_file;
+    size_t base = 0u;
+    uint32_t version = getU32(d, 0u);
+    if (version == tableTag("ttcf")) {
+        // font collection -> use the first font
+        if (!getU32(d, 8u)) { return "empty font collection"; }
+        base = getU32(d, 12u);
+        version = getU32(d, base);
+    }
+    if (version == tableTag("OTTO")) { return "OpenType fonts with PostScript outlines are not supported"; }
+    if ((version != 0x00010000u) && (version != tableTag("true"))) { return "not a TrueType font file"; }
+
+    size_t head = 0u, hhea = 0u, maxp = 0u;
+    int numTables = int(getU16(d, base + 4u));
+    for (int i = 0;  i < numTables;  ++i) {
+        size_t rec = base + 12u + 16u * size_t(i);
+        uint32_t tag = getU32(d, rec);
+        size_t offset = getU32(d, rec + 8u);
+        if (offset >= d.size()) { continue; }
+        if      (tag == tableTag("head")) { head   = offset; }
+        else if (tag == tableTag("hhea")) { hhea   = offset; }
+        else if (tag == tableTag("maxp")) { maxp   = offset; }
+        else if (tag == tableTag("hmtx")) { m_hmtx = offset; }
+        else if (tag == tableTag("loca")) { m_loca = offset; }
+        else if (tag == tableTag("glyf")) { m_glyf = offset; }
+        else if (tag == tableTag("cmap")) { m_cmap = offset; }
+    }
+    if (!head || !hhea || !maxp || !m_hmtx || !m_loca || !m_glyf || !m_cmap) { return "required font tables missing"; }
+
+    m_unitsPerEm = int(getU16(d, head + 18u));
+    m_longLoca = (getS16(d, head + 50u) != 0);
+    m_numGlyphs = int(getU16(d, maxp + 4u));
+    m_numHMetrics = int(getU16(d, hhea + 34u));
+    if ((m_unitsPerEm < 16) || (m_unitsPerEm > 16384) || !m_numGlyphs || !m_numHMetrics) { return "invalid font header"; }
+    double invUPM = 1.0 / double(m_unitsPerEm);
+    int ascender = getS16(d, hhea + 4u), descender = getS16(d, hhea + 6u), lineGap = getS16(d, hhea + 8u);
+    m_ascender   = float(double(ascender) * invUPM);
+    m_lineHeight = float(double(ascender - descender + lineGap) * invUPM);
+    if (m_lineHeight <= 0.0f) { return "invalid font metrics"; }
+
+    // find the best character map: full Unicode, then BMP-only
+    size_t cmap = m_cmap;
+    int bestScore = 0;
+    int numSubtables = int(getU16(d, cmap + 2u));
+    for (int i = 0;  i < numSubtables;  ++i) {
+        size_t rec = cmap + 4u + 8u * size_t(i);
+        uint32_t platform = getU16(d, rec), encoding = getU16(d, rec + 2u);
+        size_t sub = cmap + getU32(d, rec + 4u);
+        int format = int(getU16(d, sub));
+        bool unicode = (platform == 0u) || ((platform == 3u) && ((encoding == 1u) || (encoding == 10u)));
+        int score = !unicode ? 0 : (format == 12) ? 2 : (format == 4) ? 1 : 0;
+        if (score > bestScore) {
+            bestScore = score;
+            m_cmap = sub;
+            m_cmapFormat = format;
+        }
+    }
+    if (!bestScore) { return "no Unicode character map found"; }
+
+    // measure the height of numbers for the track number display
+    m_numberHeight = 0.75f * m_ascender;
+    int four = glyphIndex('4');
+    Shape shape;
+    if ((four >= 0) && outline(four, shape)) {
+        double l = DBL_MAX, b = DBL_MAX, r = -DBL_MAX, t = -DBL_MAX;
+        for (const auto& contour : shape.contours) {
+            for (const auto& edge : contour) { edge.bounds(l, b, r, t); }
+        }
+        if (t > b) { m_numberHeight = float((t - b) * invUPM); }
+    }
+    return nullptr;
+}
+
+bool RuntimeFont::glyphData(int glyph, size_t& start, size_t& end) const {
+    if ((glyph < 0) || (glyph >= m_numGlyphs)) { return false; }
+    if (m_longLoca) {
+        start = getU32(m_file, m_loca + 4u * size_t(glyph));
+        end   = getU32(m_file, m_loca + 4u * size_t(glyph) + 4u);
+    } else {
+        start = 2u * getU16(m_file, m_loca + 2u * size_t(glyph));
+        end   = 2u * getU16(m_file, m_loca + 2u * size_t(glyph) + 2u);
+    }
+    start += m_glyf;
+    end   += m_glyf;
+    return (end > start) && (end <= m_file.size());
+}
+
+int RuntimeFont::glyphIndex(uint32_t codepoint) const {
+    const auto& d = m_file;
+    uint32_t glyph = 0u;
+    if ((m_cmapFormat == 4) && (codepoint < 0x10000u)) {
+        size_t segCount = getU16(d, m_cmap + 6u) >> 1;
+        size_t ends = m_cmap + 14u;
+        size_t starts = ends + 2u * segCount + 2u;
+        size_t deltas = starts + 2u * segCount;
+        size_t ranges = deltas + 2u * segCount;
+        // binary search for the first segment that ends at or after the codepoint
+        size_t a = 0u, b = segCount;
+        while (a < b) {
+            size_t c = (a + b) >> 1;
+            if (getU16(d, ends + 2u * c) < codepoint) { a = c + 1u; } else { b = c; }
+        }
+        uint32_t start = getU16(d, starts + 2u * a);
+        if ((a < segCount) && (codepoint >= start)) {
+            uint32_t delta = getU16(d, deltas + 2u * a);
+            uint32_t rangeOffset = getU16(d, ranges + 2u * a);
+            if (!rangeOffset) {
+                glyph = (codepoint + delta) & 0xFFFFu;
+            } else {
+                glyph = getU16(d, ranges + 2u * a + rangeOffset + 2u * (codepoint - start));
+                if (glyph) { glyph = (glyph + delta) & 0xFFFFu; }
+            }
+        }
+    } else if (m_cmapFormat == 12) {
+        size_t numGroups = getU32(d, m_cmap + 12u);
+        size_t groups = m_cmap + 16u;
+        size_t a = 0u, b = numGroups;
+        while (a < b) {
+            size_t c = (a + b) >> 1;
+            if (getU32(d, groups + 12u * c + 4u) < codepoint) { a = c + 1u; } else { b = c; }
+        }
+        uint32_t start = getU32(d, groups + 12u * a);
+        if ((a < numGroups) && (codepoint >= start)) {
+            glyph = getU32(d, groups + 12u * a + 8u) + (codepoint - start);
+        }
+    }
+    if (glyph && (glyph < uint32_t(m_numGlyphs))) { return int(glyph); }
+
+    // use the .notdef glyph for the replacement character if there's none
+    size_t start, end;
+    if ((codepoint == 0xFFFD) && glyphData(0, start, end)) { return 0; }
+    return -1;
+}
+
+float RuntimeFont::advance(int glyph) const {
+    int index = std::min(glyph, m_numHMetrics - 1);
+    return float(double(getU16(m_file, m_hmtx + 4u * size_t(index))) / double(m_unitsPerEm));
+}
+
+bool RuntimeFont::outline(int glyph, Shape& shape, int depth) const {
+    const auto& d = m_file;
+    size_t pos, end;
+    if (!glyphData(glyph, pos, end)) { return true; }  // no outline
+    int numContours = getS16(d, pos);
+
+    if (numContours >= 0) {
+        // simple glyph
+        size_t endPts = pos + 10u;
+        int numPoints = numContours ? (int(getU16(d, endPts + 2u * size_t(numContours - 1))) + 1) : 0;
+        pos = endPts + 2u * size_t(numContours);
+        pos += 2u + getU16(d, pos);  // skip instructions
+        std::vector<uint8_t> flags(size_t(numPoints), 0u);
+        for (int i = 0;  (i < numPoints) && (pos < end);) {
+            uint8_t f = uint8_t(getU8(d, pos++));
+            int repeat = (f & 8) ? int(getU8(d, pos++)) : 0;
+            for (;  (repeat >= 0) && (i < numPoints);  --repeat) { flags[size_t(i++)] = f; }
+        }
+        std::vector<Vec2> points(flags.size());
+        int32_t v = 0;
+        for (int i = 0;  i < numPoints;  ++i) {
+            uint8_t f = flags[size_t(i)];
+            if (f & 2)         { int32_t dv = int32_t(getU8(d, pos++));  v += (f & 16) ? dv : -dv; }
+            else if (!(f & 16)) { v += getS16(d, pos);  pos += 2u; }
+            points[size_t(i)].x = double(v);
+        }
+        v = 0;
+        for (int i = 0;  i < numPoints;  ++i) {
+            uint8_t f = flags[size_t(i)];
+            if (f & 4)         { int32_t dv = int32_t(getU8(d, pos++));  v += (f & 32) ? dv : -dv; }
+            else if (!(f & 32)) { v += getS16(d, pos);  pos += 2u; }
+            points[size_t(i)].y = double(v);
+        }
+        if (pos > end) { return false; }  // truncated glyph data
+        int first = 0;
+        for (int c = 0;  c < numContours;  ++c) {
+            int last = int(getU16(d, endPts + 2u * size_t(c)));
+            if ((last < first) || (last >= numPoints)) { return false; }
+            addContour(shape.contours, &points[size_t(first)], &flags[size_t(first)], last - first + 1);
+            first = last + 1;
+        }
+        return true;
+    }
+
+    // composite glyph
+    if (depth >= maxCompositeDepth) { return false; }
+    pos += 10u;
+    uint32_t flags;
+    do {
+        if (pos >= end) { return false; }
+        flags = getU16(d, pos);
+        int component = int(getU16(d, pos + 2u));
+        pos += 4u;
+        double dx, dy;
+        if (flags & 1u) { dx = getS16(d, pos);  dy = getS16(d, pos + 2u);  pos += 4u; }
+        else { dx = int8_t(getU8(d, pos));  dy = int8_t(getU8(d, pos + 1u));  pos += 2u; }
+        if (!(flags & 2u)) { dx = dy = 0.0; }  // point matching isn't supported
+        double xx = 1.0, xy = 0.0, yx = 0.0, yy = 1.0;
+        if (flags & 0x08u) {
+            xx = yy = getF2Dot14(d, pos);  pos += 2u;
+        } else if (flags & 0x40u) {
+            xx = getF2Dot14(d, pos);  yy = getF2Dot14(d, pos + 2u);  pos += 4u;
+        } else if (flags & 0x80u) {
+            xx = getF2Dot14(d, pos);       xy = getF2Dot14(d, pos + 2u);
+            yx = getF2Dot14(d, pos + 4u);  yy = getF2Dot14(d, pos + 6u);  pos += 8u;
+        }
+        Shape part;
+        if (!outline(component, part, depth + 1)) { return false; }
+        bool mirrored = (xx * yy - xy * yx) < 0.0;
+        for (auto& contour : part.contours) {
+            for (auto& edge : contour) {
+                for (auto& p : edge.p) { p = Vec2(xx * p.x + yx * p.y + dx, xy * p.x + yy * p.y + dy); }
+            }
+            if (mirrored) { reverseContour(contour); }
+            shape.contours.push_back(std::move(contour));
+        }
+    } while (flags & 0x20u);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///// glyph generation
+
+void RuntimeFont::generateGlyph(GlyphBitmap& g) const {
+    int glyph = glyphIndex(g.codepoint);
+    g.advance = (glyph >= 0) ? advance(glyph) : 0.0f;
+    g.width = g.height = 0;
+    Shape shape;
+    if ((glyph < 0) || !outline(glyph, shape)) { return; }
+
+    // determine bounds, fix inverted outlines (TrueType outer contours are clockwise)
+    double l = DBL_MAX, b = DBL_MAX, r = -DBL_MAX, t = -DBL_MAX;
+    double area = 0.0;
+    for (const auto& contour : shape.contours) {
+        for (const auto& edge : contour) { edge.bounds(l, b, r, t); }
+        area += contourArea(contour);
+    }
+    if (!(l < r) || !(b < t)) { return; }
+    if (area < 0.0) {
+        for (auto& contour : shape.contours) { reverseContour(contour); }
+    }
+    std::vector<int> windings;
+    for (const auto& contour : shape.contours) {
+        double a = contourArea(contour);
+        windings.push_back((a > 0.0) ? 1 : (a < 0.0) ? -1 : 0);
+    }
+    colorEdges(shape.contours);
+
+    // compute bitmap geometry (the same way as msdf-atlas-gen does)
+    double scale = double(EmSize) / double(m_unitsPerEm);
+    double range = double(PixelRange) / scale;
+    l -= 0.5 * range;  b -= 0.5 * range;
+    r += 0.5 * range;  t += 0.5 * range;
+    double w = scale * (r - l), h = scale * (t - b);
+    int bw = int(std::ceil(w)) + 1, bh = int(std::ceil(h)) + 1;
+    if ((bw > maxGlyphSize) || (bh > maxGlyphSize)) { return; }
+    double tx = -l + 0.5 * (double(bw) - w) / scale;
+    double ty = -b + 0.5 * (double(bh) - h) / scale;
+    double invUPM = 1.0 / double(m_unitsPerEm);
+    g.x0 = float((-tx + 0.5 / scale) * invUPM);
+    g.y0 = float((-ty + 0.5 / scale) * invUPM);
+    g.x1 = float((-tx + (double(bw) - 0.5) / scale) * invUPM);
+    g.y1 = float((-ty + (double(bh) - 0.5) / scale) * invUPM);
+
+    // generate the distance field
+    std::vector<float> field(size_t(bw) * size_t(bh) * 3u);
+    std::vector<EdgeSelector> sel(shape.contours.size());
+    std::vector<double> dist(shape.contours.size() * 3u);
+    for (int y = 0;  y < bh;  ++y) {
+        float* row = &field[size_t(bh - 1 - y) * size_t(bw) * 3u];  // bitmap is top-down
+        for (int x = 0;  x < bw;  ++x) {
+            double md[3];
+            multiDistance(shape.contours, windings, sel, dist, Vec2((double(x) + 0.5) / scale - tx, (double(y) + 0.5) / scale - ty), md);
+            for (int ch = 0;  ch < 3;  ++ch) { *row++ = float(md[ch] / range + 0.5); }
+        }
+    }
+    correctErrors(field, bw, bh, float(clashThreshold / double(PixelRange)));
+
+    g.width = bw;
+    g.height = bh;
+    g.pixels.resize(field.size());
+    for (size_t i = 0;  i < field.size();  ++i) {
+        g.pixels[i] = uint8_t(std::clamp(field[i] * 256.0f, 0.0f, 255.0f));
+    }
+}
+
+void RuntimeFont::generate(std::vector<uint32_t>& codepoints) {
+    if (codepoints.empty()) { return; }
+    TRACE_SCOPE("generate glyphs");
+    Dprintf("generating %d glyph(s) for font '%s'\n", int(codepoints.size()), m_path.c_str());
+    size_t first = m_glyphs.size();
+    for (uint32_t cp : codepoints) {
+        m_glyphs.emplace_back();
+        m_glyphs.back().codepoint = cp;
+    }
+
+    // glyphs are independent of each other, so they can be generated in parallel
+    std::atomic<size_t> next { first };
+    auto worker = [&] () {
+        size_t i;
+        while ((i = next.fetch_add(1u)) < m_glyphs.size()) { generateGlyph(m_glyphs[i]); }
+    };
+    int numThreads = std::clamp(int(std::thread::hardware_concurrency()), 1, int(codepoints.size()));
+    std::vector<std::thread> threads;
+    for (int i = 1;  i < numThreads;  ++i) { threads.emplace_back(worker); }
+    worker();
+    for (auto& t : threads) { t.join(); }
+
+    std::sort(m_glyphs.begin(), m_glyphs.end(),
+              [] (const GlyphBitmap& a, const GlyphBitmap& b) { return a.codepoint < b.codepoint; });
+    if (!saveCache()) { Dprintf("WARNING: could not write font cache file '%s'\n", m_cacheFile.c_str()); }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///// atlas creation
+
+void RuntimeFont::buildAtlas() {
+    TRACE_SCOPE("build font atlas");
+
+    // shelf packing, tallest glyphs first
+    std::vector<int> order;
+    size_t area = 0u;
+    int maxWidth = 0;
+    for (int i = 0;  i < int(m_glyphs.size());  ++i) {
+        const auto& g = m_glyphs[size_t(i)];
+        if (!g.width) { continue; }
+        order.push_back(i);
+        area += size_t(g.width + 2 * Padding) * size_t(g.height + 2 * Padding);
+        maxWidth = std::max(maxWidth, g.width + 2 * Padding);
+    }
+    std::sort(order.begin(), order.end(), [&] (int a, int b) {
+        const auto& ga = m_glyphs[size_t(a)];  const auto& gb = m_glyphs[size_t(b)];
+        return (ga.height != gb.height) ? (ga.height > gb.height) : (ga.width > gb.width);
+    });
+    int width = 64;
+    while ((width < maxWidth) || ((size_t(width) * size_t(width)) < (area + area / 4u))) { width <<= 1; }
+    std::vector<int> posX(m_glyphs.size(), 0), posY(m_glyphs.size(), 0);
+    int x = 0, y = 0, shelfHeight = 0;
+    for (int i : order) {
+        const auto& g = m_glyphs[size_t(i)];
+        int bw = g.width + 2 * Padding, bh = g.height + 2 * Padding;
+        if ((x + bw) > width) { y += shelfHeight;  x = 0;  shelfHeight = 0; }
+        posX[size_t(i)] = x + Padding;
+        posY[size_t(i)] = y + Padding;
+        x += bw;
+        shelfHeight = std::max(shelfHeight, bh);
+    }
+    int height = std::max((y + shelfHeight + 3) & (~3), 4);
+
+    // draw the atlas
+    m_atlasWidth = width;
+    m_atlasHeight = height;
+    m_atlas.assign(size_t(width) * size_t(height) * 3u, 0u);
+    for (int i : order) {
+        const auto& g = m_glyphs[size_t(i)];
+        for (int row = 0;  row < g.height;  ++row) {
+            std::copy_n(&g.pixels[size_t(row) * size_t(g.width) * 3u], size_t(g.width) * 3u,
+                        &m_atlas[(size_t(posY[size_t(i)] + row) * size_t(width) + size_t(posX[size_t(i)])) * 3u]);
+        }
+    }
+
+    // build the glyph table in the same format as font/convert_font.py does
+    float mscale = 1.0f / m_lineHeight;
+    float baseline = m_ascender * mscale;
+    float sx = 1.0f / float(width), sy = 1.0f / float(height);
+    m_glyphTable.clear();
+    m_glyphTable.reserve(m_glyphs.size());
+    for (size_t i = 0;  i < m_glyphs.size();  ++i) {
+        const auto& g = m_glyphs[i];
+        FontData::Glyph fg = { g.codepoint, g.advance * mscale, !g.width, { 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 0.0f } };
+        if (g.width) {
+            fg.pos = { g.x0 * mscale, baseline - g.y1 * mscale, g.x1 * mscale, baseline - g.y0 * mscale };
+            float ax = float(posX[i]), ay = float(posY[i]);
+            fg.tc = { (ax + 0.5f) * sx, (ay + 0.5f) * sy, (ax + float(g.width) - 0.5f) * sx, (ay + float(g.height) - 0.5f) * sy };
+        }
+        m_glyphTable.push_back(fg);
+    }
+    int fallbackIndex = 0;
+    for (uint32_t cp : fallbackCodepoints) {
+        auto it = std::lower_bound(m_glyphTable.begin(), m_glyphTable.end(), cp,
+                                   [] (const FontData::Glyph& g, uint32_t c) { return g.codepoint < c; });
+        if ((it != m_glyphTable.end()) && (it->codepoint == cp)) { fallbackIndex = int(it - m_glyphTable.begin());  break; }
+    }
+    m_font = { m_name.c_str(), 0, baseline, m_numberHeight * mscale,
+               m_glyphTable.data(), int(m_glyphTable.size()), fallbackIndex };
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///// disk cache
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t hash;
+    uint32_t numGlyphs;
+    uint32_t reserved;
+};
+
+struct CacheGlyph {
+    uint32_t codepoint;
+    float advance, x0, y0, x1, y1;
+    uint16_t width, height;
+};
+
+bool RuntimeFont::loadCache() {
+    if (m_cacheFile.empty()) { return false; }
+    FILE* f = fopen(m_cacheFile.c_str(), "rb");
+    if (!f) { return false; }
+    CacheHeader hdr;
+    bool ok = (fread(&hdr, sizeof(hdr), 1, f) == 1) && (hdr.magic == cacheMagic) && (hdr.version == cacheVersion)
+           && (hdr.hash == m_hash) && (hdr.numGlyphs <= 0x110000u);
+    std::vector<CacheGlyph> recs;
+    if (ok && hdr.numGlyphs) {
+        recs.resize(hdr.numGlyphs);
+        ok = (fread(recs.data(), sizeof(CacheGlyph), recs.size(), f) == recs.size());
+    }
+    for (size_t i = 0;  ok && (i < recs.size());  ++i) {
+        const auto& rec = recs[i];
+        ok = (rec.width <= maxGlyphSize) && (rec.height <= maxGlyphSize) && (!i || (rec.codepoint > recs[i - 1u].codepoint));
+        if (!ok) { break; }
+        m_glyphs.emplace_back();
+        auto& g = m_glyphs.back();
+        g.codepoint = rec.codepoint;
+        g.advance = rec.advance;
+        g.x0 = rec.x0;  g.y0 = rec.y0;  g.x1 = rec.x1;  g.y1 = rec.y1;
+        g.width = rec.width;  g.height = rec.height;
+        if (!g.width || !g.height) { g.width = g.height = 0;  continue; }
+        g.pixels.resize(size_t(g.width) * size_t(g.height) * 3u);
+        ok = (fread(g.pixels.data(), g.pixels.size(), 1, f) == 1);
+    }
+    fclose(f);
+    if (!ok) {
+        Dprintf("WARNING: ignoring invalid font cache file '%s'\n", m_cacheFile.c_str());
+        m_glyphs.clear();
+        return false;
+    }
+    Dprintf("loaded %d glyph(s) from font cache file '%s'\n", int(m_glyphs.size()), m_cacheFile.c_str());
+    return true;
+}
+
+bool RuntimeFont::saveCache() const {
+    if (m_cacheFile.empty()) { return false; }
+    FILE* f = fopen(m_cacheFile.c_str(), "wb");
+    if (!f && PathUtil::makeDir(PathUtil::dirname(m_cacheFile))) { f = fopen(m_cacheFile.c_str(), "wb"); }
+    if (!f) { return false; }
+    CacheHeader hdr = { cacheMagic, cacheVersion, m_hash, uint32_t(m_glyphs.size()), 0u };
+    std::vector<CacheGlyph> recs;
+    for (const auto& g : m_glyphs) {
+        recs.push_back({ g.codepoint, g.advance, g.x0, g.y0, g.x1, g.y1, uint16_t(g.width), uint16_t(g.height) });
+    }
+    bool ok = (fwrite(&hdr, sizeof(hdr), 1, f) == 1)
+           && (recs.empty() || (fwrite(recs.data(), sizeof(CacheGlyph), recs.size(), f) == recs.size()));
+    for (const auto& g : m_glyphs) {
+        if (ok && !g.pixels.empty()) { ok = (fwrite(g.pixels.data(), g.pixels.size(), 1, f) == 1); }
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (!ok) { remove(m_cacheFile.c_str()); }
+    return ok;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///// public interface
+
+const char* RuntimeFont::load(const char* path, const std::string& cacheDir) {
+    TRACE_SCOPE("load font");
+    *this = RuntimeFont();
+    if (!path || !path[0]) { return "no font file specified"; }
+    m_path.assign(path);
+
+    // read the font file
+    FILE* f = fopen(path, "rb");
+    if (!f) { return "could not open font file"; }
+    if (fseek(f, 0, SEEK_END) != 0) { fclose(f);  return "invalid font file"; }
+    size_t size = size_t(ftell(f));
+    if ((size < 12u) || (size > maxFontFileSize)) { fclose(f);  return "invalid font file size"; }
+    m_file.resize(size);
+    fseek(f, 0, SEEK_SET);
+    bool ok = (fread(m_file.data(), 1, size, f) == size);
+    fclose(f);
+    if (!ok) { return "could not read font file"; }
+    const char* error = parse();
+    if (error) { return error; }
+
+    // identify the font by a hash of its contents (FNV-1a)
+    m_hash = 0xCBF29CE484222325ull ^ cacheVersion;
+    for (uint8_t byte : m_file) { m_hash = (m_hash ^ byte) * 0x100000001B3ull; }
+    if (!cacheDir.empty()) {
+        char name[24];
+        snprintf(name, sizeof(name), "%016llx.tmfc", (unsigned long long)m_hash);
+        m_cacheFile = PathUtil::join(cacheDir, name);
+    }
+    m_name = PathUtil::stripExt(PathUtil::basename(m_path));
+
+    // get everything that has been generated before, and add what's missing
+    // from the default character set
+    loadCache();
+    std::vector<uint32_t> missing;
+    for (const auto& range : defaultCharset) {
+        for (uint32_t cp = range[0];  cp <= range[1];  ++cp) {
+            auto it = std::lower_bound(m_glyphs.begin(), m_glyphs.end(), cp,
+                [] (const GlyphBitmap& g, uint32_t c) { return g.codepoint < c; });
+            bool cached = (it != m_glyphs.end()) && (it->codepoint == cp);
+            if (!cached && (glyphIndex(cp) >= 0)) { missing.push_back(cp); }
+        }
+    }
+    generate(missing);
+    if (m_glyphs.empty()) { return "font doesn't contain any usable glyphs"; }
+    buildAtlas();
+    return nullptr;
+}
+
+void RuntimeFont::request(uint32_t codepoint) {
+    if (std::binary_search(m_unavailable.begin(), m_unavailable.end(), codepoint)) { return; }
+    if (std::find(m_requested.begin(), m_requested.end(), codepoint) != m_requested.end()) { return; }
+    auto it = std::lower_bound(m_glyphs.begin(), m_glyphs.end(), codepoint,
+                               [] (const GlyphBitmap& g, uint32_t c) { return g.codepoint < c; });
+    if ((it != m_glyphs.end()) && (it->codepoint == codepoint)) { return; }
+    if (glyphIndex(codepoint) < 0) {
+        m_unavailable.insert(std::upper_bound(m_unavailable.begin(), m_unavailable.end(), codepoint), codepoint);
+        return;
+    }
+    m_requested.push_back(codepoint);
+}
+
+void RuntimeFont::update() {
+    if (m_requested.empty()) { return; }
+    generate(m_requested);
+    m_requested.clear();
+    buildAtlas();
+}
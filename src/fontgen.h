@@ -0,0 +1,98 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+#include "font_data.h"
+
+//! A vector font that is loaded from a TrueType file at runtime.
+//!
+//! The glyph outlines are converted into a multi-channel signed distance
+//! field (MSDF) atlas with the same parameters as the built-in vector fonts
+//! (see font/build.sh), so TextBoxRenderer can use it just like those.
+//! Glyphs are generated on worker threads and cached on disk, in a file
+//! that is named after a hash of the font file; that way, only glyphs that
+//! have never been used with a font before need to be generated.
+class RuntimeFont {
+public:
+    static constexpr int EmSize     = 32;  //!< atlas resolution, in pixels per em
+    static constexpr int PixelRange = 8;   //!< total distance range, in atlas pixels
+    static constexpr int Padding    = 2;   //!< extra padding around each glyph, in atlas pixels
+
+    inline RuntimeFont() {}
+
+    //! check whether a font name refers to a font file (instead of a built-in font)
+    static bool isFontFile(const char* name);
+
+    //! load a font file and prepare the default character set
+    //! (see font/charset.txt), plus all glyphs that have been used with the
+    //! same font file before, from the cache if possible
+    //! \returns nullptr on success, or an error message
+    const char* load(const char* path, const std::string& cacheDir);
+
+    //! note that a glyph is missing from the atlas; if the font file
+    //! contains it, it will be generated on the next update()
+    void request(uint32_t codepoint);
+    //! check whether update() has anything to do
+    inline bool pending() const { return !m_requested.empty(); }
+    //! generate all requested glyphs and rebuild the atlas
+    void update();
+
+    inline const std::string& path()    const { return m_path; }
+    inline const FontData::Font& font() const { return m_font; }
+    inline int atlasWidth()             const { return m_atlasWidth; }
+    inline int atlasHeight()            const { return m_atlasHeight; }
+    //! atlas image (RGB, top-down)
+    inline const uint8_t* atlas()       const { return m_atlas.data(); }
+
+private:
+    //! a generated glyph, before it's placed in the atlas
+    struct GlyphBitmap {
+        uint32_t codepoint = 0;
+        float advance = 0.0f;                   // in ems
+        float x0 = 0.f, y0 = 0.f, x1 = 0.f, y1 = 0.f;  // position of the outermost pixel centers, in ems (Y up)
+        int width = 0, height = 0;              // bitmap size, without padding (0 = no outline)
+        std::vector<uint8_t> pixels;            // RGB, top-down
+    };
+    struct Shape;
+
+    std::string m_path;
+    std::string m_cacheFile;
+    uint64_t m_hash = 0;
+
+    // font file and the parts of it that we need
+    std::vector<uint8_t> m_file;
+    size_t m_glyf = 0, m_loca = 0, m_hmtx = 0, m_cmap = 0;
+    int m_cmapFormat = 0;
+    int m_numGlyphs = 0, m_numHMetrics = 0;
+    int m_unitsPerEm = 0;
+    bool m_longLoca = false;
+    float m_ascender = 0.0f, m_lineHeight = 0.0f, m_numberHeight = 0.0f;  // in ems
+
+    // generated data
+    std::vector<GlyphBitmap> m_glyphs;  // sorted by codepoint
+    std::vector<uint32_t> m_requested;
+    std::vector<uint32_t> m_unavailable;  // sorted; requested codepoints that aren't in the font
+    std::vector<FontData::Glyph> m_glyphTable;
+    FontData::Font m_font = { nullptr, 0, 0.0f, 0.0f, nullptr, 0, 0 };
+    std::string m_name;
+    std::vector<uint8_t> m_atlas;
+    int m_atlasWidth = 0, m_atlasHeight = 0;
+
+    const char* parse();
+    int glyphIndex(uint32_t codepoint) const;
+    bool glyphData(int glyph, size_t& start, size_t& end) const;
+    float advance(int glyph) const;
+    bool outline(int glyph, Shape& shape, int depth=0) const;
+    void generate(std::vector<uint32_t>& codepoints);
+    void generateGlyph(GlyphBitmap& g) const;
+    bool loadCache();
+    bool saveCache() const;
+    void buildAtlas();
+};
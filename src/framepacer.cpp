@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#include <cstdint>
+#include <cmath>
+
+#include <algorithm>
+#include <bitset>
+
+#include "framepacer.h"
+
+constexpr double gridTolerance  = 0.25;        // max. deviation from the grid, relative to the period
+constexpr double phaseGain      = 0.1;         // PLL phase correction per frame
+constexpr double periodGain     = 0.01;        // PLL period correction per frame
+constexpr double smoothingGain  = 0.1;         // exponential smoothing of unlocked frame times
+constexpr double minPeriod      = 1.0 / 500.0;
+constexpr double maxPeriod      = 1.0 / 20.0;
+constexpr double maxDelta       = 0.25;        // longer deltas are clamped (e.g. after the window was dragged)
+constexpr uint32_t lockWindow   = 0xFFFFu;     // number of recent frames considered for the lock state ...
+constexpr int    maxMisfits     = 2;           // ... and how many of them may not fit the grid
+
+void FramePacer::reset(double refreshRate) {
+    m_period = (refreshRate > 0.0) ? std::clamp(1.0 / refreshRate, minPeriod, maxPeriod) : (1.0 / 60.0);
+    m_gridTime = m_lastPredicted = m_lastDraw = m_smoothDelta = 0.0;
+    m_misfits = ~0u;  // start unlocked
+}
+
+bool FramePacer::locked() const {
+    return int(std::bitset<32>(m_misfits & lockWindow).count()) <= maxMisfits;
+}
+
+float FramePacer::frameDelta(double now) {
+    double raw = (m_lastDraw > 0.0) ? (now - m_lastDraw) : 0.0;
+    m_lastDraw = now;
+    if (raw <= 0.0) { return 0.0f; }
+    raw = std::min(raw, maxDelta);
+    m_smoothDelta = (m_smoothDelta > 0.0) ? (m_smoothDelta + smoothingGain * (raw - m_smoothDelta)) : raw;
+
+    if (!locked() || (m_gridTime <= 0.0)) {
+        m_lastPredicted = 0.0;
+        return float(m_smoothDelta);
+    }
+
+    // the frame will be presented at the next grid point that's still ahead
+    double predicted = m_gridTime + m_period;
+    if (predicted < now) { predicted += std::ceil((now - predicted) / m_period) * m_period; }
+    double delta = (m_lastPredicted > 0.0) ? (predicted - m_lastPredicted) : m_period;
+    m_lastPredicted = predicted;
+    return float(std::clamp(delta, 0.0, maxDelta));
+}
+
+int FramePacer::presented(double now) {
+    if (m_gridTime <= 0.0) { m_gridTime = now;  return 0; }
+    double interval = now - m_gridTime;
+    int n = std::max(1, int(interval / m_period + 0.5));
+    double err = interval - double(n) * m_period;
+    bool fits = (std::fabs(err) < (gridTolerance * m_period));
+    bool wasLocked = locked();
+    m_misfits = (m_misfits << 1) | (fits ? 0u : 1u);
+    if (!fits) {
+        // re-synchronize, and adapt the period to what's actually measured,
+        // so that we can lock on even if the nominal refresh rate was wrong
+        m_gridTime = now;
+        if (m_smoothDelta > 0.0) { m_period = std::clamp(m_smoothDelta, minPeriod, maxPeriod); }
+        return 0;
+    }
+    m_gridTime += double(n) * m_period + phaseGain * err;
+    m_period = std::clamp(m_period + periodGain * err / double(n), minPeriod, maxPeriod);
+    if (!wasLocked || (n < 2)) { return 0; }
+    m_missed += uint64_t(n - 1);
+    return n - 1;
+}
@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+
+//! Frame pacing for smooth animations.
+//!
+//! The time between two draw() calls is a noisy measurement of the time
+//! between two *presented* frames, which is what animations should advance
+//! by. With vsync, buffer swaps return on a grid of display refreshes; the
+//! pacer locks onto that grid (with a simple phase-locked loop that also
+//! refines the refresh period), predicts when the frame that's about to be
+//! drawn will be presented, and reports the difference between successive
+//! predictions as the frame delta, i.e. always a whole multiple of the
+//! estimated refresh period. If presentation times don't fit any grid (no
+//! vsync, variable refresh rate, or heavy jitter), the measured frame time
+//! is smoothed instead.
+class FramePacer {
+public:
+    //! start over, with a nominal refresh rate (in Hz; 0 = unknown)
+    void reset(double refreshRate);
+
+    //! get the animation time delta for the frame that's about to be drawn
+    //! \param now  current time, in seconds (arbitrary epoch)
+    //! \returns delta in seconds, or 0 for the first frame
+    float frameDelta(double now);
+
+    //! report that the frame has been presented (i.e. the buffer swap returned)
+    //! \param now  current time, in seconds (same epoch as in frameDelta())
+    //! \returns number of display refreshes that were missed before that
+    int presented(double now);
+
+    //! whether the pacer is currently locked to the display refresh
+    bool locked() const;
+    //! estimated display refresh period, in seconds
+    inline double refreshPeriod() const { return m_period; }
+    //! predicted presentation time of the last frame that frameDelta()
+    //! has been called for (0 = not predictable, i.e. not locked)
+    inline double predictedPresentTime() const { return m_lastPredicted; }
+    //! total number of missed display refreshes
+    inline uint64_t missedFrames() const { return m_missed; }
+
+private:
+    double m_period = 1.0 / 60.0;    //!< estimated refresh period
+    double m_gridTime = 0.0;         //!< phase-corrected time of the last presentation (0 = none yet)
+    double m_lastPredicted = 0.0;    //!< predicted presentation time of the current frame (0 = none)
+    double m_lastDraw = 0.0;         //!< time of the last frameDelta() call (0 = none yet)
+    double m_smoothDelta = 0.0;      //!< smoothed measured frame time
+    uint32_t m_misfits = 0u;         //!< one bit per frame: 1 = frame didn't fit the grid
+    uint64_t m_missed = 0u;
+};
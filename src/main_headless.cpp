@@ -0,0 +1,234 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+// tm_headless: runs TrackMeister without a window or audio device, driven
+// by a virtual clock (optionally replaying recorded input events), and
+// checks that steady-state frames don't allocate; optionally, frames are
+// drawn with the software rasterizer, so that it can be tested without a GPU
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "imgui.h"
+
+#include "system.h"
+#include "softrender.h"
+#include "util.h"
+#include "alloc_counter.h"
+#include "trace.h"
+#include "app.h"
+
+struct SystemInterfacePrivateData {
+    int width = 1920;
+    int height = 1080;
+    int sampleRate = 48000;
+    int bufferSize = 512;
+    bool paused = true;
+    bool software = false;
+    SoftwareRasterizer* raster = nullptr;
+};
+
+[[noreturn]] void SystemInterface::fatalError(const char *what, const char *how) {
+    fprintf(stderr, "FATAL: %s - %s\n", what, how);
+    std::exit(2);
+}
+
+void SystemInterface::initSystem() {}
+
+void SystemInterface::initVideo(const char* title, bool fullscreen, int windowWidth, int windowHeight, bool software) {
+    (void)title, (void)fullscreen;
+    m_priv->width = windowWidth;
+    m_priv->height = windowHeight;
+    if (m_priv->software || software) {
+        m_priv->raster = new SoftwareRasterizer;
+        if (!m_priv->raster->init(windowWidth, windowHeight)) {
+            fatalError("could not initialize software rendering", "out of memory");
+        }
+    }
+}
+
+int SystemInterface::initAudio(bool stereo, int sampleRate, int bufferSize) {
+    (void)stereo;
+    m_priv->sampleRate = sampleRate;
+    m_priv->bufferSize = bufferSize;
+    m_priv->paused = true;
+    return sampleRate;
+}
+
+// audio is rendered on the main thread, so there's nothing to lock
+void SystemInterface::lockAudioMutex() {}
+void SystemInterface::unlockAudioMutex() {}
+
+bool SystemInterface::headless() {
+    return true;
+}
+
+SoftwareRasterizer* SystemInterface::softwareRasterizer() {
+    return m_priv->raster;
+}
+
+bool SystemInterface::isPaused() {
+    return m_priv->paused;
+}
+
+bool SystemInterface::setPaused(bool paused) {
+    m_priv->paused = paused;
+    return m_priv->paused;
+}
+
+void SystemInterface::setWindowTitle(const char* title) { (void)title; }
+void SystemInterface::toggleFullscreen() {}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool writePPM(const char* filename, const SoftwareRasterizer& raster) {
+    FILE* f = fopen(filename, "wb");
+    if (!f) { return false; }
+    fprintf(f, "P6\n%d %d\n255\n", raster.width(), raster.height());
+    std::vector<uint8_t> row(size_t(raster.width()) * 3u);
+    bool ok = true;
+    for (int y = 0;  ok && (y < raster.height());  ++y) {
+        const uint32_t* src = &raster.pixels()[size_t(y) * size_t(raster.width())];
+        for (int x = 0;  x < raster.width();  ++x) {
+            row[x * 3 + 0] = uint8_t(src[x]);
+            row[x * 3 + 1] = uint8_t(src[x] >>  8);
+            row[x * 3 + 2] = uint8_t(src[x] >> 16);
+        }
+        ok = (fwrite(row.data(), row.size(), 1, f) == 1);
+    }
+    return !fclose(f) && ok;
+}
+
+static void usage(const char* argv0) {
+    printf("Usage: %s [OPTIONS] [+key=value ...] [module file or directory]\n", argv0);
+    printf("Options:\n");
+    printf("  -n, --frames N   number of frames to run (default: 600, or until the end of\n");
+    printf("                   the event log if replaying with +replay=<file>)\n");
+    printf("  -r, --fps FPS    virtual frame rate (default: 60)\n");
+    printf("  -s, --software   draw all frames with the software rasterizer\n");
+    printf("  -o, --output F   save the last frame as a PPM image (implies -s)\n");
+    printf("Exits with status 1 if any steady-state frame made heap allocations%s.\n",
+           AllocCounter::Enabled ? "" : " (NOTE: allocation counting is disabled in this build)");
+}
+
+int main(int argc, char* argv[]) {
+    // extract our own options, pass everything else on to the application
+    int numFrames = 0;
+    double fps = 60.0;
+    const char* outputFile = nullptr;
+    SystemInterfacePrivateData priv;
+    std::vector<char*> appArgs;
+    appArgs.push_back(argv[0]);
+    for (int i = 1;  i < argc;  ++i) {
+        const char* arg = argv[i];
+        bool hasValue = (i + 1) < argc;
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) { usage(argv[0]); return 0; }
+        else if ((!strcmp(arg, "-n") || !strcmp(arg, "--frames")) && hasValue) { numFrames = std::max(1, atoi(argv[++i])); }
+        else if ((!strcmp(arg, "-r") || !strcmp(arg, "--fps"))    && hasValue) { fps = std::max(1.0, atof(argv[++i])); }
+        else if ((!strcmp(arg, "-o") || !strcmp(arg, "--output")) && hasValue) { outputFile = argv[++i];  priv.software = true; }
+        else if  (!strcmp(arg, "-s") || !strcmp(arg, "--software")) { priv.software = true; }
+        else { appArgs.push_back(argv[i]); }
+    }
+    int appArgc = int(appArgs.size());
+    appArgs.push_back(nullptr);
+
+    // set up an ImGui context without a platform or renderer backend
+    ImGui::SetAllocatorFunctions(AllocCounter::imguiAlloc, AllocCounter::imguiFree);
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    unsigned char* fontPixels = nullptr;
+    int fontWidth = 0, fontHeight = 0;
+    io.Fonts->GetTexDataAsRGBA32(&fontPixels, &fontWidth, &fontHeight);
+
+    // initialize the application
+    SystemInterface sys(priv);
+    Application app(sys);
+    int ret = app.init(appArgc, appArgs.data());
+    if (ret >= 0) { return ret; }
+    if (priv.raster) {
+        io.Fonts->SetTexID((ImTextureID)(intptr_t)priv.raster->createTexture(fontPixels, fontWidth, fontHeight, 4, false));
+    }
+    io.DisplaySize = ImVec2(float(priv.width), float(priv.height));
+    bool untilReplayEnd = !numFrames && app.replayActive();
+    if (!numFrames) { numFrames = 600; }
+
+    // main loop with virtual clock; audio is rendered in chunks of one
+    // frame's worth, as if the audio callback would be called once per frame
+    float dt = float(1.0 / fps);
+    std::vector<int16_t> audio(size_t(double(priv.sampleRate) / fps + 2.0) * 2u);
+    double audioDebt = 0.0;
+    int frames = 0, steadyFrames = 0, allocFrames = 0;
+    uint64_t steadyAllocs = 0;
+    double drawTime = 0.0, audioTime = 0.0, maxDrawTime = 0.0, rasterTime = 0.0, maxRasterTime = 0.0;
+    using Clock = std::chrono::steady_clock;
+    auto tStart = Clock::now();
+    while ((untilReplayEnd ? !app.replayFinished() : (frames < numFrames)) && sys.active()) {
+        audioDebt += double(priv.sampleRate) / fps;
+        int samples = int(audioDebt);
+        audioDebt -= double(samples);
+        if (!priv.paused && (samples > 0)) {
+            auto t0 = Clock::now();
+            app.renderAudio(audio.data(), samples, true, priv.sampleRate);
+            audioTime += std::chrono::duration<double>(Clock::now() - t0).count();
+        }
+
+        io.DeltaTime = dt;
+        auto t0 = Clock::now();
+        ImGui::NewFrame();
+        app.draw(frames ? dt : 0.0f);
+        ImGui::Render();
+        double t = std::chrono::duration<double>(Clock::now() - t0).count();
+        drawTime += t;
+        maxDrawTime = std::max(maxDrawTime, t);
+        if (priv.raster) {
+            t0 = Clock::now();
+            priv.raster->addImGui(ImGui::GetDrawData());
+            priv.raster->render();
+            t = std::chrono::duration<double>(Clock::now() - t0).count();
+            rasterTime += t;
+            maxRasterTime = std::max(maxRasterTime, t);
+        }
+
+        if (app.frameSteady()) {
+            ++steadyFrames;
+            if (app.frameAllocations()) {
+                ++allocFrames;
+                steadyAllocs += app.frameAllocations();
+                fprintf(stderr, "frame %d: %d heap allocation(s) in steady state\n", frames, int(app.frameAllocations()));
+            }
+        }
+        ++frames;
+    }
+
+    double wallTime = std::chrono::duration<double>(Clock::now() - tStart).count();
+    double quadsPerFrame = double(app.renderer().quadsEmitted()) / double(std::max(frames, 1));
+    double callsPerFrame = double(app.renderer().drawCalls())    / double(std::max(frames, 1));
+    bool outputOK = !outputFile || writePPM(outputFile, *priv.raster);
+    if (!outputOK) { fprintf(stderr, "could not write output image '%s'\n", outputFile); }
+    app.shutdown();
+    Trace::shutdown();  // only now no other threads are running anymore
+    ImGui::DestroyContext();
+    delete priv.raster;
+
+    printf("frames:                  %d (%.3f s virtual, %.3f s wall clock time)\n", frames, double(frames) / fps, wallTime);
+    printf("steady-state frames:     %d\n", steadyFrames);
+    printf("frames with allocations: %d (%llu allocations total)%s\n", allocFrames, (unsigned long long)steadyAllocs,
+           AllocCounter::Enabled ? "" : " [allocation counting disabled]");
+    printf("draw time:               %.3f ms average, %.3f ms max\n", drawTime * 1000.0 / double(std::max(frames, 1)), maxDrawTime * 1000.0);
+    if (priv.raster) {
+        printf("rasterization time:      %.3f ms average, %.3f ms max\n", rasterTime * 1000.0 / double(std::max(frames, 1)), maxRasterTime * 1000.0);
+    } else {
+        printf("quads per frame:         %.1f (in %.1f draw calls)\n", quadsPerFrame, callsPerFrame);
+    }
+    printf("audio rendering time:    %.3f ms per frame\n", audioTime * 1000.0 / double(std::max(frames, 1)));
+    return allocFrames ? 1 : (outputOK ? 0 : 2);
+}
@@ -9,6 +9,10 @@
     #include <windows.h>
 #endif
 
+#include <cstdint>
+
+#include <algorithm>
+
 #include <SDL.h>
 #include <glad/glad.h>
 #include "imgui.h"
@@ -16,7 +20,12 @@
 #include "imgui_impl_opengl3.h"
 
 #include "system.h"
+#include "softrender.h"
+#include "framepacer.h"
 #include "util.h"
+#include "trace.h"
+#include "metrics.h"
+#include "alloc_counter.h"
 #include "app.h"
 
 struct SystemInterfacePrivateData {
@@ -24,6 +33,10 @@ struct SystemInterfacePrivateData {
     Application* app = nullptr;
     SDL_Window* win = nullptr;
     SDL_GLContext ctx = nullptr;
+    SoftwareRasterizer* raster = nullptr;  //!< only used if OpenGL isn't
+    Uint64 nextFrame = 0;                  //!< software rendering frame pacing
+    int refreshRate = 60;
+    FramePacer pacer;
     ImGuiIO* io = nullptr;
     SDL_AudioDeviceID audio = 0;
     int sampleRate = 0;
@@ -91,8 +104,9 @@ void SystemInterface::initSystem() {
     }
 #endif
 
-void SystemInterface::initVideo(const char* title, bool fullscreen, int windowWidth, int windowHeight) {
-    initSystem();
+//! create an OpenGL 3.3 window and context
+//! \returns nullptr on success, or an error message
+static const char* initOpenGL(SystemInterfacePrivateData* priv, const char* title, bool fullscreen, int windowWidth, int windowHeight) {
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE,            0);
     SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE,          0);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
@@ -102,25 +116,18 @@ void SystemInterface::initVideo(const char* title, bool fullscreen, int windowWi
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS,     SDL_GL_CONTEXT_DEBUG_FLAG);
     #endif
 
-    m_priv->win = SDL_CreateWindow(title,
+    priv->win = SDL_CreateWindow(title,
         SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
         windowWidth, windowHeight,
         SDL_WINDOW_OPENGL | SDL_WINDOW_ALLOW_HIGHDPI |
         (fullscreen ? SDL_WINDOW_FULLSCREEN_DESKTOP : SDL_WINDOW_RESIZABLE));
-    if (!m_priv->win) {
-        fatalError("could not create window", SDL_GetError());
-    }
-    m_priv->fullscreen = fullscreen;
+    if (!priv->win) { return "could not create OpenGL window"; }
 
-    m_priv->ctx = SDL_GL_CreateContext(m_priv->win);
-    if (!m_priv->ctx) {
-        fatalError("could not create OpenGL context", SDL_GetError());
-    }
-    SDL_GL_MakeCurrent(m_priv->win, m_priv->ctx);
+    priv->ctx = SDL_GL_CreateContext(priv->win);
+    if (!priv->ctx) { return "could not create OpenGL context"; }
+    SDL_GL_MakeCurrent(priv->win, priv->ctx);
     SDL_GL_SetSwapInterval(1);
-    if (!gladLoadGL()) {
-        fatalError("could not initialize OpenGL", "failed to load OpenGL functions");
-    }
+    if (!gladLoadGL()) { return "failed to load OpenGL functions"; }
     #ifndef NDEBUG
         printf("OpenGL vendor:   %s\n", glGetString(GL_VENDOR));
         printf("OpenGL renderer: %s\n", glGetString(GL_RENDERER));
@@ -132,28 +139,124 @@ void SystemInterface::initVideo(const char* title, bool fullscreen, int windowWi
         }
     #endif
     if ((GLVersion.major < 3) || ((GLVersion.major == 3) && (GLVersion.minor < 3))) {
-        fatalError("could not initialize OpenGL", "at least OpenGL 3.3 is required");
+        return "at least OpenGL 3.3 is required";
+    }
+    return nullptr;
+}
+
+void SystemInterface::initVideo(const char* title, bool fullscreen, int windowWidth, int windowHeight, bool software) {
+    initSystem();
+    m_priv->fullscreen = fullscreen;
+
+    const char* glError = software ? nullptr : initOpenGL(m_priv, title, fullscreen, windowWidth, windowHeight);
+    if (glError) {
+        fprintf(stderr, "WARNING: %s (%s), falling back to software rendering\n", glError, SDL_GetError());
+        if (m_priv->ctx) { SDL_GL_DeleteContext(m_priv->ctx);  m_priv->ctx = nullptr; }
+        if (m_priv->win) { SDL_DestroyWindow(m_priv->win);     m_priv->win = nullptr; }
+    }
+    if (software || glError) {
+        // without OpenGL, there's no HiDPI support; the window surface is
+        // always in window units
+        m_priv->win = SDL_CreateWindow(title,
+            SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+            windowWidth, windowHeight,
+            fullscreen ? SDL_WINDOW_FULLSCREEN_DESKTOP : SDL_WINDOW_RESIZABLE);
+        if (!m_priv->win) {
+            fatalError("could not create window", SDL_GetError());
+        }
+        int w = 0, h = 0;
+        SDL_GetWindowSize(m_priv->win, &w, &h);
+        m_priv->raster = new SoftwareRasterizer;
+        if (!m_priv->raster->init(w, h)) {
+            fatalError("could not initialize software rendering", "out of memory");
+        }
+    }
+    SDL_DisplayMode mode;
+    if (!SDL_GetWindowDisplayMode(m_priv->win, &mode) && (mode.refresh_rate > 0)) {
+        m_priv->refreshRate = mode.refresh_rate;
     }
+    m_priv->pacer.reset(double(m_priv->refreshRate));
 
+    ImGui::SetAllocatorFunctions(AllocCounter::imguiAlloc, AllocCounter::imguiFree);
     ImGui::CreateContext();
     m_priv->io = &ImGui::GetIO();
     m_priv->io->ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
     m_priv->io->IniFilename = nullptr;
-    ImGui_ImplSDL2_InitForOpenGL(m_priv->win, m_priv->ctx);
-    ImGui_ImplOpenGL3_Init("#version 330");
+    if (m_priv->raster) {
+        ImGui_ImplSDL2_InitForOther(m_priv->win);
+        unsigned char* pixels = nullptr;
+        int w = 0, h = 0;
+        m_priv->io->Fonts->GetTexDataAsRGBA32(&pixels, &w, &h);
+        m_priv->io->Fonts->SetTexID((ImTextureID)(intptr_t)m_priv->raster->createTexture(pixels, w, h, 4, false));
+    } else {
+        ImGui_ImplSDL2_InitForOpenGL(m_priv->win, m_priv->ctx);
+        ImGui_ImplOpenGL3_Init("#version 330");
+    }
 
     if (fullscreen) { SDL_ShowCursor(SDL_DISABLE); }
 }
 
+//! get the window size in drawable pixels (which differs from window units
+//! on HiDPI displays in OpenGL mode)
+static void getDrawableSize(SystemInterfacePrivateData& priv, int& w, int& h) {
+    if (priv.raster) {
+        SDL_GetWindowSize(priv.win, &w, &h);
+    } else {
+        SDL_GL_GetDrawableSize(priv.win, &w, &h);
+    }
+}
+
+//! rasterize the frame into the window surface, and wait until the next
+//! frame is due (there's no vsync without OpenGL)
+static void presentSoftware(SystemInterfacePrivateData& priv) {
+    SDL_Surface* surface = SDL_GetWindowSurface(priv.win);
+    const SDL_PixelFormat* fmt = surface ? surface->format : nullptr;
+    bool rgba = fmt && (fmt->BytesPerPixel == 4) && (fmt->Rmask == 0x000000FFu) && (fmt->Gmask == 0x0000FF00u) && (fmt->Bmask == 0x00FF0000u);
+    bool bgra = fmt && (fmt->BytesPerPixel == 4) && (fmt->Rmask == 0x00FF0000u) && (fmt->Gmask == 0x0000FF00u) && (fmt->Bmask == 0x000000FFu);
+    if ((rgba || bgra) && !SDL_LockSurface(surface)) {
+        priv.raster->render(surface->pixels, surface->w, surface->h, surface->pitch, bgra);
+        SDL_UnlockSurface(surface);
+    } else {
+        // unusual surface format: let SDL do the conversion
+        priv.raster->render();
+        if (surface && !SDL_LockSurface(surface)) {
+            SDL_ConvertPixels(std::min(surface->w, priv.raster->width()), std::min(surface->h, priv.raster->height()),
+                              SDL_PIXELFORMAT_RGBA32, priv.raster->pixels(), priv.raster->width() * 4,
+                              fmt->format, surface->pixels, surface->pitch);
+            SDL_UnlockSurface(surface);
+        }
+    }
+    if (surface) { SDL_UpdateWindowSurface(priv.win); }
+
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (now < priv.nextFrame) {
+        SDL_Delay(Uint32((priv.nextFrame - now) * 1000u / freq));
+        now = priv.nextFrame;
+    }
+    priv.nextFrame = now + freq / Uint64(priv.refreshRate);
+}
+
 static void sysRenderAudio(void* userdata, Uint8* stream, int len) {
     auto *priv = static_cast<SystemInterfacePrivateData*>(userdata);
+    Trace::setThreadName("audio");
+    TRACE_SCOPE("audio callback");
+    uint64_t t0 = Metrics::nowUs();
+    int sampleCount = 0;
     bool ok = false;
     if (priv && priv->app) {
-        ok = priv->app->renderAudio((int16_t*)stream, priv->stereo ? (len >> 2) : (len >> 1), priv->stereo, priv->sampleRate);
+        sampleCount = priv->stereo ? (len >> 2) : (len >> 1);
+        ok = priv->app->renderAudio((int16_t*)stream, sampleCount, priv->stereo, priv->sampleRate);
     }
     if (!ok) {
         SDL_memset(stream, 0, len);
     }
+    if (ok) {
+        g_metrics.latency.audioOutput((const int16_t*)stream, len >> 1);
+    }
+    if (ok && priv->sampleRate) {
+        g_metrics.addCallback(uint32_t(Metrics::nowUs() - t0), uint32_t(uint64_t(sampleCount) * 1000000u / uint64_t(priv->sampleRate)));
+    }
 }
 
 int SystemInterface::initAudio(bool stereo, int sampleRate, int bufferSize) {
@@ -167,6 +270,7 @@ int SystemInterface::initAudio(bool stereo, int sampleRate, int bufferSize) {
     want.callback = sysRenderAudio;
     want.userdata = static_cast<void*>(m_priv);
     m_priv->paused = true;
+    Trace::reserveBuffer("audio");  // (the callback must not allocate it)
     m_priv->audio = SDL_OpenAudioDevice(nullptr, SDL_FALSE, &want, &got, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_SAMPLES_CHANGE);
     if (!m_priv->audio) {
         fatalError("could not open audio device", SDL_GetError());
@@ -187,6 +291,14 @@ void SystemInterface::unlockAudioMutex() {
     }
 }
 
+bool SystemInterface::headless() {
+    return false;
+}
+
+SoftwareRasterizer* SystemInterface::softwareRasterizer() {
+    return m_priv->raster;
+}
+
 bool SystemInterface::isPaused() {
     return m_priv->paused;
 }
@@ -224,6 +336,8 @@ int main(int argc, char* argv[]) {
     SDL_EventState(SDL_DROPFILE, SDL_ENABLE);
     Uint64 tPrev = 0;
     while (sys.active()) {
+        TRACE_SCOPE("frame");
+        uint64_t tPhase = Trace::now();
         SDL_Event ev;
         while (SDL_PollEvent(&ev)) {
             ImGui_ImplSDL2_ProcessEvent(&ev);
@@ -249,7 +363,11 @@ int main(int argc, char* argv[]) {
                     }
                     auto mods = SDL_GetModState();
                     if (!priv.io || !priv.io->WantCaptureKeyboard) {
+                        // SDL event timestamps are in milliseconds since SDL_Init()
+                        uint64_t eventAgeUs = uint64_t(Uint32(SDL_GetTicks() - ev.key.timestamp)) * 1000u;
+                        g_metrics.latency.setInputTime(Metrics::nowUs() - eventAgeUs);
                         app.handleKey(key, !!(mods & KMOD_CTRL), !!(mods & KMOD_SHIFT), !!(mods & KMOD_ALT));
+                        g_metrics.latency.setInputTime(0u);
                     }
                     break; }
                 case SDL_MOUSEWHEEL:
@@ -257,6 +375,17 @@ int main(int argc, char* argv[]) {
                         app.handleMouseWheel(ev.wheel.y);
                     }
                     break;
+                case SDL_MOUSEBUTTONDOWN:
+                    if ((ev.button.button == SDL_BUTTON_LEFT) && (!priv.io || !priv.io->WantCaptureMouse)) {
+                        // mouse coordinates are in window units, but the
+                        // application works in drawable pixels (HiDPI!)
+                        int ww = 0, wh = 0, dw = 0, dh = 0;
+                        SDL_GetWindowSize(priv.win, &ww, &wh);
+                        getDrawableSize(priv, dw, dh);
+                        app.handleMouseClick(ww ? (ev.button.x * dw / ww) : ev.button.x,
+                                             wh ? (ev.button.y * dh / wh) : ev.button.y);
+                    }
+                    break;
                 case SDL_DROPFILE:
                     app.handleDropFile(ev.drop.file);
                     SDL_free(ev.drop.file);
@@ -265,7 +394,7 @@ int main(int argc, char* argv[]) {
                     if (ev.window.event == SDL_WINDOWEVENT_RESIZED) {
                         int rw = 0, rh = 0;
                         // get actual drawable size of the window in pixels to account for high-DPI on macOS
-                        SDL_GL_GetDrawableSize(priv.win, &rw, &rh);
+                        getDrawableSize(priv, rw, rh);
                         app.handleResize(rw, rh);
                     }
                     break;
@@ -277,16 +406,40 @@ int main(int argc, char* argv[]) {
             }   // end of event type switch
         }   // end of event poll loop
 
+        Trace::complete("events", tPhase, Trace::now());
+
         // let the application render the frame
-        ImGui_ImplOpenGL3_NewFrame();
+        if (!priv.raster) { ImGui_ImplOpenGL3_NewFrame(); }
         ImGui_ImplSDL2_NewFrame();
         ImGui::NewFrame();
         Uint64 tNow = SDL_GetPerformanceCounter();
-        app.draw(tPrev ? float(double(tNow - tPrev) / double(SDL_GetPerformanceFrequency())) : 0.0f);
+        double invFreq = 1.0 / double(SDL_GetPerformanceFrequency());
+        float dt = priv.pacer.frameDelta(double(tNow) * invFreq);
+        if (!app.framePacing()) { dt = tPrev ? float(double(tNow - tPrev) * invFreq) : 0.0f; }
+        app.draw(dt);
         tPrev = tNow;
+        tPhase = Trace::now();
         ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        SDL_GL_SwapWindow(priv.win);
+        if (priv.raster) {
+            priv.raster->addImGui(ImGui::GetDrawData());
+        } else {
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        uint64_t tSwap = Trace::now();
+        Trace::complete("ImGui render", tPhase, tSwap);
+        if (priv.raster) {
+            presentSoftware(priv);
+        } else {
+            SDL_GL_SwapWindow(priv.win);
+        }
+        g_metrics.latency.frameSwapped();
+        Trace::complete("swap", tSwap, Trace::now());
+        int missed = priv.pacer.presented(double(SDL_GetPerformanceCounter()) * invFreq);
+        if (missed) {
+            Trace::instant("missed frame");
+            g_metrics.missedFrames.fetch_add(uint64_t(missed), std::memory_order_relaxed);
+        }
+        g_metrics.refreshRate.store(priv.pacer.locked() ? float(1.0 / priv.pacer.refreshPeriod()) : 0.0f, std::memory_order_relaxed);
     }
 
     // uninitialization
@@ -297,8 +450,9 @@ int main(int argc, char* argv[]) {
     if (priv.audio) {
         SDL_CloseAudioDevice(priv.audio);
     }
+    Trace::shutdown();  // only now no other threads are running anymore
     if (priv.io) {
-        ImGui_ImplOpenGL3_Shutdown();
+        if (!priv.raster) { ImGui_ImplOpenGL3_Shutdown(); }
         ImGui_ImplSDL2_Shutdown();
         ImGui::DestroyContext();
     }
@@ -306,6 +460,7 @@ int main(int argc, char* argv[]) {
         SDL_GL_MakeCurrent(nullptr, nullptr);
         SDL_GL_DeleteContext(priv.ctx);
     }
+    delete priv.raster;
     if (priv.win) {
         SDL_DestroyWindow(priv.win);
     }
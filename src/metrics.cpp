@@ -0,0 +1,256 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+
+#include "metrics.h"
+
+Metrics g_metrics;
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// TimingHistogram
+
+void TimingHistogram::add(uint32_t us) {
+    // there's only a single writer, so we can get away without atomic RMW ops
+    constexpr auto rlx = std::memory_order_relaxed;
+    int bucket = 0;
+    for (uint32_t v = us;  (v > 1u) && (bucket < (NumBuckets - 1));  v >>= 1) { ++bucket; }
+    m_buckets[bucket].store(m_buckets[bucket].load(rlx) + 1u, rlx);
+    m_sumUs.store(m_sumUs.load(rlx) + us, rlx);
+    if (us < m_minUs.load(rlx)) { m_minUs.store(us, rlx); }
+    if (us > m_maxUs.load(rlx)) { m_maxUs.store(us, rlx); }
+    m_count.store(m_count.load(rlx) + 1u, std::memory_order_release);
+}
+
+void TimingHistogram::reset() {
+    m_count.store(0u);
+    m_sumUs.store(0u);
+    m_minUs.store(~0u);
+    m_maxUs.store(0u);
+    for (auto& b : m_buckets) { b.store(0u); }
+}
+
+void TimingHistogram::snapshot(Snapshot& s) const {
+    s.count = m_count.load(std::memory_order_acquire);
+    s.sumUs = m_sumUs.load();
+    s.minUs = s.count ? m_minUs.load() : 0u;
+    s.maxUs = m_maxUs.load();
+    for (int i = 0;  i < NumBuckets;  ++i) { s.buckets[i] = m_buckets[i].load(); }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// LatencyProbe
+
+const char* LatencyProbe::actionName(Action action) {
+    switch (action) {
+        case Action::Play: return "play";
+        case Action::Load: return "load";
+        case Action::Seek: return "seek";
+        default:           return "unknown";
+    }
+}
+
+void LatencyProbe::arm(Action action) {
+    if (!m_inputUs) { return; }
+    uint64_t pending = (uint64_t(int(action) + 1) << ActionShift) | m_inputUs;
+    m_framePending = pending;
+    m_audioDeferred = (action == Action::Load) ? pending : 0u;
+    m_audioPending.store(m_audioDeferred ? 0u : pending, std::memory_order_release);
+}
+
+void LatencyProbe::startAudio() {
+    if (!m_audioDeferred) { return; }
+    m_audioPending.store(m_audioDeferred, std::memory_order_release);
+    m_audioDeferred = 0u;
+}
+
+void LatencyProbe::disarm() {
+    m_framePending = m_audioDeferred = 0u;
+    m_audioPending.store(0u, std::memory_order_release);
+}
+
+void LatencyProbe::audioOutput(const int16_t* data, int count) {
+    uint64_t pending = m_audioPending.load(std::memory_order_acquire);
+    if (!pending) { return; }
+    Action action = Action(int(pending >> ActionShift) - 1);
+    if (action == Action::Seek) { return; }  // completed by audioDone()
+    // wait for the first audible output
+    bool silent = true;
+    for (int i = 0;  i < count;  ++i) {
+        if (data[i]) { silent = false; break; }
+    }
+    if (silent) { return; }
+    if (!m_audioPending.compare_exchange_strong(pending, 0u)) { return; }  // re-armed in the meantime
+    uint64_t inputUs = pending & ((uint64_t(1) << ActionShift) - 1u);
+    audio[int(action)].add(uint32_t(Metrics::nowUs() - inputUs));
+}
+
+void LatencyProbe::audioDone(Action action) {
+    uint64_t pending = m_audioPending.load(std::memory_order_acquire);
+    if (!pending || (Action(int(pending >> ActionShift) - 1) != action)) { return; }
+    if (!m_audioPending.compare_exchange_strong(pending, 0u)) { return; }  // re-armed in the meantime
+    uint64_t inputUs = pending & ((uint64_t(1) << ActionShift) - 1u);
+    audio[int(action)].add(uint32_t(Metrics::nowUs() - inputUs));
+}
+
+void LatencyProbe::frameSwapped() {
+    m_audioDeferred = 0u;  // if the audio hasn't been started until now, it won't be
+    if (!m_framePending) { return; }
+    Action action = Action(int(m_framePending >> ActionShift) - 1);
+    if (m_frameHeld && (action == Action::Seek)) { return; }
+    uint64_t inputUs = m_framePending & ((uint64_t(1) << ActionShift) - 1u);
+    frame[int(action)].add(uint32_t(Metrics::nowUs() - inputUs));
+    m_framePending = 0u;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// Metrics
+
+void Metrics::setFilename(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_filenameLock);
+    m_filename.assign(name);
+}
+
+uint64_t Metrics::nowUs() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Metrics::addCallback(uint32_t us, uint32_t budgetUs) {
+    callbackTime.add(us);
+    callbackBudgetUs.store(budgetUs, std::memory_order_relaxed);
+    if (us > budgetUs) {
+        underruns.store(underruns.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+    }
+}
+
+uint64_t Metrics::memoryTotal() const {
+    uint64_t total = 0u;
+    for (const auto& m : memory) { total += m.load(std::memory_order_relaxed); }
+    return total;
+}
+
+const char* Metrics::memoryCategoryName(MemoryCategory cat) {
+    switch (cat) {
+        case MemoryCategory::ModuleData:     return "module_data";
+        case MemoryCategory::ModuleInstance: return "module_instance";
+        case MemoryCategory::PatternCache:   return "pattern_cache";
+        case MemoryCategory::TextArea:       return "text_area";
+        case MemoryCategory::Textures:       return "textures";
+        case MemoryCategory::Analysis:       return "analysis";
+        default:                             return "unknown";
+    }
+}
+
+static void reportLine(std::string& out, const char* key, const char* fmt, ...) {
+    char value[128];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(value, sizeof(value), fmt, args);
+    va_end(args);
+    out.append(key);
+    out.push_back(' ');
+    out.append(value);
+    out.push_back('\n');
+}
+
+static void reportHistogram(std::string& out, const char* prefix, const TimingHistogram& h) {
+    TimingHistogram::Snapshot s;
+    h.snapshot(s);
+    std::string key(prefix);
+    size_t baseLen = key.size();
+    auto line = [&] (const char* suffix) -> const char* {
+        key.resize(baseLen);
+        key.append(suffix);
+        return key.c_str();
+    };
+    reportLine(out, line("_count"),   "%llu", (unsigned long long)s.count);
+    reportLine(out, line("_min_us"),  "%u", s.minUs);
+    reportLine(out, line("_mean_us"), "%.1f", s.count ? (double(s.sumUs) / double(s.count)) : 0.0);
+    reportLine(out, line("_max_us"),  "%u", s.maxUs);
+    std::string hist;
+    for (int i = 0;  i < TimingHistogram::NumBuckets;  ++i) {
+        if (i) { hist.push_back(' '); }
+        hist.append(std::to_string(s.buckets[i]));
+    }
+    reportLine(out, line("_histogram_log2_us"), "%s", hist.c_str());
+}
+
+bool Metrics::report(std::string& out, const char* section) const {
+    bool all = !section || !section[0];
+    bool any = all;
+    auto want = [&] (const char* name) -> bool {
+        if (all) { return true; }
+        if (strcmp(section, name)) { return false; }
+        any = true;
+        return true;
+    };
+    constexpr auto rlx = std::memory_order_relaxed;
+    if (want("position")) {
+        {
+            std::lock_guard<std::mutex> lock(m_filenameLock);
+            out.append("file ").append(m_filename).push_back('\n');
+        }
+        reportLine(out, "loaded",   "%d", moduleLoaded.load(rlx) ? 1 : 0);
+        reportLine(out, "playing",  "%d", playing.load(rlx) ? 1 : 0);
+        reportLine(out, "order",    "%d", order.load(rlx));
+        reportLine(out, "pattern",  "%d", pattern.load(rlx));
+        reportLine(out, "row",      "%d", row.load(rlx));
+        reportLine(out, "position", "%.3f", double(position.load(rlx)));
+        reportLine(out, "duration", "%.3f", double(duration.load(rlx)));
+        reportLine(out, "loop_start", "%.3f", double(loopStart.load(rlx)));
+        reportLine(out, "loop_end", "%.3f", double(loopEnd.load(rlx)));
+    }
+    if (want("audio")) {
+        reportHistogram(out, "callback", callbackTime);
+        reportLine(out, "callback_budget_us", "%u", callbackBudgetUs.load(rlx));
+        reportLine(out, "underruns", "%llu", (unsigned long long)underruns.load(rlx));
+    }
+    if (want("frames")) {
+        reportHistogram(out, "frame", frameTime);
+        reportLine(out, "missed_frames", "%llu", (unsigned long long)missedFrames.load(rlx));
+        reportLine(out, "refresh_hz", "%.2f", double(refreshRate.load(rlx)));
+    }
+    if (want("latency")) {
+        std::string prefix;
+        for (int i = 0;  i < int(LatencyProbe::Action::Count);  ++i) {
+            prefix.assign("latency_");
+            prefix.append(LatencyProbe::actionName(LatencyProbe::Action(i)));
+            size_t baseLen = prefix.size();
+            reportHistogram(out, prefix.append("_audio").c_str(), latency.audio[i]);
+            prefix.resize(baseLen);
+            reportHistogram(out, prefix.append("_frame").c_str(), latency.frame[i]);
+        }
+    }
+    if (want("cache")) {
+        uint64_t hits = patternCacheHits.load(rlx), misses = patternCacheMisses.load(rlx);
+        reportLine(out, "pattern_cache_hits",     "%llu", (unsigned long long)hits);
+        reportLine(out, "pattern_cache_misses",   "%llu", (unsigned long long)misses);
+        reportLine(out, "pattern_cache_hit_rate", "%.4f", (hits + misses) ? (double(hits) / double(hits + misses)) : 0.0);
+        reportLine(out, "pattern_cache_entries",  "%llu", (unsigned long long)patternCacheEntries.load(rlx));
+    }
+    if (want("memory")) {
+        std::string key;
+        for (int i = 0;  i < int(MemoryCategory::Count);  ++i) {
+            key.assign("mem_");
+            key.append(memoryCategoryName(MemoryCategory(i)));
+            reportLine(out, key.c_str(), "%llu", (unsigned long long)memory[i].load(rlx));
+        }
+        reportLine(out, "mem_total",     "%llu", (unsigned long long)memoryTotal());
+        reportLine(out, "mem_budget",    "%llu", (unsigned long long)memoryBudget.load(rlx));
+        reportLine(out, "mem_evictions", "%llu", (unsigned long long)memoryEvictions.load(rlx));
+    }
+    return any;
+}
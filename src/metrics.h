@@ -0,0 +1,177 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+//! histogram of durations with power-of-two microsecond buckets
+//! (bucket 0: < 2 us, bucket 1: 2-3 us, bucket 2: 4-7 us, ...; the last
+//! bucket also takes everything larger than that);
+//! there may only be one writer thread, but any number of readers
+class TimingHistogram {
+public:
+    static constexpr int NumBuckets = 20;  // last bucket starts at ~0.5 s
+
+    //! add a new sample
+    void add(uint32_t us);
+
+    //! reset all statistics; must be done by the writer thread
+    void reset();
+
+    //! consistent-enough copy of the histogram data
+    struct Snapshot {
+        uint64_t count;
+        uint64_t sumUs;
+        uint32_t minUs;
+        uint32_t maxUs;
+        uint64_t buckets[NumBuckets];
+    };
+    void snapshot(Snapshot& s) const;
+
+private:
+    std::atomic<uint64_t> m_count { 0 };
+    std::atomic<uint64_t> m_sumUs { 0 };
+    std::atomic<uint32_t> m_minUs { ~0u };
+    std::atomic<uint32_t> m_maxUs { 0 };
+    std::atomic<uint64_t> m_buckets[NumBuckets] = {};
+};
+
+//! Input-to-output latency measurement.
+//! The main thread sets the timestamp of each input event before handling
+//! it; if handling it triggers one of the measured actions, the probe is
+//! armed. The audio thread then reports the first callback that outputs the
+//! result (i.e. non-silent samples after starting playback or loading a
+//! module, or any samples after a seek), and the main thread reports the
+//! first frame swapped after the action. Both delays are recorded in
+//! separate histograms per action.
+class LatencyProbe {
+public:
+    enum class Action : int { Play = 0, Load, Seek, Count };
+    static const char* actionName(Action action);
+
+    //! set the time (in Metrics::nowUs() units) of the input event that's
+    //! going to be handled next, or 0 after handling it (main thread)
+    inline void setInputTime(uint64_t us) { m_inputUs = us; }
+    //! mark that the current input event triggers an action (main thread);
+    //! does nothing if no input time has been set; for Load, the audio
+    //! measurement is deferred until startAudio(), so that output of the
+    //! previous module isn't mistaken for the new one
+    void arm(Action action);
+    //! start a deferred audio measurement, right before the audio output
+    //! of the newly loaded module starts (main thread)
+    void startAudio();
+    //! cancel all pending measurements, e.g. because the action failed (main thread)
+    void disarm();
+    //! check the output of an audio callback (audio thread)
+    //! \param count  number of 16-bit values (not sample frames) in the buffer
+    void audioOutput(const int16_t* data, int count);
+    //! report that the audio thread carried out an action; seeks are
+    //! measured this way instead of by audioOutput() (audio thread)
+    void audioDone(Action action);
+    //! keep frameSwapped() from completing a seek measurement while the
+    //! seek is still in progress (main thread)
+    inline void holdFrame(bool hold) { m_frameHeld = hold; }
+    //! report that a frame has been swapped (main thread)
+    void frameSwapped();
+
+    TimingHistogram audio[int(Action::Count)];  //!< written by the audio thread
+    TimingHistogram frame[int(Action::Count)];  //!< written by the main thread
+
+private:
+    // pending measurements are encoded as ((action + 1) << 60) | input time;
+    // 0 means that no measurement is pending
+    static constexpr int ActionShift = 60;
+    uint64_t m_inputUs = 0;                    //!< only used by the main thread
+    uint64_t m_framePending = 0;               //!< only used by the main thread
+    uint64_t m_audioDeferred = 0;              //!< only used by the main thread
+    bool m_frameHeld = false;                  //!< only used by the main thread
+    std::atomic<uint64_t> m_audioPending { 0 };
+};
+
+//! memory accounting categories
+enum class MemoryCategory : int {
+    ModuleData = 0,  //!< raw module file data
+    ModuleInstance,  //!< OpenMPT module instance (estimated)
+    PatternCache,    //!< formatted pattern display cells
+    TextArea,        //!< metadata text area content
+    Textures,        //!< OpenGL textures (font, logo, background), including mipmaps
+    Analysis,        //!< cached module analysis results (time index etc.)
+    Count
+};
+
+//! Runtime metrics that can be queried from other threads (e.g. the remote
+//! control server) without touching the audio lock: all values are
+//! atomics that are published by the thread that owns them.
+struct Metrics {
+    // playback position (published by the main thread once per frame)
+    std::atomic<bool>     moduleLoaded { false };
+    std::atomic<bool>     playing      { false };
+    std::atomic<int>      order        { 0 };
+    std::atomic<int>      pattern      { 0 };
+    std::atomic<int>      row          { 0 };
+    std::atomic<float>    position     { 0.0f };  //!< in seconds
+    std::atomic<float>    duration     { 0.0f };  //!< in seconds
+    std::atomic<float>    loopStart    { -1.0f }; //!< in seconds, -1 if not known (yet)
+    std::atomic<float>    loopEnd      { -1.0f }; //!< in seconds, -1 if not known (yet)
+
+    // audio callback (published by the audio thread)
+    TimingHistogram       callbackTime;
+    std::atomic<uint32_t> callbackBudgetUs { 0 };  //!< duration of the audio in the last callback
+    std::atomic<uint64_t> underruns        { 0 };  //!< callbacks that took longer than their audio duration
+
+    // frames (published by the main thread)
+    TimingHistogram       frameTime;
+    std::atomic<uint64_t> missedFrames { 0 };     //!< display refreshes missed while locked to vsync
+    std::atomic<float>    refreshRate  { 0.0f };  //!< estimated display refresh rate, 0 = not locked
+
+    // input-to-output latency
+    LatencyProbe          latency;
+
+    // pattern display cache (published by the main thread)
+    std::atomic<uint64_t> patternCacheHits    { 0 };
+    std::atomic<uint64_t> patternCacheMisses  { 0 };
+    std::atomic<uint64_t> patternCacheEntries { 0 };
+
+    // memory usage per category, in bytes (published by the main thread)
+    std::atomic<uint64_t> memory[int(MemoryCategory::Count)] = {};
+    std::atomic<uint64_t> memoryBudget    { 0 };  //!< 0 = unlimited
+    std::atomic<uint64_t> memoryEvictions { 0 };  //!< number of cache entries evicted to stay within the budget
+
+    //! set the memory usage of a category
+    inline void setMemory(MemoryCategory cat, uint64_t bytes)
+        { memory[int(cat)].store(bytes, std::memory_order_relaxed); }
+    //! get the memory usage of a category
+    inline uint64_t getMemory(MemoryCategory cat) const
+        { return memory[int(cat)].load(std::memory_order_relaxed); }
+    //! get the total memory usage of all categories
+    uint64_t memoryTotal() const;
+    //! get the name of a memory category (as used in the report)
+    static const char* memoryCategoryName(MemoryCategory cat);
+
+    //! set the name of the currently loaded file
+    void setFilename(const std::string& name);
+
+    //! get the current time in microseconds (arbitrary epoch)
+    static uint64_t nowUs();
+
+    //! record an audio callback's duration
+    void addCallback(uint32_t us, uint32_t budgetUs);
+
+    //! generate a human- and machine-readable report ("key value" lines)
+    //! \param section  "position", "audio", "frames", "latency", "cache",
+    //!                 "memory" or nullptr/empty for all of them
+    //! \returns false if the section name is unknown
+    bool report(std::string& out, const char* section=nullptr) const;
+
+private:
+    mutable std::mutex m_filenameLock;  //!< only protects m_filename
+    std::string m_filename;
+};
+
+//! global metrics instance
+extern Metrics g_metrics;
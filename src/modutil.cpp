@@ -0,0 +1,180 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <string>
+#include <iostream>
+
+#if defined(TM_MIXER_ARCH_AVX2) && defined(_MSC_VER)
+    #include <intrin.h>
+    #include <immintrin.h>
+#endif
+
+#include <libopenmpt/libopenmpt.hpp>
+#include <libopenmpt/libopenmpt_ext.hpp>
+
+#include "config.h"
+#include "modutil.h"
+
+namespace ModUtil {
+
+const char* checkCPU() {
+    #if defined(TM_MIXER_ARCH_AVX2)
+        bool ok;
+        #if defined(_MSC_VER)
+            // AVX2 and FMA, plus OS support for saving the YMM registers
+            int info[4];
+            __cpuid(info, 0);
+            ok = (info[0] >= 7);
+            if (ok) {
+                __cpuid(info, 1);
+                ok = (info[2] & (1 << 12)) && (info[2] & (1 << 27)) && (info[2] & (1 << 28))  // FMA, OSXSAVE, AVX
+                  && ((_xgetbv(0) & 6u) == 6u);
+            }
+            if (ok) {
+                __cpuidex(info, 7, 0);
+                ok = !!(info[1] & (1 << 5));  // AVX2
+            }
+        #else
+            __builtin_cpu_init();
+            ok = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        #endif
+        if (!ok) { return "this build of TrackMeister requires a CPU with AVX2 and FMA support (it has been built with TM_MIXER_ARCH=AVX2)"; }
+    #endif
+    return nullptr;
+}
+
+const char* loadFile(const char* path, std::vector<std::byte>& data) {
+    FILE *f = fopen(path, "rb");
+    if (!f) { return "could not open file"; }
+    // fopen() may still succeed on directories, giving us a broken file
+    // descriptor with erratic behavior; try to detect this as best as we can
+    if (fseek(f, 0, SEEK_END) != 0) { fclose(f); return "invalid file"; }
+    size_t size = size_t(ftell(f));
+    if (size >= (size_t(-1) >> 1)) { fclose(f); return "invalid file"; }
+    if (size >= MaxFileSize) { fclose(f); return "file too large"; }
+    data.resize(size);
+    fseek(f, 0, SEEK_SET);
+    if (fread(data.data(), 1, size, f) != size) { fclose(f); return "could not read file"; }
+    fclose(f);
+    return nullptr;
+}
+
+openmpt::module* createModule(const std::vector<std::byte>& data, const Config& config, bool loop, std::string& error) {
+    std::map<std::string, std::string> ctls;
+    ctls["play.at_end"] = loop ? "continue" : "stop";
+    switch (config.filter) {
+        case FilterMethod::Auto:
+        case FilterMethod::Amiga:
+            ctls["render.resampler.emulate_amiga"] = "1";
+            break;
+        case FilterMethod::A500:
+            ctls["render.resampler.emulate_amiga"] = "1";
+            ctls["render.resampler.emulate_amiga_type"] = "a500";
+            break;
+        case FilterMethod::A1200:
+            ctls["render.resampler.emulate_amiga"] = "1";
+            ctls["render.resampler.emulate_amiga_type"] = "a1200";
+            break;
+        default: break;  // no Amiga resampler -> set later using set_render_param
+    }
+    openmpt::module* mod = nullptr;
+    try {
+        mod = new openmpt::module_ext(data, std::clog, ctls);
+    } catch (openmpt::exception& e) {
+        error.assign(std::string("invalid module - ") + e.what());
+        return nullptr;
+    }
+    if (!mod) { error.assign("invalid module data"); return nullptr; }
+    switch (config.filter) {
+        case FilterMethod::Auto:   mod->set_render_param(openmpt::module::render_param::RENDER_INTERPOLATIONFILTER_LENGTH, 0); break;
+        case FilterMethod::None:   mod->set_render_param(openmpt::module::render_param::RENDER_INTERPOLATIONFILTER_LENGTH, 1); break;
+        case FilterMethod::Linear: mod->set_render_param(openmpt::module::render_param::RENDER_INTERPOLATIONFILTER_LENGTH, 2); break;
+        case FilterMethod::Cubic:  mod->set_render_param(openmpt::module::render_param::RENDER_INTERPOLATIONFILTER_LENGTH, 4); break;
+        case FilterMethod::Sinc:   mod->set_render_param(openmpt::module::render_param::RENDER_INTERPOLATIONFILTER_LENGTH, 8); break;
+        default: break;  // Amiga -> no need to set up anything
+    }
+    mod->set_render_param(openmpt::module::render_param::RENDER_STEREOSEPARATION_PERCENT, config.stereoSeparation);
+    mod->set_render_param(openmpt::module::render_param::RENDER_VOLUMERAMPING_STRENGTH,   config.volumeRamping);
+    return mod;
+}
+
+size_t estimateModuleMemory(const openmpt::module* mod, size_t fileSize) {
+    if (!mod) { return 0u; }
+    // rough sizes of OpenMPT's internal data structures
+    constexpr size_t bytesPerPatternCell = 6u;    // ModCommand
+    constexpr size_t bytesPerSample      = 128u;  // ModSample, without sample data
+    constexpr size_t bytesPerInstrument  = 1024u; // ModInstrument, including envelopes
+    size_t bytes = fileSize;
+    size_t channels = size_t(std::max(0, mod->get_num_channels()));
+    for (int pat = mod->get_num_patterns() - 1;  pat >= 0;  --pat) {
+        bytes += size_t(std::max(0, mod->get_pattern_num_rows(pat))) * channels * bytesPerPatternCell;
+    }
+    bytes += size_t(std::max(0, mod->get_num_samples()))     * bytesPerSample;
+    bytes += size_t(std::max(0, mod->get_num_instruments())) * bytesPerInstrument;
+    return bytes;
+}
+
+void formatPatternCell(PatternCell& dest, const openmpt::module* mod, int pat, int row, int ch, int chars) {
+    if (!mod) {
+        dest.text[0] = dest.attr[0] = '\0';
+        return;
+    }
+
+    // use OpemMPT's built-in formatter for a start
+    ::strcpy(dest.text,    mod->format_pattern_row_channel(pat, row, ch, chars).c_str());
+    ::strcpy(dest.attr, mod->highlight_pattern_row_channel(pat, row, ch, chars).c_str());
+    if (int(strlen(dest.text)) != chars) {
+        // if OpenMPT produced an unexpected number of characters, stop all further analysis
+        return;
+    }
+
+    // helper function: check if a string contains useful information (not just dots and spaces)
+    auto hasData = [] (const char* s) -> bool {
+        while (*s) {
+            if ((*s != ' ') && (*s != '.')) { return true; }
+            ++s;
+        }
+        return false;
+    };
+    // helper function: copy a single character from a C++ string iff it's not empty
+    auto copyChar = [] (char* sOut, const std::string& sIn) {
+        if (!sIn.empty()) { *sOut = sIn[0]; }
+    };
+
+    // helper function: query specific information from OpenMPT to override
+    // an otherwise empty tail of a cell text
+    auto updateTail = [&] (openmpt::module::command_index effectTypeIndex, openmpt::module::command_index paramIndex) {
+        // if there's already valid data in the tail, don't change it
+        if (hasData(&dest.text[chars - 3])) { return; }
+        // fill in the effect parameter first (will be dots if there's no effect)
+        ::strcpy(&dest.text[chars - 2],    mod->format_pattern_row_channel_command(pat, row, ch, paramIndex).c_str());
+        ::strcpy(&dest.attr[chars - 2], mod->highlight_pattern_row_channel_command(pat, row, ch, paramIndex).c_str());
+        // if there was a parameter, fill in the effect type too
+        if (hasData(&dest.text[chars - 2])) {
+            copyChar(&dest.text[chars - 3],    mod->format_pattern_row_channel_command(pat, row, ch, effectTypeIndex));
+            copyChar(&dest.attr[chars - 3], mod->highlight_pattern_row_channel_command(pat, row, ch, effectTypeIndex));
+        }
+    };
+
+    // in the more compact formats, replace the last row by the effect
+    // if there is nothing else to show there
+    if (chars >= 3) {
+        updateTail(openmpt::module::command_index::command_effect, openmpt::module::command_index::command_parameter);
+    }
+    // in the most compact format, try the volume command to
+    if (chars == 3) {
+        updateTail(openmpt::module::command_index::command_volumeffect, openmpt::module::command_index::command_volume);
+    }
+}
+
+}  // namespace ModUtil
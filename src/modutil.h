@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <vector>
+#include <string>
+
+#include "config.h"
+
+namespace openmpt {
+    class module;
+}
+
+namespace ModUtil {
+
+//! maximum size of a module file that will be loaded
+constexpr size_t MaxFileSize = 64u << 20;  // 64 MiB ought to be enough for everybody
+
+//! check whether the CPU supports the instruction set extensions that
+//! libopenmpt's mixer kernels have been compiled for (see TM_MIXER_ARCH);
+//! this must be called before any module is rendered
+//! \returns nullptr if the CPU is supported, or a short error message
+const char* checkCPU();
+
+//! load a module file into memory
+//! \returns nullptr on success, or a short error message on failure
+const char* loadFile(const char* path, std::vector<std::byte>& data);
+
+//! create an OpenMPT module instance and apply the render parameters
+//! (filter, stereo separation, volume ramping) from a configuration
+//! \param loop   whether playback shall continue after the end of the song
+//! \param error  receives a short error message on failure
+//! \returns the new module instance (owned by the caller; it's actually an
+//!          openmpt::module_ext, so the extension interfaces are available),
+//!          or nullptr on failure
+openmpt::module* createModule(const std::vector<std::byte>& data, const Config& config, bool loop, std::string& error);
+
+//! estimate the heap memory used by an OpenMPT module instance, in bytes
+//! (libopenmpt doesn't expose this, so it's derived from the pattern sizes,
+//! the number of samples and instruments, and the size of the module file,
+//! which is a good approximation of the sample data for most formats)
+size_t estimateModuleMemory(const openmpt::module* mod, size_t fileSize);
+
+//! a single formatted pattern display cell (text + highlighting attributes)
+struct PatternCell { char text[16], attr[16]; };
+
+//! format a single pattern display cell with a specific width
+//! (3, 6, 9 or 13 characters, see the pattern display formats in updateLayout())
+void formatPatternCell(PatternCell& dest, const openmpt::module* mod, int pat, int row, int ch, int chars);
+
+}  // namespace ModUtil
@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <atomic>
+
+//! Bounded lock-free multi-producer, single-consumer queue.
+//!
+//! Each cell carries a sequence number that tells producers and the
+//! consumer whether the cell is free or filled, so neither side ever needs
+//! a lock, and push() and pop() never allocate. Items should be small PODs.
+template <typename T, size_t Capacity>
+class MPSCQueue {
+    static_assert((Capacity >= 2u) && !(Capacity & (Capacity - 1u)), "queue capacity must be a power of two");
+    static constexpr size_t Mask = Capacity - 1u;
+
+    struct Cell {
+        std::atomic<size_t> seq;
+        T item;
+    };
+    Cell m_cells[Capacity];
+    std::atomic<size_t> m_head { 0 };  //!< next position to write (shared by all producers)
+    size_t m_tail = 0;                 //!< next position to read (consumer only)
+
+public:
+    inline MPSCQueue() {
+        for (size_t i = 0u;  i < Capacity;  ++i) {
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    //! append an item (any thread)
+    //! \returns false if the queue is full
+    bool push(const T& item) {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = m_cells[pos & Mask];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff < 0) { return false; }  // cell still holds an unread item
+            if (!diff && m_head.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed)) {
+                cell.item = item;
+                cell.seq.store(pos + 1u, std::memory_order_release);
+                return true;
+            }
+            if (diff) { pos = m_head.load(std::memory_order_relaxed); }  // another producer was faster
+        }
+    }
+
+    //! remove the oldest item (consumer thread only)
+    //! \returns false if the queue is empty
+    bool pop(T& item) {
+        Cell& cell = m_cells[m_tail & Mask];
+        if (cell.seq.load(std::memory_order_acquire) != (m_tail + 1u)) { return false; }
+        item = cell.item;
+        cell.seq.store(m_tail + Capacity, std::memory_order_release);
+        ++m_tail;
+        return true;
+    }
+
+    //! discard all pending items (consumer thread only)
+    inline void clear() { T dummy; while (pop(dummy)); }
+};
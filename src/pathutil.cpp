@@ -141,6 +141,15 @@ bool isDir(const char* path) {
     #endif
 }
 
+bool makeDir(const char* path) {
+    if (!path || !path[0]) { return false; }
+    #ifdef _WIN32
+        return !!CreateDirectoryA(path, nullptr);
+    #else
+        return (mkdir(path, 0777) == 0);
+    #endif
+}
+
 int64_t getFileMTime(const char* path) {
     if (!path || !path[0]) { return 0; }
     #ifdef _WIN32
@@ -98,6 +98,13 @@ bool isDir(const char* path);
 inline bool isDir(const std::string& path)
     { return isDir(path.c_str()); }
 
+//! create a directory (non-recursively)
+//! \returns true if the directory has been created
+bool makeDir(const char* path);
+//! create a directory (non-recursively)
+inline bool makeDir(const std::string& path)
+    { return makeDir(path.c_str()); }
+
 //! determine the modification time of a file
 //! \returns an opaque timestamp in an implementation-defined format;
 //!          the only guarantee is that it's monotonically increasing,
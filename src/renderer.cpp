@@ -10,6 +10,8 @@
 
 #include <new>
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 #include <glad/glad.h>
 #include "lodepng.h"
@@ -17,30 +19,54 @@
 #include "util.h"
 
 #include "renderer.h"
+#include "softrender.h"
 #include "font_data.h"
+#include "fontgen.h"
 
 constexpr int BatchSize = 16384;  // must be 16384 or less
 
+constexpr float minRenderScale    = 0.25f;   // lowest manually configured render scale
+constexpr float minAutoScale      = 0.5f;    // lowest automatic render scale
+constexpr float autoScaleStep     = 0.125f;  // automatic render scale granularity
+constexpr int   autoScaleInterval = 30;      // number of frames between automatic render scale changes
+constexpr float autoScaleDownAt   = 0.75f;   // scale down if GPU time exceeds this fraction of the frame period
+constexpr float autoScaleUpAt     = 0.5f;    // scale up if the estimated GPU time at the next step stays below this fraction
+constexpr int   runLookback       = 8;       // number of runs a quad may be moved back across to join one of its mode
+constexpr int   occluderMargin    = 4;       // pixels kept below the edges of occluders (for filtering in scaled layers)
+
+// estimated sizes of all currently loaded textures, for memory accounting
+// (textures are only ever created and destroyed on the main thread)
+static std::vector<std::pair<unsigned, size_t>> textureSizes;
+static size_t textureSizeTotal = 0u;
+
+// if set, textures are created in the software rasterizer instead of OpenGL
+static SoftwareRasterizer* softwareRaster = nullptr;
+
+static void addTextureSize(unsigned texID, size_t bytes, bool mipmap) {
+    if (mipmap) { bytes += bytes / 3u; }
+    textureSizes.emplace_back(texID, bytes);
+    textureSizeTotal += bytes;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
-unsigned TextBoxRenderer::loadTexture(const void* pngData, size_t pngSize, int channels, bool mipmap, TextureDimensions* dims) {
-    LodePNGColorType pngFormat;  GLenum glIntFormat, glInFormat;
+unsigned TextBoxRenderer::createTexture(const uint8_t* pixels, int width, int height, int channels, bool mipmap) {
+    GLenum glIntFormat, glInFormat;
     switch (channels) {
-        case 1: pngFormat = LCT_GREY;       glIntFormat = GL_R8;    glInFormat = GL_RED;  break;
-        case 2: pngFormat = LCT_GREY_ALPHA; glIntFormat = GL_RG8;   glInFormat = GL_RG;   break;
-        case 3: pngFormat = LCT_RGB;        glIntFormat = GL_RGB8;  glInFormat = GL_RGB;  break;
-        case 4: pngFormat = LCT_RGBA;       glIntFormat = GL_RGBA8; glInFormat = GL_RGBA; break;
+        case 1: glIntFormat = GL_R8;    glInFormat = GL_RED;  break;
+        case 2: glIntFormat = GL_RG8;   glInFormat = GL_RG;   break;
+        case 3: glIntFormat = GL_RGB8;  glInFormat = GL_RGB;  break;
+        case 4: glIntFormat = GL_RGBA8; glInFormat = GL_RGBA; break;
         default: return 0;
     }
-
-    uint8_t *img = nullptr;
-    unsigned width = 0, height = 0;
-    if (lodepng_decode_memory(&img, &width, &height, static_cast<const unsigned char*>(pngData), pngSize, pngFormat, 8)
-    || !img || !width || !height)
-        { free((void*)img); return 0; }
-    if (dims) { dims->width = int(width); dims->height = int(height); }
+    if (!pixels || (width <= 0) || (height <= 0)) { return 0; }
 
     unsigned texID = 0;
+    if (softwareRaster) {
+        texID = softwareRaster->createTexture(pixels, width, height, channels, mipmap);
+        if (texID) { addTextureSize(texID, size_t(width) * size_t(height) * size_t(channels), mipmap); }
+        return texID;
+    }
     glGenTextures(1, &texID);
     if (!texID) { return 0; }
     while (glGetError());
@@ -51,12 +77,37 @@ unsigned TextBoxRenderer::loadTexture(const void* pngData, size_t pngSize, int c
     if (mipmap) { glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, -1.0f); }
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     if ((width * channels) & 3) { glPixelStorei(GL_UNPACK_ALIGNMENT, 1); }
-    glTexImage2D(GL_TEXTURE_2D, 0, glIntFormat, width, height, 0, glInFormat, GL_UNSIGNED_BYTE, static_cast<const void*>(img));
+    glTexImage2D(GL_TEXTURE_2D, 0, glIntFormat, width, height, 0, glInFormat, GL_UNSIGNED_BYTE, static_cast<const void*>(pixels));
     if (mipmap) { glGenerateMipmap(GL_TEXTURE_2D); }
     glBindTexture(GL_TEXTURE_2D, 0);
     glFlush(); glFinish();
-    free((void*)img);
     if (glGetError()) { glDeleteTextures(1, &texID); texID = 0; }
+    if (texID) {
+        // RGB textures are usually padded to RGBA by the driver;
+        // a full mip chain adds another 1/3
+        addTextureSize(texID, size_t(width) * size_t(height) * size_t((channels == 3) ? 4 : channels), mipmap);
+    }
+    return texID;
+}
+
+unsigned TextBoxRenderer::loadTexture(const void* pngData, size_t pngSize, int channels, bool mipmap, TextureDimensions* dims) {
+    LodePNGColorType pngFormat;
+    switch (channels) {
+        case 1: pngFormat = LCT_GREY;       break;
+        case 2: pngFormat = LCT_GREY_ALPHA; break;
+        case 3: pngFormat = LCT_RGB;        break;
+        case 4: pngFormat = LCT_RGBA;       break;
+        default: return 0;
+    }
+
+    uint8_t *img = nullptr;
+    unsigned width = 0, height = 0;
+    if (lodepng_decode_memory(&img, &width, &height, static_cast<const unsigned char*>(pngData), pngSize, pngFormat, 8)
+    || !img || !width || !height)
+        { free((void*)img); return 0; }
+    if (dims) { dims->width = int(width); dims->height = int(height); }
+    unsigned texID = createTexture(img, int(width), int(height), channels, mipmap);
+    free((void*)img);
     return texID;
 }
 
@@ -79,11 +130,26 @@ unsigned TextBoxRenderer::loadTexture(const char* filename, int channels, bool m
 
 void TextBoxRenderer::freeTexture(unsigned &texID) {
     if (!texID) { return; }
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glDeleteTextures(1, &texID);
+    for (auto it = textureSizes.begin();  it != textureSizes.end();  ++it) {
+        if (it->first == texID) {
+            textureSizeTotal -= it->second;
+            textureSizes.erase(it);
+            break;
+        }
+    }
+    if (softwareRaster) {
+        softwareRaster->deleteTexture(texID);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glDeleteTextures(1, &texID);
+    }
     texID = 0;
 }
 
+size_t TextBoxRenderer::textureMemory() {
+    return textureSizeTotal;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static const char* vsSrc =
@@ -104,9 +170,10 @@ static const char* vsSrc =
 "\n" "}"
 "\n";
 
+// the fragment shader is compiled once per render mode, with MODE_IS(m)
+// evaluating to a constant, so all other modes' code is removed
 static const char* fsSrc =
-     "#version 330"
-"\n" "     in vec2 vTC;"
+     "     in vec2 vTC;"
 "\n" "flat in vec3 vSize;"
 "\n" "flat in vec2 vBR;"
 "\n" "     in vec4 vColor;"
@@ -122,19 +189,19 @@ static const char* fsSrc =
 "\n" "}"
 "\n" "void main() {"
 "\n" "    float d = 0.;"
-"\n" "    if (vMode == 1u) {  // MSDF text mode"
+"\n" "    if (MODE_IS(1)) {  // MSDF text mode"
 "\n" "        d = 0.25 * (sampleMSDF(vTC + vSize.xy * vec2(-0.375, -0.125))"
 "\n" "                 +  sampleMSDF(vTC + vSize.xy * vec2(+0.125, -0.375))"
 "\n" "                 +  sampleMSDF(vTC + vSize.xy * vec2(-0.125, +0.375))"
 "\n" "                 +  sampleMSDF(vTC + vSize.xy * vec2(+0.375, +0.125)));"
-"\n" "    } else if (vMode == 0u) {  // box mode"
+"\n" "    } else if (MODE_IS(0)) {  // box mode"
 "\n" "        vec2 p = abs(vTC) - vSize.xy;"
 "\n" "        d = (min(p.x, p.y) > (-vSize.z))"
 "\n" "          ? (vSize.z - length(p + vec2(vSize.z)))"
 "\n" "          : min(-p.x, -p.y);"
-"\n" "    } else if (vMode == 3u) {  // bitmap text mode"
+"\n" "    } else if (MODE_IS(3)) {  // bitmap text mode"
 "\n" "        d = texture(uBitmap, vTC).r;"
-"\n" "    } else if (vMode == 2u) {  // logo mode"
+"\n" "    } else if (MODE_IS(2)) {  // logo mode"
 "\n" "        d = texture(uTex, vTC).r;"
 "\n" "    } else {  // normal texture mode"
 "\n" "        outColor = texture(uTex, vTC);  return;"
@@ -143,17 +210,34 @@ static const char* fsSrc =
 "\n" "}"
 "\n";
 
-namespace RenderMode {
-    constexpr uint8_t Texture    = 4;
-    constexpr uint8_t Logo       = 2;
-    constexpr uint8_t Box        = 0;
-    constexpr uint8_t MSDFText   = 1;
-    constexpr uint8_t BitmapText = 3;
-};
+static GLuint compileShader(GLenum type, const char* prefix, const char* src) {
+    GLint res;
+    GLuint shader = glCreateShader(type);
+    const char* sources[2] = { prefix, src };
+    glShaderSource(shader, 2, sources, nullptr);
+    glCompileShader(shader);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &res);
+    if (res == GL_TRUE) { return shader; }
+    #ifndef NDEBUG
+        ::puts(prefix);
+        ::puts(src);
+        printf("%s compilation failed.\n", (type == GL_VERTEX_SHADER) ? "Vertex Shader" : "Fragment Shader");
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &res);
+        char* msg = new(std::nothrow) char[res];
+        if (msg) {
+            glGetShaderInfoLog(shader, res, nullptr, msg);
+            ::puts(msg);
+            delete[] msg;
+        }
+    #endif
+    glDeleteShader(shader);
+    return 0;
+}
 
 bool TextBoxRenderer::init() {
     GLint res;
     m_error = "unknown error";
+    m_headless = false;
 
     viewportChanged();
 
@@ -163,7 +247,7 @@ bool TextBoxRenderer::init() {
     glGenBuffers(1, &m_vbo);
     glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
     glBufferData(GL_ARRAY_BUFFER, BatchSize * 4 * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
-    m_vertices = nullptr;
+    if (!allocBuffers()) { return false; }
     m_quadCount = 0;
     m_tex = 0;
 
@@ -201,71 +285,39 @@ bool TextBoxRenderer::init() {
     glFlush(); glFinish();
     delete[] iboData;
 
-    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vs, 1, &vsSrc, nullptr);
-    glCompileShader(vs);
-    glGetShaderiv(vs, GL_COMPILE_STATUS, &res);
-    if (res != GL_TRUE) {
-        m_error = "Vertex Shader compilation failed";
-        #ifndef NDEBUG
-            ::puts(vsSrc);
-            printf("%s.\n", m_error);
-            glGetShaderiv(vs, GL_INFO_LOG_LENGTH, &res);
-            char* msg = new(std::nothrow) char[res];
-            if (msg) {
-                glGetShaderInfoLog(vs, res, nullptr, msg);
-                puts(msg);
-                delete[] msg;
-            }
-        #endif
-        return false;
-    }
-
-    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fs, 1, &fsSrc, nullptr);
-    glCompileShader(fs);
-    glGetShaderiv(fs, GL_COMPILE_STATUS, &res);
-    if (res != GL_TRUE) {
-        m_error = "Fragment Shader compilation failed";
-        #ifndef NDEBUG
-            ::puts(fsSrc);
-            printf("%s.\n", m_error);
-            glGetShaderiv(fs, GL_INFO_LOG_LENGTH, &res);
-            char* msg = new(std::nothrow) char[res];
-            if (msg) {
-                glGetShaderInfoLog(fs, res, nullptr, msg);
-                ::puts(msg);
-                delete[] msg;
-            }
-        #endif
-        return false;
-    }
-
-    m_prog = glCreateProgram();
-    glAttachShader(m_prog, vs);
-    glAttachShader(m_prog, fs);
-    glLinkProgram(m_prog);
-    glGetProgramiv(m_prog, GL_LINK_STATUS, &res);
-    if (res != GL_TRUE) {
-        m_error = "Shader Program linking failed";
-        #ifndef NDEBUG
-            printf("%s.\n", m_error);
-            glGetProgramiv(m_prog, GL_INFO_LOG_LENGTH, &res);
-            char* msg = new(std::nothrow) char[res];
-            if (msg) {
-                glGetProgramInfoLog(m_prog, res, nullptr, msg);
-                ::puts(msg);
-                delete[] msg;
-            }
-        #endif
-        return false;
+    GLuint vs = compileShader(GL_VERTEX_SHADER, "", vsSrc);
+    if (!vs) { m_error = "Vertex Shader compilation failed"; return false; }
+    for (int mode = 0;  mode < RenderMode::Count;  ++mode) {
+        char prefix[64];
+        snprintf(prefix, 64, "#version 330\n#define MODE_IS(m) (m == %d)\n", mode);
+        GLuint fs = compileShader(GL_FRAGMENT_SHADER, prefix, fsSrc);
+        if (!fs) { m_error = "Fragment Shader compilation failed"; return false; }
+        m_prog[mode] = glCreateProgram();
+        glAttachShader(m_prog[mode], vs);
+        glAttachShader(m_prog[mode], fs);
+        glLinkProgram(m_prog[mode]);
+        glGetProgramiv(m_prog[mode], GL_LINK_STATUS, &res);
+        if (res != GL_TRUE) {
+            m_error = "Shader Program linking failed";
+            #ifndef NDEBUG
+                printf("%s.\n", m_error);
+                glGetProgramiv(m_prog[mode], GL_INFO_LOG_LENGTH, &res);
+                char* msg = new(std::nothrow) char[res];
+                if (msg) {
+                    glGetProgramInfoLog(m_prog[mode], res, nullptr, msg);
+                    ::puts(msg);
+                    delete[] msg;
+                }
+            #endif
+            return false;
+        }
+        glDeleteShader(fs);
+        glUseProgram(m_prog[mode]);
+        glUniform1i(glGetUniformLocation(m_prog[mode], "uBitmap"), 1);
+        m_locInvAlphaGamma[mode] = glGetUniformLocation(m_prog[mode], "uInvAlphaGamma");
+        glUniform1f(m_locInvAlphaGamma[mode], 1.0f);
     }
-    glDeleteShader(fs);
     glDeleteShader(vs);
-    glUseProgram(m_prog);
-    glUniform1i(glGetUniformLocation(m_prog, "uBitmap"), 1);
-    m_locInvAlphaGamma = glGetUniformLocation(m_prog, "uInvAlphaGamma");
-    glUniform1f(m_locInvAlphaGamma, 1.0f);
 
     m_fontTex = loadTexture(static_cast<const void*>(FontData::TexData), FontData::TexDataSize, 3, true);
     if (!m_fontTex) { m_error = "failed to load and decode the font texture"; return false; }
@@ -283,65 +335,367 @@ bool TextBoxRenderer::init() {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    glGenQueries(NumTimerQueries, m_timerQueries);
+    m_queryHead = m_queryCount = 0;
+
+    m_currentFont = &FontData::Fonts[0];
+    m_currentFontTex = m_fontTex;
+    m_error = "success";
+    return true;
+}
+
+bool TextBoxRenderer::initHeadless(int width, int height) {
+    m_error = "unknown error";
+    m_headless = true;
+    setViewportSize(width, height);
+    if (!allocBuffers()) { return false; }
+    m_quadCount = 0;
+    m_tex = 0;
+    m_fontTex = 1;  // dummy texture ID, only used to trigger batch breaks
     m_currentFont = &FontData::Fonts[0];
+    m_currentFontTex = m_fontTex;
+    m_error = "success";
+    return true;
+}
+
+bool TextBoxRenderer::allocBuffers() {
+    // quads are collected in system memory, so they can be re-ordered
+    // (or handed to the software rasterizer) on flush()
+    m_vertices = new(std::nothrow) Vertex[BatchSize * 4];
+    m_runs = new(std::nothrow) Run[BatchSize];
+    m_quadRun = new(std::nothrow) uint16_t[BatchSize];
+    if (!m_vertices || !m_runs || !m_quadRun) { m_error = "out of memory"; return false; }
+    return true;
+}
+
+void TextBoxRenderer::freeBuffers() {
+    delete[] m_vertices;  m_vertices = nullptr;
+    delete[] m_runs;      m_runs = nullptr;
+    delete[] m_quadRun;   m_quadRun = nullptr;
+}
+
+bool TextBoxRenderer::initSoftware(SoftwareRasterizer* raster) {
+    m_error = "unknown error";
+    m_headless = false;
+    m_raster = softwareRaster = raster;
+    setViewportSize(raster->width(), raster->height());
+    if (!allocBuffers()) { return false; }
+    m_quadCount = 0;
+    m_tex = 0;
+    m_fontTex = loadTexture(static_cast<const void*>(FontData::TexData), FontData::TexDataSize, 3, true);
+    if (!m_fontTex) { m_error = "failed to load and decode the font texture"; return false; }
+    m_currentFont = &FontData::Fonts[0];
+    m_currentFontTex = m_fontTex;
     m_error = "success";
     return true;
 }
 
 void TextBoxRenderer::setAlphaGamma(float gamma) {
-    glUseProgram(m_prog);
-    glUniform1f(m_locInvAlphaGamma, 1.0f / gamma);
+    if (m_headless) { return; }
+    if (m_raster) { m_raster->setAlphaGamma(gamma); return; }
+    for (int mode = 0;  mode < RenderMode::Count;  ++mode) {
+        glUseProgram(m_prog[mode]);
+        glUniform1f(m_locInvAlphaGamma[mode], 1.0f / gamma);
+    }
 }
 
-void TextBoxRenderer::viewportChanged() {
+void TextBoxRenderer::viewportChanged(int width, int height) {
+    bool valid = (width > 0) && (height > 0);
+    if (m_headless) {
+        if (valid) { setViewportSize(width, height); }
+        return;
+    }
+    if (m_raster) {
+        if (valid) { m_raster->resize(width, height); }
+        setViewportSize(m_raster->width(), m_raster->height());
+        return;
+    }
+    if (valid) { glViewport(0, 0, width, height); }
     GLint vp[4];
     glGetIntegerv(GL_VIEWPORT, vp);
-    m_vpWidth  = vp[2];
-    m_vpHeight = vp[3];
+    setViewportSize(vp[2], vp[3]);
+    if ((m_layerTexWidth != m_vpWidth) || (m_layerTexHeight != m_vpHeight)) {
+        freeLayerTarget();  // will be re-created in the new size on demand
+    }
+}
+
+void TextBoxRenderer::setViewportSize(int width, int height) {
+    m_vpWidth  = width;
+    m_vpHeight = height;
     m_vpScaleX =  2.0f / float(m_vpWidth);
     m_vpScaleY = -2.0f / float(m_vpHeight);
 }
 
+void TextBoxRenderer::clear(uint32_t color) {
+    if (m_headless) { return; }
+    if (m_raster) { m_raster->clear(color); return; }
+    glClearColor(float( color        & 0xFF) * float(1.f/255.f),
+                 float((color >>  8) & 0xFF) * float(1.f/255.f),
+                 float((color >> 16) & 0xFF) * float(1.f/255.f), 1.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TextBoxRenderer::setRenderScale(float scale) {
+    bool autoScale = (scale <= 0.0f);
+    if (autoScale != m_autoScale) {
+        m_autoScale = autoScale;
+        m_renderScale = 1.0f;
+        m_gpuTimeSum = m_frameTimeSum = 0.0f;
+        m_gpuFrames = m_frames = 0;
+    }
+    if (!autoScale) { m_renderScale = std::min(1.0f, std::max(minRenderScale, scale)); }
+}
+
+bool TextBoxRenderer::prepareLayerTarget() {
+    if (m_layerFBO) { return true; }
+    glGenTextures(1, &m_layerTex);
+    glBindTexture(GL_TEXTURE_2D, m_layerTex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_vpWidth, m_vpHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffers(1, &m_layerFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_layerFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_layerTex, 0);
+    bool ok = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!ok) {
+        Dprintf("WARNING: could not create %dx%d layer framebuffer, rendering at full resolution\n", m_vpWidth, m_vpHeight);
+        freeLayerTarget();
+        m_renderScale = 1.0f;
+        return false;
+    }
+    m_layerTexWidth  = m_vpWidth;
+    m_layerTexHeight = m_vpHeight;
+    addTextureSize(m_layerTex, size_t(m_vpWidth) * size_t(m_vpHeight) * 4u, false);
+    return true;
+}
+
+void TextBoxRenderer::freeLayerTarget() {
+    if (m_layerFBO) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &m_layerFBO);
+        m_layerFBO = 0;
+    }
+    freeTexture(m_layerTex);
+    m_layerTexWidth = m_layerTexHeight = 0;
+}
+
+void TextBoxRenderer::beginLayer(bool overlay) {
+    if (m_headless || m_raster || m_layerActive || (m_renderScale >= 1.0f) || !prepareLayerTarget()) { return; }
+    flush();
+    m_layerWidth  = std::max(1, int(float(m_vpWidth)  * m_renderScale + 0.5f));
+    m_layerHeight = std::max(1, int(float(m_vpHeight) * m_renderScale + 0.5f));
+    glBindFramebuffer(GL_FRAMEBUFFER, m_layerFBO);
+    glViewport(0, 0, m_layerWidth, m_layerHeight);
+    // the layer accumulates premultiplied color, with proper alpha
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    if (overlay) {
+        glClearColor(0.f, 0.f, 0.f, 0.f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    m_layerActive = true;
+}
+
+void TextBoxRenderer::endLayer() {
+    if (!m_layerActive) { return; }
+    flush();
+    m_layerActive = false;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, m_vpWidth, m_vpHeight);
+
+    // draw the used part of the layer texture over the whole screen
+    // (OpenGL textures are bottom-up, hence the flipped V coordinates)
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    useTexture(m_layerTex);
+    Vertex* v = newVertices(RenderMode::Texture, 0.f, 0.f, float(m_vpWidth), float(m_vpHeight),
+                            0.f, float(m_layerHeight) / float(m_layerTexHeight),
+                            float(m_layerWidth) / float(m_layerTexWidth), 0.f);
+    v[0].color = v[1].color = v[2].color = v[3].color = 0xFFFFFFFFu;
+    flush();
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    m_tex = 0;  // don't keep the layer texture bound while drawing into it
+}
+
+void TextBoxRenderer::beginFrame() {
+    if (m_headless || m_raster || !m_autoScale || (m_queryCount >= NumTimerQueries)) { return; }
+    glBeginQuery(GL_TIME_ELAPSED, m_timerQueries[(m_queryHead + m_queryCount) % NumTimerQueries]);
+    m_timing = true;
+}
+
+void TextBoxRenderer::endFrame(float frameTime) {
+    if (m_timing) {
+        glEndQuery(GL_TIME_ELAPSED);
+        m_timing = false;
+        ++m_queryCount;
+    }
+    // collect the results of earlier frames without stalling
+    while (m_queryCount > 0) {
+        GLuint available = 0;
+        glGetQueryObjectuiv(m_timerQueries[m_queryHead], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) { break; }
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(m_timerQueries[m_queryHead], GL_QUERY_RESULT, &ns);
+        m_queryHead = (m_queryHead + 1) % NumTimerQueries;
+        --m_queryCount;
+        m_gpuTime = float(double(ns) * 1.0E-9);
+        m_gpuTimeSum += m_gpuTime;
+        ++m_gpuFrames;
+    }
+    if (m_autoScale && (frameTime > 0.0f)) { updateAutoScale(frameTime); }
+}
+
+void TextBoxRenderer::updateAutoScale(float frameTime) {
+    m_frameTimeSum += frameTime;
+    if ((++m_frames < autoScaleInterval) || (m_gpuFrames < 1)) { return; }
+    float gpuTime = m_gpuTimeSum / float(m_gpuFrames);
+    float frameTimeAvg = m_frameTimeSum / float(m_frames);
+    m_gpuTimeSum = m_frameTimeSum = 0.0f;
+    m_gpuFrames = m_frames = 0;
+
+    // the cost of the layers is roughly proportional to their area
+    float scale = m_renderScale;
+    if ((gpuTime > autoScaleDownAt * frameTimeAvg) && (scale > minAutoScale)) {
+        scale = std::max(minAutoScale, scale - autoScaleStep);
+    } else if (scale < 1.0f) {
+        float next = std::min(1.0f, scale + autoScaleStep);
+        if ((gpuTime * (next * next) / (scale * scale)) < (autoScaleUpAt * frameTimeAvg)) { scale = next; }
+    }
+    if (scale != m_renderScale) {
+        Dprintf("GPU time %.2f ms at %.2f ms frame period -> render scale %.3f\n",
+                double(gpuTime) * 1.0E3, double(frameTimeAvg) * 1.0E3, double(scale));
+        m_renderScale = scale;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void TextBoxRenderer::flush() {
     if (m_quadCount < 1) { return; }
+    m_quadsEmitted += uint64_t(m_quadCount);
+    if (m_headless) {
+        // still determine the runs, to get realistic draw call statistics
+        m_drawCalls += uint64_t(buildRuns());
+        m_quadCount = 0;
+        return;
+    }
 
-    if (m_vertices) {
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    if (m_raster) {
+        // convert back from NDC into pixel coordinates
+        for (const Vertex* v = m_vertices;  v < &m_vertices[4 * m_quadCount];  v += 4) {
+            SoftwareRasterizer::Quad q;
+            q.x0 = (v[0].pos[0] + 1.0f) / m_vpScaleX;  q.y0 = (v[0].pos[1] - 1.0f) / m_vpScaleY;
+            q.x1 = (v[3].pos[0] + 1.0f) / m_vpScaleX;  q.y1 = (v[3].pos[1] - 1.0f) / m_vpScaleY;
+            q.u0 = v[0].tc[0];  q.v0 = v[0].tc[1];
+            q.u1 = v[3].tc[0];  q.v1 = v[3].tc[1];
+            q.size[0] = v[0].size[0];  q.size[1] = v[0].size[1];  q.size[2] = v[0].size[2];
+            q.br[0] = v[0].br[0];  q.br[1] = v[0].br[1];
+            for (int i = 0;  i < 4;  ++i) { q.color[i] = v[i].color; }
+            q.tex = m_tex;
+            q.mode = uint8_t(v[0].mode);
+            m_raster->addQuad(q);
+        }
+        m_quadCount = 0;
+        return;
+    }
+
+    // upload the quads, sorted by run
+    int numRuns = buildRuns();
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    Vertex* dest = static_cast<Vertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, m_quadCount * 4 * sizeof(Vertex), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (dest) {
+        for (int quad = 0;  quad < m_quadCount;  ++quad) {
+            Run& run = m_runs[m_quadRun[quad]];
+            std::copy(&m_vertices[quad * 4], &m_vertices[quad * 4 + 4], &dest[(run.start + run.count++) * 4]);
+        }
         glUnmapBuffer(GL_ARRAY_BUFFER);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        m_vertices = nullptr;
     }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+    // draw each run with the shader specialized for its mode
     glBindTexture(GL_TEXTURE_2D, m_tex);
     glBindVertexArray(m_vao);
-    glUseProgram(m_prog);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
-    glDrawElements(GL_TRIANGLES, m_quadCount * 6, GL_UNSIGNED_SHORT, nullptr);
+    for (const Run* run = m_runs;  dest && (run < &m_runs[numRuns]);  ++run) {
+        glUseProgram(m_prog[run->mode]);
+        glDrawElements(GL_TRIANGLES, run->count * 6, GL_UNSIGNED_SHORT,
+                       reinterpret_cast<const void*>(uintptr_t(run->start) * 6u * sizeof(uint16_t)));
+    }
+    m_drawCalls += uint64_t(numRuns);
     glFinish();
     m_quadCount = 0;
 }
 
+int TextBoxRenderer::buildRuns() {
+    // Group the quads into runs of the same mode. A quad may join an earlier
+    // run instead of the last one if it doesn't overlap any of the runs in
+    // between, as the blending order doesn't matter then.
+    int numRuns = 0;
+    for (int quad = 0;  quad < m_quadCount;  ++quad) {
+        const Vertex* v = &m_vertices[quad * 4];
+        uint8_t mode = uint8_t(v[0].mode);
+        float x0 = std::min(v[0].pos[0], v[3].pos[0]), x1 = std::max(v[0].pos[0], v[3].pos[0]);
+        float y0 = std::min(v[0].pos[1], v[3].pos[1]), y1 = std::max(v[0].pos[1], v[3].pos[1]);
+        int target = -1;
+        for (int r = numRuns - 1;  r >= std::max(0, numRuns - runLookback);  --r) {
+            const Run& run = m_runs[r];
+            if (run.mode == mode) { target = r;  break; }
+            if ((x0 < run.x1) && (x1 > run.x0) && (y0 < run.y1) && (y1 > run.y0)) { break; }
+        }
+        if (target < 0) {
+            target = numRuns++;
+            Run& run = m_runs[target];
+            run.x0 = x0;  run.y0 = y0;  run.x1 = x1;  run.y1 = y1;
+            run.count = 0;
+            run.mode = mode;
+        }
+        Run& run = m_runs[target];
+        run.x0 = std::min(run.x0, x0);  run.y0 = std::min(run.y0, y0);
+        run.x1 = std::max(run.x1, x1);  run.y1 = std::max(run.y1, y1);
+        ++run.count;
+        m_quadRun[quad] = uint16_t(target);
+    }
+    // assign buffer positions; the counts are re-used as fill pointers
+    int start = 0;
+    for (Run* run = m_runs;  run < &m_runs[numRuns];  ++run) {
+        run->start = start;
+        start += run->count;
+        run->count = 0;
+    }
+    return numRuns;
+}
+
 void TextBoxRenderer::shutdown() {
+    freeRuntimeFont();
+    if (m_headless || m_raster) {
+        if (m_raster) { freeTexture(m_fontTex); }
+        freeBuffers();
+        return;
+    }
+    if (m_timing) { glEndQuery(GL_TIME_ELAPSED);  m_timing = false; }
+    glDeleteQueries(NumTimerQueries, m_timerQueries);
+    freeLayerTarget();
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, 0);
     freeTexture(m_fontTex);
     glBindSampler(1, 0);                       glDeleteSamplers(1, &m_sampler);
     glBindBuffer(GL_ARRAY_BUFFER, 0);          glDeleteBuffers(1, &m_vbo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);  glDeleteBuffers(1, &m_ibo);
-    glUseProgram(0);                           glDeleteProgram(m_prog);
+    glUseProgram(0);
+    for (unsigned prog : m_prog) { glDeleteProgram(prog); }
     glBindVertexArray(0);                      glDeleteVertexArrays(1, &m_vao);
     glActiveTexture(GL_TEXTURE0);
+    freeBuffers();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 TextBoxRenderer::Vertex* TextBoxRenderer::newVertices() {
     if (m_quadCount >= BatchSize) { flush(); }
-    if (!m_vertices) {
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-        m_vertices = (Vertex*) glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }
     return &m_vertices[4 * (m_quadCount++)];
 }
 
@@ -404,10 +758,39 @@ void TextBoxRenderer::outlineBox(int x0, int y0, int x1, int y1, uint32_t colorU
         colorUpper | 0xFF000000u, colorLower | 0xFF000000u, false, borderRadius - cInner);
 }
 
+void TextBoxRenderer::addOccluder(int x0, int y0, int x1, int y1) {
+    if ((m_numOccluders < MaxOccluders) && (x1 > x0) && (y1 > y0)) {
+        m_occluders[m_numOccluders++] = { x0, y0, x1, y1 };
+    }
+}
+
 void TextBoxRenderer::texturedRect(uint8_t mode, int x0, int y0, int x1, int y1, uint32_t color, unsigned texID) {
-    if (!texID || !(color & 0xFF000000u)) { return; }
+    if (!texID || !(color & 0xFF000000u) || (x1 <= x0) || (y1 <= y0)) { return; }
+
+    // cut away the parts that are hidden by occluders; only occluders that
+    // span the full width or height of the rectangle can do that, and the
+    // rectangle may shrink to span one fully after being cut by another,
+    // hence the second pass
+    int cx0 = x0, cy0 = y0, cx1 = x1, cy1 = y1;
+    for (int pass = 0;  pass < 2;  ++pass) {
+        for (const Occluder* o = m_occluders;  o < &m_occluders[m_numOccluders];  ++o) {
+            if ((o->x0 <= cx0) && (o->x1 >= cx1)) {
+                if      (o->y0 <= cy0) { cy0 = std::max(cy0, o->y1 - occluderMargin); }
+                else if (o->y1 >= cy1) { cy1 = std::min(cy1, o->y0 + occluderMargin); }
+            }
+            if ((o->y0 <= cy0) && (o->y1 >= cy1)) {
+                if      (o->x0 <= cx0) { cx0 = std::max(cx0, o->x1 - occluderMargin); }
+                else if (o->x1 >= cx1) { cx1 = std::min(cx1, o->x0 + occluderMargin); }
+            }
+            if ((cx0 >= cx1) || (cy0 >= cy1)) { return; }
+        }
+    }
+
     useTexture(texID);
-    Vertex* v = newVertices(mode, float(x0), float(y0), float(x1), float(y1), 0.f, 0.f, 1.f, 1.f);
+    float su = 1.0f / float(x1 - x0), sv = 1.0f / float(y1 - y0);
+    Vertex* v = newVertices(mode, float(cx0), float(cy0), float(cx1), float(cy1),
+                            float(cx0 - x0) * su, float(cy0 - y0) * sv,
+                            float(cx1 - x0) * su, float(cy1 - y0) * sv);
     v[0].color = v[1].color = v[2].color = v[3].color = color;
     v[0].br[0] = v[1].br[0] = v[2].br[0] = v[3].br[0] = 0.5f;
     v[0].br[1] = v[1].br[1] = v[2].br[1] = v[3].br[1] = -1.0f;
@@ -425,6 +808,32 @@ void TextBoxRenderer::bitmap(int x0, int y0, int x1, int y1, unsigned texID) {
 
 const char* TextBoxRenderer::setFont(const char* name) {
     if (!name) { name = ""; }
+
+    // font file?
+    if (RuntimeFont::isFontFile(name)) {
+        if (!m_runtimeFont || (m_runtimeFont->path() != name)) {
+            freeRuntimeFont();
+            m_runtimeFont = new RuntimeFont;
+            const char* error = m_runtimeFont->load(name, m_fontCacheDir);
+            if (!error && !m_headless) {
+                m_runtimeFontTex = createTexture(m_runtimeFont->atlas(), m_runtimeFont->atlasWidth(), m_runtimeFont->atlasHeight(), 3, true);
+                if (!m_runtimeFontTex) { error = "failed to create font texture"; }
+            }
+            if (error) {
+                Dprintf("WARNING: could not load font file '%s': %s\n", name, error);
+                (void)error;  // not used in Release builds
+                freeRuntimeFont();
+            }
+        }
+        if (m_runtimeFont) {
+            m_currentFont = &m_runtimeFont->font();
+            m_currentFontTex = m_headless ? m_fontTex : m_runtimeFontTex;
+            return m_currentFont->name;
+        }
+        name = "";  // fall back to the default font
+    }
+
+    // built-in font
     int matchLen = -1;
     for (const auto* font = FontData::Fonts;  font->name;  ++font) {
         int l = 0;
@@ -434,9 +843,41 @@ const char* TextBoxRenderer::setFont(const char* name) {
             matchLen = l;
         }
     }
+    m_currentFontTex = m_fontTex;
     return m_currentFont->name;
 }
 
+bool TextBoxRenderer::updateFont() {
+    if (!m_runtimeFont || !m_runtimeFont->pending()) { return false; }
+    if (m_tex == m_runtimeFontTex) { flush();  m_tex = 0; }  // queued text still refers to the old atlas
+    m_runtimeFont->update();
+    if (!m_headless) {
+        freeTexture(m_runtimeFontTex);
+        m_runtimeFontTex = createTexture(m_runtimeFont->atlas(), m_runtimeFont->atlasWidth(), m_runtimeFont->atlasHeight(), 3, true);
+        if (!m_runtimeFontTex) {
+            Dprintf("WARNING: failed to re-create font texture, using the default font\n");
+            freeRuntimeFont();
+            return true;
+        }
+    }
+    if (m_currentFont == &m_runtimeFont->font()) {
+        m_currentFontTex = m_headless ? m_fontTex : m_runtimeFontTex;
+    }
+    return true;
+}
+
+void TextBoxRenderer::freeRuntimeFont() {
+    if (!m_runtimeFont) { return; }
+    if (m_currentFont == &m_runtimeFont->font()) {
+        m_currentFont = &FontData::Fonts[0];
+        m_currentFontTex = m_fontTex;
+    }
+    if (m_tex == m_runtimeFontTex) { flush();  m_tex = 0; }
+    freeTexture(m_runtimeFontTex);
+    delete m_runtimeFont;
+    m_runtimeFont = nullptr;
+}
+
 const FontData::Glyph* TextBoxRenderer::getGlyph(uint32_t codepoint) const {
     if (!codepoint) { return nullptr; }
 
@@ -445,8 +886,8 @@ const FontData::Glyph* TextBoxRenderer::getGlyph(uint32_t codepoint) const {
 
     // most characters are ASCII, and those are usually the first ones in the
     // glyph list anyway, so we may have a direct hit
-    int quickIndex = codepoint - m_currentFont->glyphs[0].codepoint;
-    if ((quickIndex < m_currentFont->numGlyphs)
+    int quickIndex = int(codepoint - m_currentFont->glyphs[0].codepoint);
+    if ((quickIndex >= 0) && (quickIndex < m_currentFont->numGlyphs)
     && (m_currentFont->glyphs[quickIndex].codepoint == codepoint)) {
         return &m_currentFont->glyphs[quickIndex];
     }
@@ -460,11 +901,15 @@ const FontData::Glyph* TextBoxRenderer::getGlyph(uint32_t codepoint) const {
         if (m_currentFont->glyphs[c].codepoint > codepoint) { b = c; } else { a = c; }
     }
     if (m_currentFont->glyphs[a].codepoint == codepoint) { foundIndex = a; }
-    return &m_currentFont->glyphs[(foundIndex < 0) ? m_currentFont->fallbackIndex : foundIndex];
+    if (foundIndex >= 0) { return &m_currentFont->glyphs[foundIndex]; }
+
+    // glyphs that are missing from a font file's atlas may be generated later
+    if (m_runtimeFont && (m_currentFont == &m_runtimeFont->font())) { m_runtimeFont->request(codepoint); }
+    return &m_currentFont->glyphs[m_currentFont->fallbackIndex];
 }
 
-uint32_t TextBoxRenderer::nextCodepoint(const char* &utf8string) {
-    if (!utf8string || !utf8string[0]) { return 0u; }
+uint32_t TextBoxRenderer::nextCodepoint(const char* &utf8string, const char* end) {
+    if (!utf8string || (end && (utf8string >= end)) || !utf8string[0]) { return 0u; }
     uint32_t cp = uint8_t(*utf8string++);
     if      (cp < 0x80) { return cp; }      // 7-bit ASCII byte
     else if (cp < 0xC0) { return 0xFFFD; }  // unexpected continuation byte
@@ -474,6 +919,7 @@ uint32_t TextBoxRenderer::nextCodepoint(const char* &utf8string) {
     else if (cp < 0xF8) { ecb = 3;  cp &= 0x07; }
     else { return 0xFFFD; }  // invalid UTF-8 sequence
     while (ecb--) {
+        if (end && (utf8string >= end)) { return 0xFFFD; }  // sequence truncated by the end pointer
         uint8_t byte = uint8_t(*utf8string);
         if ((byte & 0xC0) != 0x80) { return 0xFFFD; }  // truncated UTF-8 sequence; keep the offending byte
         ++utf8string;  // *now* consume the byte
@@ -486,17 +932,17 @@ int   TextBoxRenderer::textSizeGranularity() const { return m_currentFont->bitma
 float TextBoxRenderer::textBaseline()        const { return m_currentFont->baseline; }
 float TextBoxRenderer::textNumberHeight()    const { return m_currentFont->numberHeight; }
 
-float TextBoxRenderer::textWidth(const char* text) const {
+float TextBoxRenderer::textWidth(const char* text, const char* textEnd) const {
     float w = 0.0f;
     const FontData::Glyph* g;
-    while ((g = getGlyph(nextCodepoint(text))) != 0u) { w += g->advance; }
+    while ((g = getGlyph(nextCodepoint(text, textEnd))) != 0u) { w += g->advance; }
     return w;
 }
 
-void TextBoxRenderer::alignText(float &x, float &y, float size, const char* text, uint8_t align) {
+void TextBoxRenderer::alignText(float &x, float &y, float size, const char* text, const char* textEnd, uint8_t align) {
     switch (align & Align::HMask) {
-        case Align::Center:   x -= size * textWidth(text) * 0.5f; break;
-        case Align::Right:    x -= size * textWidth(text);        break;
+        case Align::Center:   x -= size * textWidth(text, textEnd) * 0.5f; break;
+        case Align::Right:    x -= size * textWidth(text, textEnd);        break;
         default: break;
     }
     switch (align & Align::VMask) {
@@ -511,12 +957,12 @@ void TextBoxRenderer::alignText(float &x, float &y, float size, const char* text
     }
 }
 
-float TextBoxRenderer::text(float x, float y, float size, const char* text, uint8_t align, uint32_t colorUpper, uint32_t colorLower, float blur, float offset) {
-    useTexture(m_fontTex);
-    alignText(x, y, size, text, align);
+float TextBoxRenderer::drawText(float x, float y, float size, const char* text, const char* textEnd, uint8_t align, uint32_t colorUpper, uint32_t colorLower, float blur, float offset) {
+    useTexture(m_currentFontTex);
+    alignText(x, y, size, text, textEnd, align);
     const FontData::Glyph* g;
     bool msdf = !m_currentFont->bitmapHeight;
-    while ((g = getGlyph(nextCodepoint(text))) != 0u) {
+    while ((g = getGlyph(nextCodepoint(text, textEnd))) != 0u) {
         if (!g->space) {
             float aaSizeFactor = std::min(1.0f, 10.0f / size) / size;
             Vertex* v = newVertices(msdf ? RenderMode::MSDFText : RenderMode::BitmapText,
@@ -539,7 +985,7 @@ float TextBoxRenderer::text(float x, float y, float size, const char* text, uint
 }
 
 float TextBoxRenderer::outlineText(float x, float y, float size, const char* text, uint8_t align, uint32_t colorUpper, uint32_t colorLower, uint32_t colorOutline, float outlineWidth, int shadowOffset, float shadowBlur, float shadowAlpha, float shadowGrow) {
-    alignText(x, y, size, text, align);
+    alignText(x, y, size, text, nullptr, align);
     if ((shadowOffset || (shadowGrow >= 0.0f)) && (shadowAlpha > 0.0f)) {
         uint32_t shadowColor = makeAlpha(shadowAlpha);
         this->text(x + float(shadowOffset), y + float(shadowOffset), size, text, 0, shadowColor, shadowColor, shadowBlur + 1.0f, -shadowGrow);
@@ -6,9 +6,14 @@
 #include <cstdint>
 
 #include <algorithm>
+#include <string>
+#include <string_view>
 
 #include "font_data.h"
 
+class SoftwareRasterizer;
+class RuntimeFont;
+
 //! text alignment constants
 namespace Align {
     constexpr uint8_t Left     = 0x00;  //!< horizontally left-aligned
@@ -22,6 +27,16 @@ namespace Align {
     constexpr uint8_t VMask    = 0xF0;  //!< \private vertical alignment mask
 }
 
+//! quad render modes (shared with the software rasterizer)
+namespace RenderMode {
+    constexpr uint8_t Box        = 0;  //!< rounded box
+    constexpr uint8_t MSDFText   = 1;  //!< MSDF text glyph
+    constexpr uint8_t Logo       = 2;  //!< single-channel texture, used as coverage
+    constexpr uint8_t BitmapText = 3;  //!< bitmap text glyph
+    constexpr uint8_t Texture    = 4;  //!< plain RGB(A) texture
+    constexpr uint8_t Count      = 5;  //!< \private number of render modes
+}
+
 //! a renderer that can draw two things: MSDF text, or rounded boxes
 class TextBoxRenderer {
     const char* m_error = nullptr;
@@ -31,12 +46,37 @@ class TextBoxRenderer {
     unsigned m_sampler;
     unsigned m_vbo;
     unsigned m_ibo;
-    unsigned m_prog;
-    unsigned m_locInvAlphaGamma;
+    unsigned m_prog[RenderMode::Count];              // one specialized shader program per mode
+    unsigned m_locInvAlphaGamma[RenderMode::Count];
     unsigned m_tex;
     unsigned m_fontTex;
     const FontData::Font *m_currentFont;
+    unsigned m_currentFontTex = 0;           // atlas of the current font
+    RuntimeFont* m_runtimeFont = nullptr;    // font loaded from a file, if any
+    unsigned m_runtimeFontTex = 0;
+    std::string m_fontCacheDir;
     int m_quadCount;
+    bool m_headless = false;
+    SoftwareRasterizer* m_raster = nullptr;
+    uint64_t m_quadsEmitted = 0;
+
+    // reduced-resolution layers
+    unsigned m_layerFBO = 0;
+    unsigned m_layerTex = 0;
+    int m_layerTexWidth = 0, m_layerTexHeight = 0;  // allocated size (= viewport size)
+    int m_layerWidth = 0, m_layerHeight = 0;        // used size in the current layer
+    bool m_layerActive = false;
+    float m_renderScale = 1.0f;
+    bool m_autoScale = false;
+
+    // GPU frame time measurement for automatic render scale
+    static constexpr int NumTimerQueries = 4;
+    unsigned m_timerQueries[NumTimerQueries] = { 0 };
+    int m_queryHead = 0, m_queryCount = 0;
+    bool m_timing = false;
+    float m_gpuTime = 0.0f;
+    float m_gpuTimeSum = 0.0f, m_frameTimeSum = 0.0f;
+    int m_gpuFrames = 0, m_frames = 0;
 
     struct Vertex {
         float pos[2];    // screen position (already transformed into NDC)
@@ -47,35 +87,106 @@ class TextBoxRenderer {
         uint32_t mode;   // 0 = box, 1 = text
     };
 
-    Vertex* m_vertices;
+    Vertex* m_vertices = nullptr;
+
+    // a run of quads with the same mode that is drawn in a single call
+    struct Run {
+        float x0, y0, x1, y1;  // bounding box (in NDC)
+        int start, count;      // position in the vertex buffer, in quads
+        uint8_t mode;
+    };
+    Run* m_runs = nullptr;          // BatchSize entries
+    uint16_t* m_quadRun = nullptr;  // run index of each quad; BatchSize entries
+    uint64_t m_drawCalls = 0;
+
+    // opaque areas that hide textured rectangles drawn before them
+    static constexpr int MaxOccluders = 4;
+    struct Occluder { int x0, y0, x1, y1; };
+    Occluder m_occluders[MaxOccluders];
+    int m_numOccluders = 0;
 
     Vertex* newVertices();
     Vertex* newVertices(uint8_t mode, float x0, float y0, float x1, float y1);
     Vertex* newVertices(uint8_t mode, float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1);
 
     const FontData::Glyph* getGlyph(uint32_t codepoint) const;
-    void alignText(float &x, float &y, float size, const char* text, uint8_t align);
+    void alignText(float &x, float &y, float size, const char* text, const char* textEnd, uint8_t align);
+    float drawText(float x, float y, float size, const char* text, const char* textEnd,
+                   uint8_t align, uint32_t colorUpper, uint32_t colorLower, float blur, float offset);
 
     inline void useTexture(unsigned texID)
         { if (texID && (texID != m_tex)) { flush(); m_tex = texID; } }
 
     void texturedRect(uint8_t mode, int x0, int y0, int x1, int y1, uint32_t color, unsigned texID);
+    void setViewportSize(int width, int height);
+    bool allocBuffers();
+    void freeBuffers();
+    int buildRuns();
+    bool prepareLayerTarget();
+    void freeLayerTarget();
+    void updateAutoScale(float frameTime);
+    void freeRuntimeFont();
 
 public:
     bool init();
+    //! initialize without an OpenGL context; all geometry is generated
+    //! as usual, but discarded (and only counted) on flush()
+    bool initHeadless(int width, int height);
+    //! initialize without an OpenGL context, drawing with a CPU rasterizer
+    //! instead; textures are created in that rasterizer from then on
+    bool initSoftware(SoftwareRasterizer* raster);
     void shutdown();
-    void viewportChanged();
+    //! update the viewport size; in OpenGL mode, this also sets OpenGL's
+    //! viewport, or just reads it back if no size is specified
+    void viewportChanged(int width=0, int height=0);
     void flush();
     void setAlphaGamma(float gamma);
+    //! clear the whole screen (or the current layer)
+    void clear(uint32_t color);
+
+    //! set the resolution of layers, relative to the viewport size
+    //! (0 = automatic, based on the measured GPU frame time)
+    void setRenderScale(float scale);
+    //! redirect all following drawing into an offscreen layer at reduced
+    //! resolution; overlay layers start out transparent, otherwise clear()
+    //! is expected to be the first drawing command;
+    //! does nothing if the render scale is 1
+    void beginLayer(bool overlay);
+    //! finish the current layer and upsample it onto the screen
+    void endLayer();
+    //! start measuring the GPU time of a frame
+    void beginFrame();
+    //! finish measuring the GPU time of a frame, and adjust the render scale
+    //! if it's automatic; frameTime is the actual frame period, in seconds
+    void endFrame(float frameTime);
 
     inline const char* error()  const { return m_error; }
     inline int viewportWidth()  const { return m_vpWidth; }
     inline int viewportHeight() const { return m_vpHeight; }
+    inline bool headless()      const { return m_headless; }
+    inline bool software()      const { return m_raster != nullptr; }
+    inline float renderScale()  const { return m_renderScale; }
+    //! most recently measured GPU time of a frame, in seconds
+    //! (only measured if the render scale is automatic)
+    inline float gpuTime()      const { return m_gpuTime; }
+    //! total number of quads that have been flushed since initialization
+    inline uint64_t quadsEmitted() const { return m_quadsEmitted; }
+    //! total number of OpenGL draw calls since initialization
+    inline uint64_t drawCalls()    const { return m_drawCalls; }
+
+    //! declare that a rectangle will be covered by something opaque later
+    //! in the frame; the parts of logos and bitmaps below it won't be drawn
+    void addOccluder(int x0, int y0, int x1, int y1);
+    inline void clearOccluders() { m_numOccluders = 0; }
 
     struct TextureDimensions { int width, height; };
+    //! create a texture from 8-bit pixel data with 1 to 4 channels
+    static unsigned createTexture(const uint8_t* pixels, int width, int height, int channels, bool mipmap);
     static unsigned loadTexture(const void* pngData, size_t pngSize, int channels, bool mipmap, TextureDimensions* dims=nullptr);
     static unsigned loadTexture(const char* filename, int channels, bool mipmap, TextureDimensions* dims=nullptr);
     static void freeTexture(unsigned &texID);
+    //! estimated total size of all textures loaded with loadTexture(), in bytes
+    static size_t textureMemory();
 
     void box(int x0, int y0, int x1, int y1,
              uint32_t colorUpperLeft, uint32_t colorLowerRight,
@@ -97,20 +208,42 @@ public:
     inline void circle(int x, int y, int r, uint32_t color, float blur=1.0f, float offset=0.0f)
         { box(x - r, y - r, x + r, y + r, color, color, false, r, blur, offset); }
 
+    //! select a built-in font (by name prefix) or a TrueType font file
+    //! \returns the name of the font that's actually used
     const char* setFont(const char* name);
+    //! set the directory where generated glyphs of font files are cached
+    inline void setFontCacheDir(const std::string& dir) { m_fontCacheDir = dir; }
+    //! generate glyphs that have been missing from a font file's atlas
+    //! so far; should be called at the start of a frame
+    //! \returns true if the font metrics may have changed
+    bool updateFont();
 
     int textSizeGranularity() const;
     float textBaseline() const;
     float textNumberHeight() const;
-    float textWidth(const char* text) const;
-    float text(float x, float y, float size, const char* text,
+    //! determine the width of a text (optionally ending at textEnd instead of the null terminator)
+    float textWidth(const char* text, const char* textEnd=nullptr) const;
+    inline float textWidth(std::string_view text) const
+        { return textWidth(text.data(), text.data() + text.size()); }
+    inline float text(float x, float y, float size, const char* text,
               uint8_t align,
               uint32_t colorUpper, uint32_t colorLower,
-              float blur=1.0f, float offset=0.0f);
+              float blur=1.0f, float offset=0.0f)
+              { return drawText(x, y, size, text, nullptr, align, colorUpper, colorLower, blur, offset); }
     inline float text(float x, float y, float size, const char* text,
               uint8_t align = Align::Left + Align::Top,
               uint32_t color=0xFFFFFFFF)
-              { return this->text(x, y, size, text, align, color, color); }
+              { return drawText(x, y, size, text, nullptr, align, color, color, 1.0f, 0.0f); }
+    //! draw length-delimited text (e.g. a substring, without allocating a copy)
+    inline float text(float x, float y, float size, std::string_view text,
+              uint8_t align,
+              uint32_t colorUpper, uint32_t colorLower,
+              float blur=1.0f, float offset=0.0f)
+              { return drawText(x, y, size, text.data(), text.data() + text.size(), align, colorUpper, colorLower, blur, offset); }
+    inline float text(float x, float y, float size, std::string_view text,
+              uint8_t align = Align::Left + Align::Top,
+              uint32_t color=0xFFFFFFFF)
+              { return drawText(x, y, size, text.data(), text.data() + text.size(), align, color, color, 1.0f, 0.0f); }
 
     float outlineText(float x, float y, float size, const char* text,
                      uint8_t align = Align::Left + Align::Top,
@@ -128,7 +261,9 @@ public:
                 uint32_t textColor=0xFFFFFFFF, uint32_t backgroundColor=0xFF000000);
 
     // helper functions
-    static uint32_t nextCodepoint(const char* &utf8string);
+    //! decode the next UTF-8 codepoint and advance the string pointer;
+    //! returns 0 at the null terminator or when reaching 'end' (if not null)
+    static uint32_t nextCodepoint(const char* &utf8string, const char* end=nullptr);
     static inline uint32_t makeAlpha(float alpha)
         { return uint32_t(std::min(1.f, std::max(0.f, alpha)) * 255.f + .5f) << 24; }
     static inline uint32_t extraAlpha(uint32_t color, float alpha)
@@ -0,0 +1,247 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include <libopenmpt/libopenmpt.hpp>
+#include <libopenmpt/libopenmpt_ext.hpp>
+
+#include "util.h"
+#include "trace.h"
+#include "config.h"
+#include "modutil.h"
+#include "scopes.h"
+
+constexpr size_t renderBufferSize = 1024;  // in samples
+constexpr float loadHigh = 0.5f;           // lower the sample rate if the busiest worker spends more time rendering
+constexpr float loadLow = 0.15f;           // raise the sample rate (or split the channel groups) again if all workers spend less time rendering
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// main thread interface
+
+bool ChannelScopes::start(const std::string& path, int numChannels) {
+    stop();
+    if ((numChannels < 1) || ModUtil::loadFile(path.c_str(), m_data)) {
+        std::vector<std::byte>().swap(m_data);
+        return false;
+    }
+    m_numChannels = numChannels;
+    m_requestSeq = m_resultSeq = m_frontSeq = 0u;
+    m_sampleRate = MaxSampleRate;
+
+    // start with the smallest channel groups that don't exceed the
+    // instance limit
+    int groupSize = 1;
+    while (((numChannels + groupSize - 1) / groupSize) > MaxInstances) { groupSize <<= 1; }
+    startWorkers(groupSize);
+    return true;
+}
+
+void ChannelScopes::stop() {
+    if (!active()) { return; }
+    stopWorkers();
+    std::vector<std::byte>().swap(m_data);
+    m_numChannels = 0;
+    m_groupSize = 0;
+    m_frontSeq = 0u;
+}
+
+void ChannelScopes::startWorkers(int groupSize) {
+    m_groupSize = groupSize;
+    int numScopes = this->numScopes();
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_shared.assign(size_t(numScopes) * WindowSize, 0.0f);
+    }
+    m_front.assign(size_t(numScopes) * WindowSize, 0.0f);
+    m_quit = false;
+    m_rateCooldown = 60;
+
+    // one worker per spare CPU core (the main and audio threads need theirs),
+    // but not more than there are scopes; scopes are distributed round-robin
+    int threads = std::clamp(int(std::thread::hardware_concurrency()) - 2, 1, numScopes);
+    Dprintf("starting channel scopes: %d channels in groups of %d on %d worker threads\n", m_numChannels, groupSize, threads);
+    for (int t = 0;  t < threads;  ++t) {
+        Worker* w = new Worker;
+        for (int s = t;  s < numScopes;  s += threads) { w->scopes.push_back(s); }
+        w->times.assign(w->scopes.size(), -1.0);
+        w->history.assign(w->scopes.size() * WindowSize, 0.0f);
+        w->buffer.resize(renderBufferSize);
+        m_workers.push_back(w);
+    }
+    for (auto w : m_workers) {
+        w->thread = new std::thread(&ChannelScopes::run, this, w);
+    }
+}
+
+void ChannelScopes::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_quit = true;
+    }
+    m_wakeup.notify_all();
+    for (auto w : m_workers) {
+        w->thread->join();
+        delete w->thread;
+        for (auto mod : w->mods) { delete mod; }
+        delete w;
+    }
+    m_workers.clear();
+}
+
+void ChannelScopes::update(double position) {
+    if (!active()) { return; }
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_target = position;
+        ++m_requestSeq;
+    }
+    m_wakeup.notify_all();
+
+    // adapt the sample rate and the number of instances to the available
+    // CPU time; when overloaded, the sample rate goes first, when there's
+    // headroom, it comes back first
+    if (m_rateCooldown > 0) { --m_rateCooldown; return; }
+    float load = 0.0f;
+    for (auto w : m_workers) {
+        float l = w->load.load(std::memory_order_relaxed);
+        if (l < 0.0f) { return; }  // still creating instances
+        load = std::max(load, l);
+    }
+    int rate = sampleRate();
+    if ((load > loadHigh) && (rate > MinSampleRate)) {
+        m_sampleRate = std::max(MinSampleRate, rate >> 1);
+        m_rateCooldown = 30;
+        Dprintf("channel scopes overloaded (%.0f%%), reducing sample rate to %d Hz\n", load * 100.0f, sampleRate());
+    } else if ((load > loadHigh) && (m_groupSize < m_numChannels)) {
+        Dprintf("channel scopes overloaded (%.0f%%) at minimum sample rate, merging channel groups\n", load * 100.0f);
+        stopWorkers();
+        startWorkers(m_groupSize << 1);
+    } else if ((load < loadLow) && (rate < MaxSampleRate)) {
+        m_sampleRate = std::min(MaxSampleRate, rate << 1);
+        m_rateCooldown = 120;
+        Dprintf("channel scopes have headroom (%.0f%%), increasing sample rate to %d Hz\n", load * 100.0f, sampleRate());
+    } else if ((load < loadLow) && (m_groupSize > 1) && (((m_numChannels + (m_groupSize >> 1) - 1) / (m_groupSize >> 1)) <= MaxInstances)) {
+        Dprintf("channel scopes have headroom (%.0f%%), splitting channel groups\n", load * 100.0f);
+        stopWorkers();
+        startWorkers(m_groupSize >> 1);
+        m_rateCooldown = 120;
+    }
+}
+
+const float* ChannelScopes::windows() {
+    if (!active()) { return nullptr; }
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_resultSeq != m_frontSeq) {
+        std::copy(m_shared.begin(), m_shared.end(), m_front.begin());
+        m_frontSeq = m_resultSeq;
+    }
+    return m_frontSeq ? m_front.data() : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// worker threads
+
+void ChannelScopes::run(Worker* w) {
+    Trace::setThreadName("scopes");
+
+    // create the instances, one per channel group; this can take a while for
+    // large modules, so don't hold up stop() until all of them are done
+    {
+        TRACE_SCOPE("scopes: create instances");
+        Config config;
+        config.filter = FilterMethod::None;  // cheapest resampler; good enough for the scopes
+        for (int s : w->scopes) {
+            if (m_quit.load()) { return; }
+            int first = s * m_groupSize;
+            int last = std::min(first + m_groupSize, m_numChannels);
+            std::string error;
+            openmpt::module* mod = ModUtil::createModule(m_data, config, false, error);
+            auto ext = static_cast<openmpt::module_ext*>(mod);
+            auto ia = ext ? static_cast<openmpt::ext::interactive*>(ext->get_interface(openmpt::ext::interactive_id)) : nullptr;
+            if (ia) {
+                int numChannels = mod->get_num_channels();
+                for (int i = 0;  i < numChannels;  ++i) { ia->set_channel_mute_status(i, (i < first) || (i >= last)); }
+            }
+            w->mods.push_back(ia ? mod : nullptr);
+            if (!ia) { delete mod; }
+        }
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto lastRequest = Clock::now();
+    uint64_t seenSeq = 0u;
+    std::unique_lock<std::mutex> lock(m_lock);
+    for (;;) {
+        m_wakeup.wait(lock, [this, seenSeq] { return m_quit || (m_requestSeq != seenSeq); });
+        if (m_quit) { return; }
+        seenSeq = m_requestSeq;
+        double target = m_target;
+        lock.unlock();
+
+        auto t0 = Clock::now();
+        render(w, target);
+        auto t1 = Clock::now();
+        double interval = std::max(std::chrono::duration<double>(t0 - lastRequest).count(), 0.001);
+        w->load.store(float(std::chrono::duration<double>(t1 - t0).count() / interval), std::memory_order_relaxed);
+        lastRequest = t0;
+
+        lock.lock();
+        for (size_t i = 0u;  i < w->scopes.size();  ++i) {
+            std::copy(&w->history[i * WindowSize], &w->history[(i + 1u) * WindowSize], &m_shared[size_t(w->scopes[i]) * WindowSize]);
+        }
+        ++m_resultSeq;
+    }
+}
+
+void ChannelScopes::render(Worker* w, double target) {
+    TRACE_SCOPE("scopes: render");
+    int rate = sampleRate();
+    double windowTime = double(WindowSize) / double(rate);
+    for (size_t i = 0u;  i < w->scopes.size();  ++i) {
+        openmpt::module* mod = w->mods[i];
+        if (!mod) { continue; }
+        float* hist = &w->history[i * WindowSize];
+        double t = w->times[i];
+        int64_t count = int64_t(std::floor((target - t) * double(rate) + 0.5));
+
+        // re-synchronize if the main instance jumped (seek, loop, first
+        // update) or the sample rate changed; note that OpenMPT can only
+        // seek with tick granularity, so we take its actual position
+        if ((t < 0.0) || (count < 0) || (count > (rate >> 1)) || (w->rate != rate)) {
+            mod->set_position_seconds(std::max(0.0, target - windowTime));
+            t = mod->get_position_seconds();
+            count = int64_t(std::floor((target - t) * double(rate) + 0.5));
+            std::fill(hist, hist + WindowSize, 0.0f);
+        }
+
+        // render and append to the history
+        while (count > 0) {
+            size_t chunk = size_t(std::min(count, int64_t(w->buffer.size())));
+            size_t done = mod->read(rate, chunk, w->buffer.data());
+            if (!done) { break; }  // end of song
+            const float* src = w->buffer.data();
+            if (done >= size_t(WindowSize)) {
+                std::copy(src + (done - WindowSize), src + done, hist);
+            } else {
+                std::copy(hist + done, hist + WindowSize, hist);
+                std::copy(src, src + done, hist + (WindowSize - done));
+            }
+            count -= int64_t(done);
+            t += double(done) / double(rate);
+        }
+        w->times[i] = t;
+    }
+    w->rate = rate;
+}
@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+namespace openmpt {
+    class module;
+}
+
+//! Per-channel oscilloscopes.
+//!
+//! libopenmpt only ever produces the final mix, so the individual channel
+//! signals are obtained by playing additional module instances, each with
+//! all channels except a group of adjacent channels muted; there's one
+//! scope per group. These instances are spread across a number of worker
+//! threads and follow the main instance's playback position, re-seeking
+//! whenever it jumps. If the workers can't keep up, the scope sample rate
+//! is lowered first, then the groups are made larger, which means fewer
+//! instances and workers; with enough headroom, this is reverted, up to
+//! one instance per channel (within the limit of MaxInstances).
+class ChannelScopes {
+public:
+    static constexpr int WindowSize = 256;         //!< samples per scope window
+    static constexpr int MaxSampleRate = 16000;    //!< initial (and maximum) scope sample rate
+    static constexpr int MinSampleRate = 2000;     //!< minimum scope sample rate
+    static constexpr int MaxInstances = 16;        //!< maximum number of module instances (each has its own copy of the samples)
+
+    inline ChannelScopes() {}
+    inline ~ChannelScopes() { stop(); }
+
+    //! load a module file and start the worker threads
+    //! \returns false if the module can't be loaded
+    bool start(const std::string& path, int numChannels);
+    //! stop all worker threads and free the module instances
+    void stop();
+    inline bool active() const { return m_numChannels > 0; }
+
+    //! request new windows that end at a specific playback position, in
+    //! seconds (main thread, once per frame); the results are available
+    //! with one frame of delay
+    void update(double position);
+
+    //! get the most recent windows (main thread only)
+    //! \returns pointer to numScopes() * WindowSize samples (scope-major),
+    //!          or nullptr if there's nothing to show yet
+    const float* windows();
+    inline int numChannels() const { return m_numChannels; }
+    //! number of channels per scope (the last scope may have fewer)
+    inline int groupSize() const { return m_groupSize; }
+    //! number of scopes, which is also the number of module instances
+    inline int numScopes() const { return m_groupSize ? ((m_numChannels + m_groupSize - 1) / m_groupSize) : 0; }
+
+    //! current scope sample rate
+    inline int sampleRate() const { return m_sampleRate.load(std::memory_order_relaxed); }
+
+private:
+    struct Worker {
+        std::thread* thread = nullptr;
+        std::vector<int> scopes;                 //!< scopes (channel groups) this worker is responsible for
+        std::vector<openmpt::module*> mods;      //!< module instance for each of the scopes
+        std::vector<double> times;               //!< current playback position of each instance
+        std::vector<float> history;              //!< most recent WindowSize samples of each scope
+        std::vector<float> buffer;               //!< render buffer
+        int rate = 0;                            //!< sample rate of the last render() call
+        std::atomic<float> load { -1.0f };       //!< fraction of the update interval spent rendering (negative = not measured yet)
+    };
+    std::vector<Worker*> m_workers;
+    std::vector<std::byte> m_data;  //!< module file data, for creating the instances
+    int m_numChannels = 0;
+    int m_groupSize = 0;
+    std::atomic<int> m_sampleRate { MaxSampleRate };
+    std::atomic<bool> m_quit { false };
+
+    std::mutex m_lock;  //!< protects all the following members
+    std::condition_variable m_wakeup;
+    uint64_t m_requestSeq = 0;    //!< incremented with each update()
+    double m_target = 0.0;        //!< requested position
+    std::vector<float> m_shared;  //!< latest results, written by the workers
+    uint64_t m_resultSeq = 0;     //!< incremented whenever m_shared changes
+
+    // main thread only
+    std::vector<float> m_front;   //!< copy of m_shared
+    uint64_t m_frontSeq = 0;
+    int m_rateCooldown = 0;       //!< updates until the next sample rate or group size adjustment
+
+    void startWorkers(int groupSize);
+    void stopWorkers();
+    void run(Worker* w);
+    void render(Worker* w, double target);
+};
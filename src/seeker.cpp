@@ -0,0 +1,172 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#include <cstdint>
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+#include <libopenmpt/libopenmpt.hpp>
+
+#include "util.h"
+#include "trace.h"
+#include "config.h"
+#include "modutil.h"
+#include "seeker.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// main thread interface
+
+void StandbySeeker::start(const std::vector<std::byte>& data, const Config& config, bool loop) {
+    stop();
+    m_data = data;
+    m_config = config;
+    m_loop = loop;
+    m_quit = false;
+    m_requestValid = false;
+    m_takenSeq = m_postedSeq = m_requestSeq = 0u;
+    m_doneSeq = m_switchedSeq = 0u;
+    m_thread = new std::thread(&StandbySeeker::run, this);
+}
+
+void StandbySeeker::stop() {
+    if (!m_thread) { return; }
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_quit = true;
+    }
+    m_wakeup.notify_one();
+    m_thread->join();
+    delete m_thread;
+    m_thread = nullptr;
+    m_ready = false;
+    for (auto& instance : m_instances) {
+        delete instance;
+        instance = nullptr;
+    }
+    m_standby = m_spare = nullptr;
+    m_done = m_returned = nullptr;
+    m_instanceMemory = 0u;
+    std::vector<std::byte>().swap(m_data);
+}
+
+void StandbySeeker::seekTime(double seconds) {
+    request(false, seconds);
+}
+
+void StandbySeeker::seekOrder(int order, int row) {
+    request(true, double(order), row);
+}
+
+void StandbySeeker::request(bool byOrder, double target, int row) {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_byOrder = byOrder;
+        m_target = target;
+        m_targetRow = row;
+        m_requestValid = true;
+        m_postedSeq = ++m_requestSeq;
+    }
+    m_wakeup.notify_one();
+}
+
+void StandbySeeker::cancel() {
+    if (!m_thread) { return; }
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_requestValid = false;
+        m_postedSeq = ++m_requestSeq;
+    }
+    // a finished seek that the audio thread didn't pick up yet is obsolete
+    // now; it goes back to the worker as if the audio thread had switched
+    openmpt::module* mod = m_done.exchange(nullptr, std::memory_order_acq_rel);
+    if (mod) { m_returned.store(mod, std::memory_order_release); }
+    m_switchedSeq.store(m_postedSeq.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// worker thread
+
+void StandbySeeker::run() {
+    Trace::setThreadName("seek");
+    {
+        TRACE_SCOPE("seek: create instances");
+        std::string error;
+        size_t fileSize = m_data.size();
+        for (auto& instance : m_instances) {
+            instance = ModUtil::createModule(m_data, m_config, m_loop, error);
+            if (!instance) {
+                Dprintf("WARNING: could not create standby instance for seeking - %s\n", error.c_str());
+                std::vector<std::byte>().swap(m_data);
+                return;
+            }
+        }
+        std::vector<std::byte>().swap(m_data);  // OpenMPT has its own copies
+        m_instanceMemory = ModUtil::estimateModuleMemory(m_instances[0], fileSize);
+        m_standby = m_instances[0];
+        m_spare = m_instances[1];
+        m_ready = true;
+    }
+
+    uint64_t seenSeq = 0u;
+    std::unique_lock<std::mutex> lock(m_lock);
+    for (;;) {
+        m_wakeup.wait(lock, [this, seenSeq] { return m_quit || (m_requestSeq != seenSeq); });
+        if (m_quit) { return; }
+        seenSeq = m_requestSeq;
+        if (!m_requestValid) { continue; }
+        bool byOrder = m_byOrder;
+        double target = m_target;
+        int row = m_targetRow;
+        lock.unlock();
+
+        openmpt::module* mod = acquireStandby();
+        if (mod) {
+            TRACE_SCOPE("seek");
+            if (byOrder) {
+                mod->set_position_order_row(int(target), row);
+            } else {
+                mod->set_position_seconds(target);
+            }
+        }
+
+        lock.lock();
+        if (!mod) { return; }  // quit while waiting
+        if (m_requestSeq != seenSeq) {
+            m_standby = mod;  // already superseded by a newer request
+            continue;
+        }
+        m_doneSeq.store(seenSeq, std::memory_order_release);
+        m_done.store(mod, std::memory_order_release);
+    }
+}
+
+openmpt::module* StandbySeeker::acquireStandby() {
+    if (m_standby) {
+        openmpt::module* mod = m_standby;
+        m_standby = nullptr;
+        return mod;
+    }
+    for (;;) {
+        openmpt::module* mod = m_returned.exchange(nullptr, std::memory_order_acq_rel);
+        if (mod && (mod != m_instances[0]) && (mod != m_instances[1])) {
+            // the application's instance, which the UI is still using;
+            // this happens only once, after the first switch
+            mod = m_spare;
+            m_spare = nullptr;
+        }
+        if (mod) { return mod; }
+        // the result of the previous seek hasn't been picked up yet; the
+        // current request supersedes it, so it can be seeked again
+        mod = m_done.exchange(nullptr, std::memory_order_acq_rel);
+        if (mod) { return mod; }
+        // the audio thread is in the middle of switching instances
+        if (m_quit) { return nullptr; }
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,109 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+#include "config.h"
+
+namespace openmpt {
+    class module;
+}
+
+//! Off-thread seeking on a standby module instance.
+//!
+//! Seeking in OpenMPT means simulating playback from the start of the song
+//! up to the target position, which can take quite a while in large modules.
+//! Instead of doing that on the audio thread, a worker thread seeks on a
+//! second instance of the same module. The audio thread then switches over
+//! to that instance at the next buffer boundary with takeReady() and hands
+//! the instance it played before back with giveBack(); that one becomes the
+//! standby instance for the next seek.
+//!
+//! The application's own instance, which is played until the first seek,
+//! is never seeked by the worker, because the UI keeps reading pattern data
+//! from it; when it's handed back, it's retired and a second instance of
+//! the worker takes its place.
+class StandbySeeker {
+public:
+    inline StandbySeeker() {}
+    inline ~StandbySeeker() { stop(); }
+
+    //! start the worker thread, which creates the standby instances from a
+    //! copy of the module data in the background
+    void start(const std::vector<std::byte>& data, const Config& config, bool loop);
+    //! stop the worker thread and delete the instances it created
+    //! (the audio thread must not be running, as it may be playing that instance)
+    void stop();
+    //! check whether the standby instances are available
+    inline bool ready() const { return m_ready.load(std::memory_order_acquire); }
+    //! memory used by the standby instances
+    inline size_t memoryUsage() const { return ready() ? (m_instanceMemory * NumInstances) : 0u; }
+
+    //! request seeking to a specific time, in seconds (main thread)
+    void seekTime(double seconds);
+    //! request seeking to the start of a specific row (main thread)
+    void seekOrder(int order, int row=0);
+    //! discard all outstanding seek requests (main thread)
+    void cancel();
+    //! check whether a seek has been requested that the audio thread
+    //! hasn't switched to yet (main thread)
+    inline bool pending() const { return m_switchedSeq.load(std::memory_order_acquire) != m_postedSeq.load(std::memory_order_relaxed); }
+
+    //! get the instance of the most recently completed seek, if any (audio thread)
+    inline openmpt::module* takeReady() {
+        openmpt::module* mod = m_done.exchange(nullptr, std::memory_order_acq_rel);
+        if (mod) { m_takenSeq = m_doneSeq.load(std::memory_order_acquire); }
+        return mod;
+    }
+    //! check whether the instance returned by the last takeReady() is the
+    //! result of the most recent request (audio thread)
+    inline bool tookLatest() const { return m_takenSeq == m_postedSeq.load(std::memory_order_acquire); }
+    //! hand the previously playing instance back after switching (audio thread)
+    inline void giveBack(openmpt::module* mod) {
+        m_returned.store(mod, std::memory_order_release);
+        m_switchedSeq.store(m_takenSeq, std::memory_order_release);
+    }
+
+private:
+    static constexpr int NumInstances = 2;
+    std::thread* m_thread = nullptr;
+    std::vector<std::byte> m_data;       //!< copy of the module data, freed after creating the instance
+    Config m_config;
+    bool m_loop = false;
+    openmpt::module* m_instances[NumInstances] = { nullptr, nullptr };  //!< the instances created by the worker (owned by this class)
+    openmpt::module* m_spare = nullptr;     //!< worker instance that takes over when the application's instance is retired
+    size_t m_instanceMemory = 0u;
+    std::atomic<bool> m_ready { false };
+
+    std::mutex m_lock;  //!< protects the request
+    std::condition_variable m_wakeup;
+    std::atomic<bool> m_quit { false };
+    bool m_byOrder = false;     //!< whether the request is for an order instead of a time
+    double m_target = 0.0;      //!< requested time or order
+    int m_targetRow = 0;        //!< requested row, if seeking to an order
+    uint64_t m_requestSeq = 0;  //!< incremented with each request or cancellation
+    bool m_requestValid = false;
+
+    // handover of the instance that is currently not playing; at any time,
+    // it's either the worker's standby instance, or in one of the atomics
+    openmpt::module* m_standby = nullptr;
+    std::atomic<openmpt::module*> m_done { nullptr };      //!< worker -> audio thread
+    std::atomic<openmpt::module*> m_returned { nullptr };  //!< audio thread -> worker
+    std::atomic<uint64_t> m_doneSeq { 0 };      //!< request sequence number of m_done
+    std::atomic<uint64_t> m_switchedSeq { 0 };  //!< request sequence number of the last switch (or cancellation)
+    uint64_t m_takenSeq = 0;                    //!< audio thread's copy of m_doneSeq
+    std::atomic<uint64_t> m_postedSeq { 0 };    //!< main thread's copy of m_requestSeq
+
+    void request(bool byOrder, double target, int row=0);
+    void run();
+    openmpt::module* acquireStandby();
+};
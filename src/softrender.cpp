@@ -0,0 +1,590 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include <vector>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #define SOFTRENDER_SSE2 1
+#endif
+
+#include "imgui.h"
+
+#include "util.h"
+#include "trace.h"
+#include "renderer.h"
+#include "softrender.h"
+
+constexpr float msdfPixelRange = 8.0f;  // distance range of the MSDF font atlas, in texels
+constexpr size_t reservedQuads = 16384;  // avoid reallocation in the first frames
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// pixel helpers
+
+static inline int ifloor(float x) {
+    int i = int(x);
+    return (x < float(i)) ? (i - 1) : i;
+}
+
+//! blend a color into a pixel; alpha is in the 0...256 range
+static inline void blendPixel(uint32_t& dst, uint32_t color, uint32_t alpha) {
+    if (!alpha) { return; }
+    if (alpha >= 256u) { dst = color | 0xFF000000u; return; }
+    uint32_t d = dst, inv = 256u - alpha;
+    uint32_t rb = (((color & 0xFF00FFu) * alpha + (d & 0xFF00FFu) * inv) >> 8) & 0xFF00FFu;
+    uint32_t g  = (((color & 0x00FF00u) * alpha + (d & 0x00FF00u) * inv) >> 8) & 0x00FF00u;
+    dst = rb | g | 0xFF000000u;
+}
+
+//! blend a constant color into a span of pixels
+static void blendSpan(uint32_t* dst, int count, uint32_t color, uint32_t alpha) {
+    if (!alpha || (count <= 0)) { return; }
+    color |= 0xFF000000u;
+    if (alpha >= 256u) {
+        std::fill(dst, dst + count, color);
+        return;
+    }
+    #ifdef SOFTRENDER_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i src = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32(int(color)), zero), _mm_set1_epi16(short(alpha)));
+        const __m128i inv = _mm_set1_epi16(short(256u - alpha));
+        for (;  count >= 4;  count -= 4, dst += 4) {
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst));
+            __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), src), 8);
+            __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), src), 8);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(lo, hi));
+        }
+    #endif
+    while (count-- > 0) { blendPixel(*dst++, color, alpha); }
+}
+
+//! scale a 0...256 coverage alpha by an 8-bit color alpha
+static inline uint32_t mulAlpha(uint32_t alpha, uint32_t colorAlpha) {
+    return (alpha * (colorAlpha + (colorAlpha >> 7))) >> 8;
+}
+
+static inline void unpackColor(uint32_t c, float* f) {
+    f[0] = float(c & 0xFFu);  f[1] = float((c >> 8) & 0xFFu);  f[2] = float((c >> 16) & 0xFFu);  f[3] = float(c >> 24);
+}
+
+static inline uint32_t packColor(const float* f) {
+    return  uint32_t(f[0] + 0.5f)        | (uint32_t(f[1] + 0.5f) <<  8)
+         | (uint32_t(f[2] + 0.5f) << 16) | (uint32_t(f[3] + 0.5f) << 24);
+}
+
+//! horizontal color gradient along one row of a quad
+struct RowColor {
+    float left[4], delta[4];
+    bool constant;
+    uint32_t color;  // only valid if constant
+
+    RowColor(const uint32_t* c, float fy) {
+        float ul[4], ur[4], ll[4], lr[4], right[4];
+        unpackColor(c[0], ul);  unpackColor(c[1], ur);
+        unpackColor(c[2], ll);  unpackColor(c[3], lr);
+        for (int i = 0;  i < 4;  ++i) {
+            left[i]  = ul[i] + (ll[i] - ul[i]) * fy;
+            right[i] = ur[i] + (lr[i] - ur[i]) * fy;
+            delta[i] = right[i] - left[i];
+        }
+        color = packColor(left);
+        constant = (color == packColor(right));
+    }
+
+    inline uint32_t at(float fx) const {
+        if (constant) { return color; }
+        float f[4];
+        for (int i = 0;  i < 4;  ++i) { f[i] = left[i] + delta[i] * fx; }
+        return packColor(f);
+    }
+};
+
+//! bilinear texture sampling setup, with clamp-to-edge addressing
+struct Bilinear {
+    int o00, o01, o10, o11;
+    float fx, fy;
+
+    Bilinear(int w, int h, int channels, float u, float v) {
+        float x = u * float(w) - 0.5f, y = v * float(h) - 0.5f;
+        int ix = ifloor(x), iy = ifloor(y);
+        fx = x - float(ix);  fy = y - float(iy);
+        int x0 = std::clamp(ix, 0, w - 1), x1 = std::clamp(ix + 1, 0, w - 1);
+        int y0 = std::clamp(iy, 0, h - 1), y1 = std::clamp(iy + 1, 0, h - 1);
+        o00 = (y0 * w + x0) * channels;  o01 = (y0 * w + x1) * channels;
+        o10 = (y1 * w + x0) * channels;  o11 = (y1 * w + x1) * channels;
+    }
+
+    //! sample one channel \returns value in the 0...255 range
+    inline float operator() (const uint8_t* p) const {
+        float a = float(p[o00]) + (float(p[o01]) - float(p[o00])) * fx;
+        float b = float(p[o10]) + (float(p[o11]) - float(p[o10])) * fx;
+        return a + (b - a) * fy;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// main thread interface
+
+bool SoftwareRasterizer::init(int width, int height) {
+    shutdown();
+    setAlphaGamma(1.0f);
+    resize(width, height);
+    m_quads.reserve(reservedQuads);
+    m_quit = false;
+    m_jobSeq = 0u;
+
+    // the main thread takes part in rendering, so one worker per spare core
+    int threads = std::clamp(int(std::thread::hardware_concurrency()) - 1, 0, 15);
+    Dprintf("software rasterizer: %dx%d, %d worker threads\n", width, height, threads);
+    for (int t = 0;  t < threads;  ++t) {
+        m_threads.push_back(new std::thread(&SoftwareRasterizer::run, this));
+    }
+    return !m_pixels.empty();
+}
+
+void SoftwareRasterizer::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_quit = true;
+    }
+    m_wakeup.notify_all();
+    for (auto t : m_threads) {
+        t->join();
+        delete t;
+    }
+    m_threads.clear();
+    for (auto tex : m_textures) { delete tex; }
+    m_textures.clear();
+    std::vector<uint32_t>().swap(m_pixels);
+    m_quads.clear();
+    m_imgui = nullptr;
+    m_width = m_height = 0;
+}
+
+void SoftwareRasterizer::resize(int width, int height) {
+    m_width  = std::max(width,  1);
+    m_height = std::max(height, 1);
+    m_pixels.assign(size_t(m_width) * size_t(m_height), 0xFF000000u);
+}
+
+void SoftwareRasterizer::setAlphaGamma(float gamma) {
+    float invGamma = 1.0f / std::max(gamma, 0.01f);
+    for (int i = 0;  i <= 1024;  ++i) {
+        m_alphaLUT[i] = uint16_t(std::pow(float(i) / 1024.0f, invGamma) * 256.0f + 0.5f);
+    }
+}
+
+void SoftwareRasterizer::render(void* target, int targetWidth, int targetHeight, int pitch, bool bgra) {
+    TRACE_SCOPE("software rasterization");
+    m_target = target;
+    m_targetWidth  = std::min(targetWidth,  m_width);
+    m_targetHeight = std::min(targetHeight, m_height);
+    m_pitch = pitch;
+    m_bgra = bgra;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_numBands = (m_height + BandHeight - 1) / BandHeight;
+        m_nextBand.store(0, std::memory_order_relaxed);
+        m_bandsDone = 0;
+        ++m_jobSeq;
+    }
+    m_wakeup.notify_all();
+    work();
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_finished.wait(lock, [this] { return m_bandsDone >= m_numBands; });
+    }
+    m_quads.clear();
+    m_imgui = nullptr;
+}
+
+unsigned SoftwareRasterizer::createTexture(const uint8_t* data, int width, int height, int channels, bool mipmap) {
+    if (!data || (width < 1) || (height < 1) || (channels < 1) || (channels > 4)) { return 0u; }
+    Texture* tex = new Texture;
+    tex->width = width;
+    tex->height = height;
+    tex->channels = channels;
+    tex->levels.emplace_back(data, data + size_t(width) * size_t(height) * size_t(channels));
+
+    // box-filtered mipmap chain
+    int w = width, h = height;
+    while (mipmap && ((w > 1) || (h > 1))) {
+        int nw = std::max(w >> 1, 1), nh = std::max(h >> 1, 1);
+        const auto& src = tex->levels.back();
+        std::vector<uint8_t> dest(size_t(nw) * size_t(nh) * size_t(channels));
+        for (int y = 0;  y < nh;  ++y) {
+            int y0 = std::min(2 * y, h - 1), y1 = std::min(2 * y + 1, h - 1);
+            for (int x = 0;  x < nw;  ++x) {
+                int x0 = std::min(2 * x, w - 1), x1 = std::min(2 * x + 1, w - 1);
+                for (int c = 0;  c < channels;  ++c) {
+                    dest[(y * nw + x) * channels + c] = uint8_t((
+                        src[(y0 * w + x0) * channels + c] + src[(y0 * w + x1) * channels + c] +
+                        src[(y1 * w + x0) * channels + c] + src[(y1 * w + x1) * channels + c] + 2) >> 2);
+                }
+            }
+        }
+        tex->levels.push_back(std::move(dest));
+        w = nw;  h = nh;
+    }
+
+    // reuse a free slot, if any
+    for (size_t i = 0u;  i < m_textures.size();  ++i) {
+        if (!m_textures[i]) { m_textures[i] = tex; return unsigned(i + 1u); }
+    }
+    m_textures.push_back(tex);
+    return unsigned(m_textures.size());
+}
+
+void SoftwareRasterizer::deleteTexture(unsigned texID) {
+    if (!texID || (texID > m_textures.size())) { return; }
+    delete m_textures[texID - 1u];
+    m_textures[texID - 1u] = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// worker threads
+
+void SoftwareRasterizer::run() {
+    Trace::setThreadName("raster");
+    uint64_t seenSeq = 0u;
+    std::unique_lock<std::mutex> lock(m_lock);
+    for (;;) {
+        m_wakeup.wait(lock, [this, seenSeq] { return m_quit || (m_jobSeq != seenSeq); });
+        if (m_quit) { return; }
+        seenSeq = m_jobSeq;
+        lock.unlock();
+        work();
+        lock.lock();
+    }
+}
+
+void SoftwareRasterizer::work() {
+    int done = 0;
+    for (;;) {
+        int band = m_nextBand.fetch_add(1, std::memory_order_relaxed);
+        if (band >= m_numBands) { break; }
+        renderBand(band * BandHeight, std::min((band + 1) * BandHeight, m_height));
+        ++done;
+    }
+    if (done) {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_bandsDone += done;
+        if (m_bandsDone >= m_numBands) { m_finished.notify_all(); }
+    }
+}
+
+void SoftwareRasterizer::renderBand(int y0, int y1) {
+    uint32_t* band = &m_pixels[size_t(y0) * size_t(m_width)];
+    std::fill(band, band + size_t(y1 - y0) * size_t(m_width), m_clearColor | 0xFF000000u);
+    for (const auto& q : m_quads) { drawQuad(q, y0, y1); }
+    if (m_imgui) { drawImGui(y0, y1); }
+
+    if (!m_target) { return; }
+    for (int y = y0;  y < std::min(y1, m_targetHeight);  ++y) {
+        const uint32_t* src = &m_pixels[size_t(y) * size_t(m_width)];
+        uint32_t* dest = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(m_target) + size_t(y) * size_t(m_pitch));
+        if (!m_bgra) {
+            ::memcpy(dest, src, size_t(m_targetWidth) * 4u);
+            continue;
+        }
+        for (int x = 0;  x < m_targetWidth;  ++x) {
+            uint32_t p = src[x];
+            dest[x] = (p & 0xFF00FF00u) | ((p >> 16) & 0xFFu) | ((p & 0xFFu) << 16);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// TextBoxRenderer quads
+
+void SoftwareRasterizer::drawQuad(const Quad& q, int by0, int by1) {
+    if (!(q.x1 > q.x0) || !(q.y1 > q.y0)) { return; }
+    // pixels are covered if their centers are inside the quad, as in OpenGL
+    int px0 = std::max(int(std::ceil(q.x0 - 0.5f)), 0);
+    int px1 = std::min(int(std::ceil(q.x1 - 0.5f)), m_width);
+    int py0 = std::max(int(std::ceil(q.y0 - 0.5f)), by0);
+    int py1 = std::min(int(std::ceil(q.y1 - 0.5f)), by1);
+    if ((px0 >= px1) || (py0 >= py1)) { return; }
+    if (q.mode == RenderMode::Box) {
+        drawBox(q, px0, px1, py0, py1);
+    } else {
+        const Texture* tex = texture(q.tex);
+        if (!tex) { return; }
+        if ((q.mode == RenderMode::MSDFText) && (tex->channels >= 3)) {
+            drawMSDF(q, *tex, px0, px1, py0, py1);
+        } else {
+            drawTextured(q, *tex, px0, px1, py0, py1);
+        }
+    }
+}
+
+void SoftwareRasterizer::drawBox(const Quad& q, int px0, int px1, int py0, int py1) {
+    float sx = (q.u1 - q.u0) / (q.x1 - q.x0), sy = (q.v1 - q.v0) / (q.y1 - q.y0);
+    float invW = 1.0f / (q.x1 - q.x0), invH = 1.0f / (q.y1 - q.y0);
+    float hw = q.size[0], hh = q.size[1], r = q.size[2];
+    // distance from the edge beyond which coverage is complete
+    bool spans = (q.br[1] > 0.0f) && (sx > 0.0f);
+    float full = spans ? (q.br[0] + 0.5f / q.br[1]) : 0.0f;
+
+    for (int y = py0;  y < py1;  ++y) {
+        uint32_t* row = &m_pixels[size_t(y) * size_t(m_width)];
+        float cy = float(y) + 0.5f;
+        RowColor color(q.color, (cy - q.y0) * invH);
+        float py = std::fabs(q.v0 + (cy - q.y0) * sy) - hh;
+
+        // determine the fully covered interior span; outside of the corners,
+        // the distance is simply that to the nearest edge
+        int sx0 = px1, sx1 = px1;
+        if (spans && color.constant && (py <= -r) && (-py >= full) && (hw > full)) {
+            float lim = hw - full;
+            sx0 = std::max(int(std::ceil (q.x0 + (-lim - q.u0) / sx - 0.5f)), px0);
+            sx1 = std::min(int(std::floor(q.x0 + ( lim - q.u0) / sx - 0.5f)) + 1, px1);
+            if (sx0 >= sx1) { sx0 = sx1 = px1; }
+        }
+
+        auto shade = [&] (int x) {
+            float cx = float(x) + 0.5f;
+            float px = std::fabs(q.u0 + (cx - q.x0) * sx) - hw;
+            float d = (std::min(px, py) > -r)
+                    ? (r - std::hypot(px + r, py + r))
+                    : std::min(-px, -py);
+            uint32_t c = color.at((cx - q.x0) * invW);
+            blendPixel(row[x], c, mulAlpha(alpha((d - q.br[0]) * q.br[1] + 0.5f), c >> 24));
+        };
+        for (int x = px0;  x < sx0;  ++x) { shade(x); }
+        if (sx1 > sx0) {
+            blendSpan(&row[sx0], sx1 - sx0, color.color, mulAlpha(m_alphaLUT[1024], color.color >> 24));
+        }
+        for (int x = sx1;  x < px1;  ++x) { shade(x); }
+    }
+}
+
+void SoftwareRasterizer::drawMSDF(const Quad& q, const Texture& tex, int px0, int px1, int py0, int py1) {
+    float dudx = (q.u1 - q.u0) / (q.x1 - q.x0), dvdy = (q.v1 - q.v0) / (q.y1 - q.y0);
+    float invW = 1.0f / (q.x1 - q.x0), invH = 1.0f / (q.y1 - q.y0);
+    const uint8_t* data = tex.levels[0].data();
+    int w = tex.width, h = tex.height, ch = tex.channels;
+
+    // d / fwidth(d) is approximated by the screen-space distance in pixels;
+    // if a sample is far enough from the edge, all four supersamples of the
+    // pixel (or all pixels of a 2x2 block) are saturated anyway
+    float scale = msdfPixelRange / std::max(std::max(std::fabs(dudx) * float(w), std::fabs(dvdy) * float(h)), 1e-6f);
+    float pixelSkip = 0.5f + 1.5f * 0.375f * (std::fabs(q.size[0] / dudx) + std::fabs(q.size[1] / dvdy));
+    float blockSkip = pixelSkip + 1.0f;
+    uint32_t alphaIn  = alpha(( 0.5f - q.br[0]) * q.br[1] + 0.5f);
+    uint32_t alphaOut = alpha((-0.5f - q.br[0]) * q.br[1] + 0.5f);
+
+    auto sample = [&] (float u, float v) -> float {
+        Bilinear s(w, h, ch, u, v);
+        float r = s(data), g = s(data + 1), b = s(data + 2);
+        float m = std::max(std::min(r, g), std::min(std::max(r, g), b));
+        return (m * (1.0f / 255.0f) - 0.5f) * scale;
+    };
+    auto coverage = [&] (float u, float v) -> uint32_t {
+        float d = sample(u, v);
+        if (d >=  pixelSkip) { return alphaIn; }
+        if (d <= -pixelSkip) { return alphaOut; }
+        d = 0.25f * (std::clamp(sample(u - 0.375f * q.size[0], v - 0.125f * q.size[1]), -0.5f, 0.5f)
+                  +  std::clamp(sample(u + 0.125f * q.size[0], v - 0.375f * q.size[1]), -0.5f, 0.5f)
+                  +  std::clamp(sample(u - 0.125f * q.size[0], v + 0.375f * q.size[1]), -0.5f, 0.5f)
+                  +  std::clamp(sample(u + 0.375f * q.size[0], v + 0.125f * q.size[1]), -0.5f, 0.5f));
+        return alpha((d - q.br[0]) * q.br[1] + 0.5f);
+    };
+
+    for (int y = py0;  y < py1;  y += 2) {
+        int rows = std::min(py1 - y, 2);
+        float cy = float(y) + 0.5f;
+        float v = q.v0 + (cy - q.y0) * dvdy;
+        const RowColor color[2] = { RowColor(q.color, (cy - q.y0) * invH), RowColor(q.color, (cy + 1.0f - q.y0) * invH) };
+        uint32_t* row = &m_pixels[size_t(y) * size_t(m_width)];
+        for (int x = px0;  x < px1;  x += 2) {
+            int cols = std::min(px1 - x, 2);
+            float cx = float(x) + 0.5f;
+            float u = q.u0 + (cx - q.x0) * dudx;
+            uint32_t a[4];
+            float d = sample(u + 0.5f * dudx, v + 0.5f * dvdy);
+            if ((d >= blockSkip) || (d <= -blockSkip)) {
+                a[0] = a[1] = a[2] = a[3] = (d > 0.0f) ? alphaIn : alphaOut;
+                if (!a[0]) { continue; }
+            } else {
+                a[0] = coverage(u, v);
+                a[1] = coverage(u + dudx, v);
+                a[2] = coverage(u, v + dvdy);
+                a[3] = coverage(u + dudx, v + dvdy);
+            }
+            for (int j = 0;  j < rows;  ++j) {
+                for (int i = 0;  i < cols;  ++i) {
+                    if (!a[j * 2 + i]) { continue; }
+                    uint32_t c = color[j].at((cx + float(i) - q.x0) * invW);
+                    blendPixel(row[j * m_width + x + i], c, mulAlpha(a[j * 2 + i], c >> 24));
+                }
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::drawTextured(const Quad& q, const Texture& tex, int px0, int px1, int py0, int py1) {
+    float dudx = (q.u1 - q.u0) / (q.x1 - q.x0), dvdy = (q.v1 - q.v0) / (q.y1 - q.y0);
+    float invW = 1.0f / (q.x1 - q.x0), invH = 1.0f / (q.y1 - q.y0);
+
+    // select the mipmap level like OpenGL does, with a LOD bias of -1
+    // (bitmap text is always sampled from the base level)
+    int level = 0;
+    float texelsPerPixel = std::max(std::fabs(dudx) * float(tex.width), std::fabs(dvdy) * float(tex.height));
+    if ((q.mode != RenderMode::BitmapText) && (texelsPerPixel > 2.0f)) {
+        level = std::min(int(std::log2(texelsPerPixel) - 0.5f), int(tex.levels.size()) - 1);
+    }
+    const uint8_t* data = tex.levels[level].data();
+    int w = std::max(tex.width >> level, 1), h = std::max(tex.height >> level, 1), ch = tex.channels;
+
+    for (int y = py0;  y < py1;  ++y) {
+        uint32_t* row = &m_pixels[size_t(y) * size_t(m_width)];
+        float cy = float(y) + 0.5f;
+        float v = q.v0 + (cy - q.y0) * dvdy;
+        RowColor color(q.color, (cy - q.y0) * invH);
+        for (int x = px0;  x < px1;  ++x) {
+            float cx = float(x) + 0.5f;
+            float u = q.u0 + (cx - q.x0) * dudx;
+            float d;
+            if (q.mode == RenderMode::BitmapText) {
+                int tx = std::clamp(ifloor(u * float(w)), 0, w - 1);
+                int ty = std::clamp(ifloor(v * float(h)), 0, h - 1);
+                d = float(data[(ty * w + tx) * ch]) * (1.0f / 255.0f);
+            } else if (q.mode == RenderMode::Logo) {
+                d = Bilinear(w, h, ch, u, v)(data) * (1.0f / 255.0f);
+            } else {  // normal texture mode: no color, no alpha gamma
+                Bilinear s(w, h, ch, u, v);
+                float f[4] = { s(data), 0.0f, 0.0f, 255.0f };
+                if (ch >= 3) { f[1] = s(data + 1);  f[2] = s(data + 2); } else { f[1] = f[2] = f[0]; }
+                if (ch == 2) { f[3] = s(data + 1); }
+                if (ch == 4) { f[3] = s(data + 3); }
+                uint32_t c = packColor(f);
+                blendPixel(row[x], c, mulAlpha(256u, c >> 24));
+                continue;
+            }
+            uint32_t c = color.at((cx - q.x0) * invW);
+            blendPixel(row[x], c, mulAlpha(alpha((d - q.br[0]) * q.br[1] + 0.5f), c >> 24));
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// ImGui triangles
+
+struct ImVertex {
+    float x, y, u, v;
+    float c[4];
+};
+
+static inline float edge(const ImVertex& a, const ImVertex& b, float x, float y) {
+    return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+//! top-left fill rule: pixels exactly on an edge are drawn by only one of
+//! the two triangles sharing that edge
+static inline bool ownsEdge(const ImVertex& a, const ImVertex& b) {
+    return (b.y > a.y) || ((b.y == a.y) && (b.x < a.x));
+}
+
+void SoftwareRasterizer::drawImGui(int by0, int by1) {
+    const ImDrawData* dd = m_imgui;
+    float ox = dd->DisplayPos.x, oy = dd->DisplayPos.y;
+    float sx = dd->FramebufferScale.x, sy = dd->FramebufferScale.y;
+    float bandTop = float(by0), bandBottom = float(by1);
+
+    for (int n = 0;  n < dd->CmdListsCount;  ++n) {
+        const ImDrawList* list = dd->CmdLists[n];
+        const ImDrawVert* vtxBuffer = list->VtxBuffer.Data;
+        const ImDrawIdx* idxBuffer = list->IdxBuffer.Data;
+        for (int i = 0;  i < list->CmdBuffer.Size;  ++i) {
+            const ImDrawCmd& cmd = list->CmdBuffer.Data[i];
+            if (cmd.UserCallback) { continue; }
+            int cx0 = std::max(int((cmd.ClipRect.x - ox) * sx), 0);
+            int cy0 = std::max(int((cmd.ClipRect.y - oy) * sy), by0);
+            int cx1 = std::min(int(std::ceil((cmd.ClipRect.z - ox) * sx)), m_width);
+            int cy1 = std::min(int(std::ceil((cmd.ClipRect.w - oy) * sy)), by1);
+            if ((cx0 >= cx1) || (cy0 >= cy1)) { continue; }
+            const Texture* tex = texture(unsigned(intptr_t(cmd.TextureId)));
+            const ImDrawVert* vtx = vtxBuffer + cmd.VtxOffset;
+            const ImDrawIdx* idx = idxBuffer + cmd.IdxOffset;
+
+            for (unsigned t = 0;  (t + 2u) < cmd.ElemCount;  t += 3u) {
+                const ImDrawVert* src[3] = { &vtx[idx[t]], &vtx[idx[t + 1u]], &vtx[idx[t + 2u]] };
+                // cheap rejection of triangles outside the band
+                float ymin = std::min(std::min(src[0]->pos.y, src[1]->pos.y), src[2]->pos.y);
+                float ymax = std::max(std::max(src[0]->pos.y, src[1]->pos.y), src[2]->pos.y);
+                if ((((ymax - oy) * sy) < bandTop) || (((ymin - oy) * sy) >= bandBottom)) { continue; }
+
+                ImVertex v[3];
+                for (int k = 0;  k < 3;  ++k) {
+                    v[k].x = (src[k]->pos.x - ox) * sx;
+                    v[k].y = (src[k]->pos.y - oy) * sy;
+                    v[k].u = src[k]->uv.x;
+                    v[k].v = src[k]->uv.y;
+                    unpackColor(src[k]->col, v[k].c);
+                }
+                float area = edge(v[0], v[1], v[2].x, v[2].y);
+                if (std::fabs(area) < 1e-6f) { continue; }
+                if (area < 0.0f) { std::swap(v[1], v[2]);  area = -area; }
+                float invArea = 1.0f / area;
+
+                int x0 = std::max(int(std::ceil(std::min(std::min(v[0].x, v[1].x), v[2].x) - 0.5f)), cx0);
+                int x1 = std::min(int(std::ceil(std::max(std::max(v[0].x, v[1].x), v[2].x) - 0.5f)), cx1);
+                int y0 = std::max(int(std::ceil(std::min(std::min(v[0].y, v[1].y), v[2].y) - 0.5f)), cy0);
+                int y1 = std::min(int(std::ceil(std::max(std::max(v[0].y, v[1].y), v[2].y) - 0.5f)), cy1);
+                if ((x0 >= x1) || (y0 >= y1)) { continue; }
+
+                // solid-colored triangles (all vertices with the same color
+                // and texture coordinate) need just one texture sample
+                bool flat = (src[0]->col == src[1]->col) && (src[0]->col == src[2]->col)
+                         && (v[0].u == v[1].u) && (v[0].u == v[2].u) && (v[0].v == v[1].v) && (v[0].v == v[2].v);
+                auto shade = [&] (float u, float tv, const float* c) -> uint32_t {
+                    float f[4] = { c[0], c[1], c[2], c[3] };
+                    if (tex) {
+                        const uint8_t* data = tex->levels[0].data();
+                        Bilinear s(tex->width, tex->height, tex->channels, u, tv);
+                        for (int k = 0;  k < std::min(tex->channels, 4);  ++k) {
+                            f[(tex->channels == 1) ? 3 : k] *= s(data + k) * (1.0f / 255.0f);
+                        }
+                    }
+                    return packColor(f);
+                };
+                uint32_t flatColor = flat ? shade(v[0].u, v[0].v, v[0].c) : 0u;
+                if (flat && !(flatColor >> 24)) { continue; }
+
+                const ImVertex *a = &v[0], *b = &v[1], *c = &v[2];
+                bool own0 = ownsEdge(*b, *c), own1 = ownsEdge(*c, *a), own2 = ownsEdge(*a, *b);
+                for (int y = y0;  y < y1;  ++y) {
+                    uint32_t* row = &m_pixels[size_t(y) * size_t(m_width)];
+                    float py = float(y) + 0.5f;
+                    for (int x = x0;  x < x1;  ++x) {
+                        float px = float(x) + 0.5f;
+                        float w0 = edge(*b, *c, px, py), w1 = edge(*c, *a, px, py), w2 = edge(*a, *b, px, py);
+                        if ((w0 < 0.0f) || (w1 < 0.0f) || (w2 < 0.0f)) { continue; }
+                        if (((w0 == 0.0f) && !own0) || ((w1 == 0.0f) && !own1) || ((w2 == 0.0f) && !own2)) { continue; }
+                        uint32_t color = flatColor;
+                        if (!flat) {
+                            w0 *= invArea;  w1 *= invArea;  w2 *= invArea;
+                            float cc[4];
+                            for (int k = 0;  k < 4;  ++k) { cc[k] = a->c[k] * w0 + b->c[k] * w1 + c->c[k] * w2; }
+                            color = shade(a->u * w0 + b->u * w1 + c->u * w2, a->v * w0 + b->v * w1 + c->v * w2, cc);
+                        }
+                        blendPixel(row[x], color, mulAlpha(256u, color >> 24));
+                    }
+                }
+            }
+        }
+    }
+}
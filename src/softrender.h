@@ -0,0 +1,109 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+struct ImDrawData;
+
+//! CPU rasterizer, used as a fallback if OpenGL isn't available.
+//!
+//! It draws the same quads as TextBoxRenderer's shader (rounded boxes, MSDF
+//! and bitmap text, logo and bitmap), as well as ImGui's triangles, into a
+//! 32-bit RGBA framebuffer. Drawing commands are only collected during the
+//! frame; render() then splits the framebuffer into horizontal bands that
+//! are rasterized in parallel by a pool of worker threads, each band
+//! processing all commands in submission order.
+class SoftwareRasterizer {
+public:
+    static constexpr int BandHeight = 16;  //!< height of a unit of work, in pixels
+
+    //! a quad, as generated by TextBoxRenderer
+    struct Quad {
+        float x0, y0, x1, y1;  //!< screen rectangle, in pixels
+        float u0, v0, u1, v1;  //!< texture coordinates (box mode: half-size coordinates)
+        float size[3];         //!< see TextBoxRenderer::Vertex
+        float br[2];           //!< blend range (x = offset, y = reciprocal of range)
+        uint32_t color[4];     //!< vertex colors: upper left, upper right, lower left, lower right
+        unsigned tex;          //!< texture ID
+        uint8_t mode;          //!< one of the RenderMode constants
+    };
+
+    inline SoftwareRasterizer() {}
+    inline ~SoftwareRasterizer() { shutdown(); }
+
+    //! allocate the framebuffer and start the worker threads
+    bool init(int width, int height);
+    void shutdown();
+    void resize(int width, int height);
+    inline int width()  const { return m_width; }
+    inline int height() const { return m_height; }
+    //! the framebuffer contents after the last render() call (RGBA byte order)
+    inline const uint32_t* pixels() const { return m_pixels.data(); }
+
+    // drawing commands (main thread only)
+    void setAlphaGamma(float gamma);
+    inline void clear(uint32_t color) { m_clearColor = color; }
+    inline void addQuad(const Quad& q) { m_quads.push_back(q); }
+    inline void addImGui(const ImDrawData* data) { m_imgui = data; }
+
+    //! rasterize everything that has been added since the last call, and
+    //! copy the result into 'target' (if not null), optionally in BGRA order;
+    //! the ImGui draw data must stay valid until then
+    void render(void* target=nullptr, int targetWidth=0, int targetHeight=0, int pitch=0, bool bgra=false);
+
+    //! create a texture from 8-bit pixel data with 1 to 4 channels
+    //! (the data is copied) \returns texture ID, or 0 on failure
+    unsigned createTexture(const uint8_t* data, int width, int height, int channels, bool mipmap);
+    void deleteTexture(unsigned texID);
+
+private:
+    struct Texture {
+        int width, height, channels;
+        std::vector<std::vector<uint8_t>> levels;  //!< mipmap levels (or just one)
+    };
+    std::vector<Texture*> m_textures;  //!< texture ID = index + 1
+
+    int m_width = 0, m_height = 0;
+    std::vector<uint32_t> m_pixels;
+    std::vector<Quad> m_quads;
+    const ImDrawData* m_imgui = nullptr;
+    uint32_t m_clearColor = 0xFF000000u;
+    uint16_t m_alphaLUT[1025];  //!< coverage (0..1024) -> gamma-corrected alpha (0..256)
+
+    // job description for the current render() call
+    void* m_target = nullptr;
+    int m_targetWidth = 0, m_targetHeight = 0, m_pitch = 0;
+    bool m_bgra = false;
+
+    // worker threads
+    std::vector<std::thread*> m_threads;
+    std::mutex m_lock;
+    std::condition_variable m_wakeup, m_finished;
+    bool m_quit = false;
+    uint64_t m_jobSeq = 0;              //!< incremented with each render() call
+    int m_numBands = 0;
+    std::atomic<int> m_nextBand { 0 };  //!< next band to be taken by a thread
+    int m_bandsDone = 0;                //!< protected by m_lock
+
+    void run();
+    void work();
+    void renderBand(int y0, int y1);
+    void drawQuad(const Quad& q, int by0, int by1);
+    void drawBox(const Quad& q, int px0, int px1, int py0, int py1);
+    void drawMSDF(const Quad& q, const Texture& tex, int px0, int px1, int py0, int py1);
+    void drawTextured(const Quad& q, const Texture& tex, int px0, int px1, int py0, int py1);
+    void drawImGui(int by0, int by1);
+    inline uint16_t alpha(float coverage) const
+        { return m_alphaLUT[(coverage <= 0.0f) ? 0 : (coverage >= 1.0f) ? 1024 : int(coverage * 1024.0f + 0.5f)]; }
+    inline const Texture* texture(unsigned texID) const
+        { return (texID && (texID <= m_textures.size())) ? m_textures[texID - 1u] : nullptr; }
+};
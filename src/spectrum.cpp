@@ -0,0 +1,220 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "util.h"
+#include "trace.h"
+#include "spectrum.h"
+
+constexpr size_t ringLength = size_t(SpectrumAnalyzer::RingSize) * 2u;  // in int16 values
+constexpr float pi = 3.14159265358979f;
+constexpr float minFreq = 30.0f;        // lower edge of the lowest band, in Hz
+constexpr float maxFreq = 16000.0f;     // upper edge of the highest band, in Hz
+constexpr float dynamicRange = 72.0f;   // dB range between level 0.0 and 1.0
+constexpr float releaseFactor = 0.85f;  // level decay per analysis step
+constexpr auto updateInterval = std::chrono::milliseconds(15);
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// main thread interface
+
+void SpectrumAnalyzer::start(int sampleRate, int bands) {
+    bands = std::clamp(bands, 1, MaxBands);
+    if (m_thread && (sampleRate == m_sampleRate) && (bands == m_bands)) {
+        m_active = true;
+        return;
+    }
+    stop();
+    m_sampleRate = sampleRate;
+    m_bands = bands;
+
+    // prepare all tables and buffers, so the worker never allocates
+    m_window.assign(size_t(FFTSize) * 2u, 0);
+    m_re.assign(FFTSize, 0.0f);
+    m_im.assign(FFTSize, 0.0f);
+    m_hann.resize(FFTSize);
+    for (int i = 0;  i < FFTSize;  ++i) {
+        m_hann[size_t(i)] = 0.5f - 0.5f * std::cos(2.0f * pi * float(i) / float(FFTSize));
+    }
+    m_cos.resize(FFTSize / 2);
+    m_sin.resize(FFTSize / 2);
+    for (int i = 0;  i < (FFTSize / 2);  ++i) {
+        m_cos[size_t(i)] =  std::cos(2.0f * pi * float(i) / float(FFTSize));
+        m_sin[size_t(i)] = -std::sin(2.0f * pi * float(i) / float(FFTSize));
+    }
+
+    // logarithmically spaced bands, at least one FFT bin wide each
+    float fMax = std::min(maxFreq, float(sampleRate) * 0.5f);
+    float binsPerHz = float(FFTSize) / float(sampleRate);
+    m_bandEdge.resize(size_t(bands) + 1u);
+    for (int i = 0;  i <= bands;  ++i) {
+        float f = minFreq * std::pow(fMax / minFreq, float(i) / float(bands));
+        int bin = int(f * binsPerHz + 0.5f);
+        if (i) { bin = std::max(bin, m_bandEdge[size_t(i) - 1u] + 1); }
+        m_bandEdge[size_t(i)] = std::min(bin, FFTSize / 2);
+    }
+
+    ::memset(static_cast<void*>(m_levels), 0, sizeof(m_levels));
+    m_back = 0;
+    m_middle = 1;
+    m_front = 2;
+    m_haveLevels = false;
+    m_writePos = 0;
+    m_quit = false;
+    m_active = true;
+    m_thread = new std::thread(&SpectrumAnalyzer::run, this);
+}
+
+void SpectrumAnalyzer::stop() {
+    m_active = false;
+    if (!m_thread) { return; }
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_quit = true;
+    }
+    m_wakeup.notify_one();
+    m_thread->join();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+const float* SpectrumAnalyzer::getLevels() {
+    if (m_middle.load(std::memory_order_relaxed) & DirtyFlag) {
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & (DirtyFlag - 1);
+        m_haveLevels = true;
+    }
+    return m_haveLevels ? m_levels[m_front] : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// audio thread interface
+
+void SpectrumAnalyzer::push(const int16_t* data, int sampleCount, bool stereo) {
+    if (!m_active.load(std::memory_order_relaxed) || (sampleCount <= 0)) { return; }
+    int channels = stereo ? 2 : 1;
+    m_channels.store(channels, std::memory_order_relaxed);
+    size_t count = size_t(sampleCount) * size_t(channels);
+    uint64_t pos = m_writePos.load(std::memory_order_relaxed);
+    if (count > ringLength) {
+        // only the most recent part fits into the ring anyway
+        data += count - ringLength;
+        pos += count - ringLength;
+        count = ringLength;
+    }
+    while (count) {
+        size_t offset = size_t(pos % ringLength);
+        size_t n = std::min(count, ringLength - offset);
+        ::memcpy(static_cast<void*>(&m_ring[offset]), static_cast<const void*>(data), n * sizeof(int16_t));
+        data += n;
+        pos += n;
+        count -= n;
+    }
+    m_writePos.store(pos, std::memory_order_release);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// worker thread
+
+void SpectrumAnalyzer::run() {
+    Trace::setThreadName("spectrum");
+    uint64_t lastPos = 0;
+    std::vector<float> smooth(size_t(m_bands), 0.0f);
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_wakeup.wait_for(lock, updateInterval, [this] { return m_quit.load(); });
+        }
+        if (m_quit) { return; }
+        uint64_t pos = m_writePos.load(std::memory_order_acquire);
+        if (pos == lastPos) { continue; }  // no new audio
+        lastPos = pos;
+        if (!takeWindow()) { continue; }
+        TRACE_SCOPE("spectrum");
+        fft();
+        float* levels = m_levels[m_back];
+        computeLevels(levels);
+        for (int i = 0;  i < m_bands;  ++i) {
+            smooth[size_t(i)] = levels[i] = std::max(levels[i], smooth[size_t(i)] * releaseFactor);
+        }
+        m_back = m_middle.exchange(m_back | DirtyFlag, std::memory_order_acq_rel) & (DirtyFlag - 1);
+    }
+}
+
+bool SpectrumAnalyzer::takeWindow() {
+    // copy the most recent window out of the ring buffer; if the audio
+    // thread overwrote parts of it while we were copying, try again later
+    int channels = m_channels.load(std::memory_order_relaxed);
+    size_t count = size_t(FFTSize) * size_t(channels);
+    uint64_t end = m_writePos.load(std::memory_order_acquire);
+    if (end < count) { return false; }
+    uint64_t start = end - count;
+    for (size_t done = 0u;  done < count;) {
+        size_t offset = size_t((start + done) % ringLength);
+        size_t n = std::min(count - done, ringLength - offset);
+        ::memcpy(static_cast<void*>(&m_window[done]), static_cast<const void*>(&m_ring[offset]), n * sizeof(int16_t));
+        done += n;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if ((m_writePos.load(std::memory_order_relaxed) - start) > ringLength) { return false; }
+
+    // mix down to mono and apply the window function
+    constexpr float scale = 1.0f / 32768.0f;
+    for (int i = 0;  i < FFTSize;  ++i) {
+        float v = (channels > 1) ? (0.5f * (float(m_window[size_t(i) * 2u]) + float(m_window[size_t(i) * 2u + 1u])))
+                                 : float(m_window[size_t(i)]);
+        m_re[size_t(i)] = v * scale * m_hann[size_t(i)];
+        m_im[size_t(i)] = 0.0f;
+    }
+    return true;
+}
+
+void SpectrumAnalyzer::fft() {
+    // plain iterative radix-2 decimation-in-time FFT
+    float* re = m_re.data();
+    float* im = m_im.data();
+    for (int i = 1, j = 0;  i < FFTSize;  ++i) {
+        int bit = FFTSize >> 1;
+        for (;  j & bit;  bit >>= 1) { j ^= bit; }
+        j ^= bit;
+        if (i < j) { std::swap(re[i], re[j]);  std::swap(im[i], im[j]); }
+    }
+    for (int len = 2;  len <= FFTSize;  len <<= 1) {
+        int half = len >> 1, step = FFTSize / len;
+        for (int i = 0;  i < FFTSize;  i += len) {
+            for (int k = 0;  k < half;  ++k) {
+                float wr = m_cos[size_t(k * step)], wi = m_sin[size_t(k * step)];
+                int a = i + k, b = a + half;
+                float xr = re[b] * wr - im[b] * wi;
+                float xi = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - xr;  im[b] = im[a] - xi;
+                re[a] += xr;         im[a] += xi;
+            }
+        }
+    }
+}
+
+void SpectrumAnalyzer::computeLevels(float* levels) {
+    // a full-scale sine wave shall result in 0 dB (the Hann window's
+    // coherent gain is 0.5, and only half of the energy is in the positive
+    // frequency half of the spectrum)
+    constexpr float norm = 4.0f / float(FFTSize);
+    for (int band = 0;  band < m_bands;  ++band) {
+        float peak = 0.0f;
+        for (int bin = m_bandEdge[size_t(band)];  bin < m_bandEdge[size_t(band) + 1u];  ++bin) {
+            peak = std::max(peak, m_re[size_t(bin)] * m_re[size_t(bin)] + m_im[size_t(bin)] * m_im[size_t(bin)]);
+        }
+        float dB = 10.0f * std::log10(std::max(peak * norm * norm, 1e-12f));
+        levels[band] = std::clamp((dB + dynamicRange) / dynamicRange, 0.0f, 1.0f);
+    }
+}
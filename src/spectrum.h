@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+//! Spectrum analyzer for the actual audio output.
+//!
+//! The audio thread copies each rendered buffer into a lock-free ring
+//! buffer with push(); a worker thread periodically takes the most recent
+//! window out of that ring, runs an FFT on it, and publishes the levels of
+//! logarithmically spaced frequency bands through a lock-free triple buffer,
+//! from which the main thread fetches them with getLevels().
+class SpectrumAnalyzer {
+public:
+    static constexpr int FFTSize = 2048;   //!< FFT window size, in sample frames
+    static constexpr int MaxBands = 256;   //!< maximum number of frequency bands
+    static constexpr int RingSize = 8192;  //!< ring buffer size, in sample frames (must be a power of two)
+
+    inline SpectrumAnalyzer() {}
+    inline ~SpectrumAnalyzer() { stop(); }
+
+    //! start the worker thread (if not running yet) and accept audio data
+    void start(int sampleRate, int bands);
+    //! stop accepting audio data and stop the worker thread
+    void stop();
+    inline bool active() const { return m_active.load(std::memory_order_relaxed); }
+
+    //! copy audio data into the ring buffer (audio thread only);
+    //! does nothing if the analyzer isn't active
+    void push(const int16_t* data, int sampleCount, bool stereo);
+
+    //! get the most recent band levels (0.0 ... 1.0) (main thread only)
+    //! \returns pointer to the levels, or nullptr if there are none yet
+    const float* getLevels();
+    //! number of bands in the arrays returned by getLevels()
+    inline int bands() const { return m_bands; }
+
+private:
+    // ring buffer (written by the audio thread, read by the worker)
+    int16_t m_ring[RingSize * 2];
+    std::atomic<uint64_t> m_writePos { 0 };  //!< total number of int16 values written
+    std::atomic<int> m_channels { 2 };
+    std::atomic<bool> m_active { false };
+
+    // worker thread state
+    std::thread* m_thread = nullptr;
+    std::mutex m_lock;  //!< only used for the worker's sleep/wakeup
+    std::condition_variable m_wakeup;
+    std::atomic<bool> m_quit { false };
+    int m_sampleRate = 48000;
+    int m_bands = 0;
+    std::vector<int16_t> m_window;    //!< snapshot of the ring buffer
+    std::vector<float> m_re, m_im;    //!< FFT work buffers
+    std::vector<float> m_hann;        //!< window function
+    std::vector<float> m_cos, m_sin;  //!< FFT twiddle factors
+    std::vector<int> m_bandEdge;      //!< first FFT bin of each band (plus end marker)
+
+    // triple buffer for the results
+    float m_levels[3][MaxBands];
+    static constexpr int DirtyFlag = 4;
+    std::atomic<int> m_middle { 1 };  //!< buffer index handed over between threads, plus DirtyFlag
+    int m_back = 0;                   //!< worker's buffer index
+    int m_front = 2;                  //!< main thread's buffer index
+    bool m_haveLevels = false;
+
+    void run();
+    bool takeWindow();
+    void fft();
+    void computeLevels(float* levels);
+};
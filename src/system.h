@@ -14,6 +14,7 @@
 #include <functional>
 
 struct SystemInterfacePrivateData;
+class SoftwareRasterizer;
 
 class SystemInterface {
     SystemInterfacePrivateData* m_priv;
@@ -24,7 +25,9 @@ public:
     [[noreturn]] void fatalError(const char* what, const char* how);
 
     void initSystem();
-    void initVideo(const char* title, bool fullscreen=DEFAULT_FULLSCREEN, int windowWidth=1920, int windowHeight=1080);
+    //! create the window; falls back to software rendering (or uses it
+    //! right away, if requested) if OpenGL 3.3 isn't available
+    void initVideo(const char* title, bool fullscreen=DEFAULT_FULLSCREEN, int windowWidth=1920, int windowHeight=1080, bool software=false);
     int initAudio(bool stereo, int sampleRate=48000, int bufferSize=512);
 
     void lockAudioMutex();
@@ -37,6 +40,11 @@ public:
     inline bool play()        { return setPaused(false); }
     inline bool togglePause() { return setPaused(!isPaused()); }
 
+    //! whether there's no real window and audio device (i.e. the headless test program)
+    bool headless();
+    //! the CPU rasterizer that's used instead of OpenGL, if any
+    SoftwareRasterizer* softwareRasterizer();
+
     inline void quit() { m_active = false; }
     inline bool active() { return m_active; }
 
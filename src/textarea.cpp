@@ -55,6 +55,17 @@ float TextArea::width() const {
     return w;
 }
 
+size_t TextArea::memoryUsage() const {
+    size_t bytes = lines.capacity() * sizeof(TextLine*);
+    for (const auto& line : lines) {
+        bytes += sizeof(TextLine) + line->spans.capacity() * sizeof(TextSpan);
+        for (const auto& span : line->spans) {
+            bytes += span.text.capacity();
+        }
+    }
+    return bytes;
+}
+
 float TextArea::height() const {
     if (lines.empty()) { return 0.0f; }
     float h = -lines[0]->marginTop;
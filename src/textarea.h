@@ -46,6 +46,8 @@ struct TextArea {
     float height() const;
     void draw(float x, float y);
     inline bool empty() const { return lines.empty(); }
+    //! estimated heap memory used by the text area's content, in bytes
+    size_t memoryUsage() const;
 
     TextLine& addLine(float size, uint32_t lineDefaultColor, const char* initialText=nullptr);
     inline TextLine& addLine(float size) { return addLine(size, defaultColor, nullptr); }
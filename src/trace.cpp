@@ -0,0 +1,250 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#define _CRT_SECURE_NO_WARNINGS  // disable nonsense MSVC warnings
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "util.h"
+#include "trace.h"
+
+namespace Trace {
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// internal data structures
+
+//! number of events per thread ring buffer (must be a power of two);
+//! at 24 bytes per event, that's 24 MiB per thread, good for about half
+//! an hour of continuous recording on the main thread
+constexpr uint32_t BufferCapacity = 1u << 20;
+
+//! duration value that marks an instant event
+constexpr uint64_t InstantEvent = ~uint64_t(0);
+
+struct Event {
+    const char* name;
+    uint64_t start;
+    uint64_t duration;
+};
+
+struct ThreadBuffer {
+    uint32_t tid = 0;
+    const char* name = nullptr;
+    std::atomic<uint64_t> count { 0 };  //!< total number of events ever written
+    Event events[BufferCapacity];
+};
+
+//! events of a thread that has exited, compacted into a right-sized array
+struct ExitedThread {
+    uint32_t tid;
+    const char* name;
+    uint64_t lost;  //!< number of events lost due to buffer overflow
+    std::vector<Event> events;
+};
+
+std::atomic<bool> g_enabled { false };
+static std::mutex g_lock;  // protects everything below, *not* the buffer contents
+static std::vector<ThreadBuffer*> g_buffers;      //!< all buffers ever created
+static std::vector<ThreadBuffer*> g_freeBuffers;  //!< empty buffers of threads that have exited
+static std::vector<ExitedThread> g_exited;
+static std::atomic<ThreadBuffer*> g_reserved { nullptr };  //!< buffer reserved with reserveBuffer()
+static uint32_t g_nextTid = 0;
+static std::string g_filename;
+static std::chrono::steady_clock::time_point g_t0;
+static std::atomic<uint32_t> g_generation { 0 };
+
+//! per-thread reference to the thread's buffer; when the thread exits, its
+//! events are moved out of the buffer, and the (large) buffer itself is
+//! reused by the next new thread, so short-lived threads (like the loudness
+//! scanner) don't allocate a new buffer every time
+struct BufferHolder {
+    ThreadBuffer* buffer = nullptr;
+    uint32_t generation = 0;
+    ~BufferHolder() {
+        std::lock_guard<std::mutex> lock(g_lock);
+        if (!buffer || (generation != g_generation)) { return; }  // (buffer has been deleted by shutdown())
+        uint64_t end = buffer->count.load(std::memory_order_acquire);
+        uint64_t begin = (end > BufferCapacity) ? (end - BufferCapacity) : 0u;
+        ExitedThread t { buffer->tid, buffer->name, begin, {} };
+        t.events.reserve(size_t(end - begin));
+        for (uint64_t i = begin;  i < end;  ++i) { t.events.push_back(buffer->events[i & (BufferCapacity - 1u)]); }
+        g_exited.push_back(std::move(t));
+        buffer->count.store(0u);
+        buffer->name = nullptr;
+        g_freeBuffers.push_back(buffer);
+    }
+};
+static thread_local BufferHolder t_holder;
+
+//! create a new buffer or reuse a free one (g_lock must be held)
+static ThreadBuffer* allocBuffer() {
+    ThreadBuffer* buf;
+    if (!g_freeBuffers.empty()) {
+        buf = g_freeBuffers.back();
+        g_freeBuffers.pop_back();
+    } else {
+        buf = new ThreadBuffer;
+        g_buffers.push_back(buf);
+    }
+    buf->tid = ++g_nextTid;
+    return buf;
+}
+
+//! get (and, on first use, create) the calling thread's buffer
+static ThreadBuffer* getBuffer() {
+    if (t_holder.buffer && (t_holder.generation == g_generation)) {
+        return t_holder.buffer;
+    }
+    std::lock_guard<std::mutex> lock(g_lock);
+    t_holder.buffer = allocBuffer();
+    t_holder.generation = g_generation;
+    return t_holder.buffer;
+}
+
+static void addEvent(const char* name, uint64_t start, uint64_t duration) {
+    ThreadBuffer* buf = getBuffer();
+    uint64_t index = buf->count.load(std::memory_order_relaxed);
+    Event& ev = buf->events[index & (BufferCapacity - 1u)];
+    ev.name = name;
+    ev.start = start;
+    ev.duration = duration;
+    buf->count.store(index + 1u, std::memory_order_release);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// public API
+
+bool init(const char* filename) {
+    if (!filename || !filename[0]) { return false; }
+    std::lock_guard<std::mutex> lock(g_lock);
+    g_filename.assign(filename);
+    g_t0 = std::chrono::steady_clock::now();
+    ++g_generation;
+    g_enabled.store(true);
+    Dprintf("tracing into '%s'\n", filename);
+    return true;
+}
+
+uint64_t now() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_t0).count());
+}
+
+void reserveBuffer(const char* threadName) {
+    if (!enabled()) { return; }
+    std::lock_guard<std::mutex> lock(g_lock);
+    ThreadBuffer* buf = allocBuffer();
+    buf->name = threadName;
+    buf = g_reserved.exchange(buf);
+    if (buf) { buf->name = nullptr;  g_freeBuffers.push_back(buf); }  // unused previous reservation
+}
+
+void setThreadName(const char* name) {
+    if (!enabled()) { return; }
+    if (!t_holder.buffer || (t_holder.generation != g_generation)) {
+        // first event of this thread -> take the reserved buffer, if it's
+        // meant for this thread; this doesn't need the lock
+        ThreadBuffer* buf = g_reserved.load(std::memory_order_acquire);
+        if (buf && !strcmp(buf->name, name) && g_reserved.compare_exchange_strong(buf, nullptr)) {
+            t_holder.buffer = buf;
+            t_holder.generation = g_generation;
+            return;
+        }
+    }
+    getBuffer()->name = name;
+}
+
+void complete(const char* name, uint64_t start, uint64_t end) {
+    if (!enabled()) { return; }
+    addEvent(name, start, (end > start) ? (end - start) : 0u);
+}
+
+void instant(const char* name) {
+    if (!enabled()) { return; }
+    addEvent(name, now(), InstantEvent);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+///// JSON output
+
+static void writeString(FILE* f, const char* s) {
+    fputc('"', f);
+    for (;  *s;  ++s) {
+        if ((*s == '"') || (*s == '\\')) { fputc('\\', f); fputc(*s, f); }
+        else if (uint8_t(*s) < 32u) { fprintf(f, "\\u%04x", unsigned(uint8_t(*s))); }
+        else { fputc(*s, f); }
+    }
+    fputc('"', f);
+}
+
+static void writeEvents(FILE* f, uint32_t tid, const char* name, const Event* events, size_t count) {
+    if (name) {
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", tid);
+        writeString(f, name);
+        fputs("}}", f);
+    }
+    for (size_t i = 0u;  i < count;  ++i) {
+        const Event& ev = events[i];
+        fputs(",\n{\"name\":", f);
+        writeString(f, ev.name);
+        if (ev.duration == InstantEvent) {
+            fprintf(f, ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f", double(ev.start) * 1E-3);
+        } else {
+            fprintf(f, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f", double(ev.start) * 1E-3, double(ev.duration) * 1E-3);
+        }
+        fprintf(f, ",\"pid\":1,\"tid\":%u}", tid);
+    }
+}
+
+bool shutdown() {
+    if (!g_enabled.exchange(false)) { return false; }
+    std::lock_guard<std::mutex> lock(g_lock);
+    FILE* f = fopen(g_filename.c_str(), "w");
+    if (!f) {
+        Dprintf("could not write trace file '%s'\n", g_filename.c_str());
+    } else {
+        fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+        fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"TrackMeister\"}}", f);
+        for (const auto& t : g_exited) {
+            if (t.lost) { Dprintf("trace buffer of thread %u overflowed, %llu oldest events lost\n", t.tid, (unsigned long long)t.lost); }
+            writeEvents(f, t.tid, t.name, t.events.data(), t.events.size());
+        }
+        for (const auto* buf : g_buffers) {
+            // the buffers of running threads; they're written in two parts,
+            // because they may have wrapped around
+            uint64_t end = buf->count.load(std::memory_order_acquire);
+            if (!end) { continue; }  // free, or reserved but never used
+            uint64_t begin = (end > BufferCapacity) ? (end - BufferCapacity) : 0u;
+            if (begin) {
+                Dprintf("trace buffer of thread %u overflowed, %llu oldest events lost\n", buf->tid, (unsigned long long)begin);
+            }
+            size_t first = size_t(begin & (BufferCapacity - 1u));
+            size_t total = size_t(end - begin);
+            size_t part = std::min(total, size_t(BufferCapacity) - first);
+            writeEvents(f, buf->tid, buf->name, &buf->events[first], part);
+            writeEvents(f, buf->tid, nullptr, &buf->events[0], total - part);
+        }
+        fputs("\n]}\n", f);
+        fclose(f);
+    }
+    for (auto* buf : g_buffers) { delete buf; }
+    g_buffers.clear();
+    g_freeBuffers.clear();
+    g_exited.clear();
+    g_reserved = nullptr;
+    ++g_generation;  // so threads that exit later don't touch their deleted buffers
+    return !!f;
+}
+
+}  // namespace Trace
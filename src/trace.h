@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2023 Martin J. Fiedler <keyj@emphy.de>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+
+#include <atomic>
+
+//! Lightweight timeline tracing.
+//!
+//! Every thread that records events gets its own fixed-size ring buffer,
+//! so recording never takes a lock and never allocates (except for the
+//! one-time buffer setup on a thread's first event). For threads that must
+//! not even do that, like the audio thread, a buffer can be reserved in
+//! advance with reserveBuffer(). If a buffer overflows, the oldest events of
+//! that thread are overwritten. When a thread exits, its events are kept,
+//! and its buffer is reused for the next new thread, under a new thread ID.
+//! All buffers are written into a Chrome trace-event JSON file when tracing
+//! is shut down; at that point, no other thread may record events anymore.
+namespace Trace {
+
+//! whether tracing is currently active (don't use directly; use enabled())
+extern std::atomic<bool> g_enabled;
+
+//! check whether tracing is currently active
+inline bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+//! start tracing; the events will be written into the specified file
+//! when shutdown() is called
+//! \returns false if tracing is disabled (filename is null or empty)
+bool init(const char* filename);
+
+//! stop tracing and write all recorded events into the output file
+//! \note All threads except the calling one must have stopped recording
+//!       events by now (e.g. by closing the audio device first).
+//! \returns false if the output file could not be written
+bool shutdown();
+
+//! get the current timestamp in nanoseconds since tracing has been started
+uint64_t now();
+
+//! set up a buffer in advance for a thread that is yet to be started; the
+//! first thread that calls setThreadName() with the same name gets it,
+//! without taking a lock or allocating anything
+//! \note The name must be a string literal or otherwise have static lifetime.
+void reserveBuffer(const char* threadName);
+
+//! set the name of the calling thread, as shown in the timeline viewer
+//! \note The name must be a string literal or otherwise have static lifetime.
+void setThreadName(const char* name);
+
+//! record a "complete" event (i.e. a time span) on the calling thread
+//! \note The name must be a string literal or otherwise have static lifetime.
+void complete(const char* name, uint64_t start, uint64_t end);
+
+//! record an instant event on the calling thread
+//! \note The name must be a string literal or otherwise have static lifetime.
+void instant(const char* name);
+
+//! RAII helper that records a complete event for the lifetime of the object
+class Scope {
+    const char* m_name;
+    uint64_t m_start;
+public:
+    inline explicit Scope(const char* name)
+        : m_name(enabled() ? name : nullptr), m_start(m_name ? now() : 0u) {}
+    inline ~Scope() { if (m_name) { complete(m_name, m_start, now()); } }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+
+}  // namespace Trace
+
+#define TRACE_CONCAT_(a, b) a ## b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+//! record a complete event named 'name' for the rest of the enclosing scope
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope_, __LINE__)(name)